@@ -0,0 +1,254 @@
+/// @file benchBus.cpp
+/// This file contains benchmarks for the EventBus api
+/// It is implemented using constructs from C++14 standard.
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "../eventFramework/eventFrameWork.h"
+
+namespace benchBus
+{
+	/// calls queued before the bus is drained, fits the capacity of the bus
+	const int g_enqueueBatch = 4096;
+
+	/// @brief run the bus until all queued calls are dispatched
+	static void drain(eventHandling::EventBus & eventBus)
+	{
+		eventBus.reset();
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		while (eventBus.getCallsCount() > 0)
+		{
+			std::this_thread::yield();
+		}
+		eventBus.stop();
+		busThread.join();
+	}
+
+	/// @brief add state.range(0) callbacks to one id of a new bus
+	/// @details every add() publishes a new subscriber snapshot, so the cost
+	///          per callback grows with the number of subscribers
+	static void addCallbacks(benchmark::State & state)
+	{
+		const int callbackCount = static_cast<int>(state.range(0));
+		std::function<void(int)> callback = [](int i) { benchmark::DoNotOptimize(i); };
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			std::unique_ptr<eventHandling::EventBus> eventBusPtr(new eventHandling::EventBus);
+			eventHandling::TopicId addTopic = eventBusPtr->topic("add");
+			state.ResumeTiming();
+			for (int i = 0; i < callbackCount; ++i)
+			{
+				benchmark::DoNotOptimize(eventBusPtr->add(addTopic, callback));
+			}
+			state.PauseTiming();
+			eventBusPtr.reset();
+			state.ResumeTiming();
+		}
+		state.SetItemsProcessed(state.iterations() * callbackCount);
+	}
+
+	BENCHMARK(addCallbacks)->Arg(1)->Arg(16)->Arg(256);
+
+	/// @brief queueing cost of the string api invokeEvent(), no worker running
+	static void invokeEventEnqueue(benchmark::State & state)
+	{
+		eventHandling::EventBus eventBus(g_enqueueBatch);
+		std::function<void(std::string)> callback = [](std::string s) {
+			benchmark::DoNotOptimize(s.data()); };
+		eventBus.add("enqueue", callback);
+		eventBus.setLatencySampling("enqueue", 0);
+		const std::string argument("argument");
+		int queued = 0;
+		for (auto _ : state)
+		{
+			if (queued == g_enqueueBatch)
+			{
+				state.PauseTiming();
+				drain(eventBus);
+				queued = 0;
+				state.ResumeTiming();
+			}
+			benchmark::DoNotOptimize(eventBus.invokeEvent("enqueue", argument));
+			++queued;
+		}
+		drain(eventBus);
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeEventEnqueue);
+
+	/// @brief producer threads invoking one unordered id, two workers dispatch
+	/// @details producers wait for space with OverflowPolicy::block, so the
+	///          result is the throughput of the whole bus under contention
+	static void invokeContention(benchmark::State & state)
+	{
+		static eventHandling::EventBus * s_eventBusPtr = nullptr;
+		static std::thread * s_busThreadPtr = nullptr;
+		static eventHandling::TopicId s_topic;
+		if (state.thread_index() == 0)
+		{
+			s_eventBusPtr = new eventHandling::EventBus(g_enqueueBatch, 2);
+			s_topic = s_eventBusPtr->topic("contention");
+			s_eventBusPtr->add(s_topic, [](int i) { benchmark::DoNotOptimize(i); });
+			s_eventBusPtr->setOrdered(s_topic, false);
+			s_eventBusPtr->setOverflowPolicy(eventHandling::OverflowPolicy::block,
+				std::chrono::milliseconds(1000));
+			s_busThreadPtr = new std::thread(&eventHandling::EventBus::run, s_eventBusPtr);
+		}
+		// the loop starts once every thread arrived, the bus is ready then
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(s_eventBusPtr->invoke(s_topic, 1));
+		}
+		if (state.thread_index() == 0)
+		{
+			while (s_eventBusPtr->getCallsCount() > 0)
+			{
+				std::this_thread::yield();
+			}
+			s_eventBusPtr->stop();
+			s_busThreadPtr->join();
+			delete s_busThreadPtr;
+			delete s_eventBusPtr;
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeContention)->ThreadRange(1, 8)->UseRealTime();
+
+#ifndef _WIN32
+	/// @brief round trip of a call published from another process
+	/// @details The forked child runs a bus with attachShmTransport(), its
+	///          callback publishes the reply into a ring this process reads.
+	///          state.range(0) is the WaitStrategy of both sides, the one way
+	///          latency is about half the time per iteration.
+	static void shmRoundTrip(benchmark::State & state)
+	{
+		const std::string requestName("benchShmRequest"), replyName("benchShmReply");
+		const eventHandling::WaitStrategy strategy =
+			static_cast<eventHandling::WaitStrategy>(state.range(0));
+		// neither side waits longer for the other one
+		const auto timeout = std::chrono::seconds(2);
+		eventHandling::ShmRing replyRing;
+		if (!replyRing.create(replyName, 1 << 16))
+		{
+			state.SkipWithError("no shared memory");
+			return;
+		}
+		eventHandling::ShmRing::remove(requestName);
+		const pid_t parent = getpid();
+		const pid_t child = fork();
+		if (child < 0)
+		{
+			state.SkipWithError("fork failed");
+			return;
+		}
+		if (child == 0)
+		{
+			eventHandling::ShmPublisher replyPublisher;
+			if (!replyPublisher.open(replyName))
+			{
+				_exit(1);
+			}
+			std::atomic<bool> stopping(false);
+			eventHandling::EventBus eventBus(1024, 1);
+			eventBus.add("ping", [&replyPublisher, &stopping, timeout](std::string text) {
+				const auto deadline = std::chrono::steady_clock::now() + timeout;
+				while (!replyPublisher.publish("pong", text))
+				{
+					if (std::chrono::steady_clock::now() > deadline)
+					{
+						stopping = true;
+						return;
+					}
+					std::this_thread::yield();
+				}
+			});
+			eventBus.add("stop", [&stopping]() { stopping = true; });
+			eventBus.setWaitStrategy(strategy);
+			if (!eventBus.attachShmTransport(requestName, 1 << 16))
+			{
+				_exit(1);
+			}
+			eventBus.start();
+			// an orphaned child stops on its own
+			while (!stopping && getppid() == parent)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			eventBus.shutdown(std::chrono::milliseconds(100));
+			_exit(0);
+		}
+		// waits for the child to exit, kills it after timeout
+		auto reapChild = [child, timeout]() {
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			int status = 0;
+			while (waitpid(child, &status, WNOHANG) == 0)
+			{
+				if (std::chrono::steady_clock::now() > deadline)
+				{
+					kill(child, SIGKILL);
+					waitpid(child, &status, 0);
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		};
+		eventHandling::ShmPublisher publisher;
+		const auto openDeadline = std::chrono::steady_clock::now() + timeout;
+		while (!publisher.open(requestName))
+		{
+			if (std::chrono::steady_clock::now() > openDeadline)
+			{
+				kill(child, SIGKILL);
+				reapChild();
+				state.SkipWithError("no request ring");
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		const std::string text(32, 'x');
+		auto onFrame = [](const eventHandling::ShmFrameView & frame) {
+			benchmark::DoNotOptimize(frame.m_argumentPtr); };
+		for (auto _ : state)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			bool replied = false;
+			while (!publisher.publish("ping", text) && std::chrono::steady_clock::now() < deadline)
+			{
+				std::this_thread::yield();
+			}
+			while (!(replied = replyRing.consume(onFrame, 1) != 0) &&
+				std::chrono::steady_clock::now() < deadline)
+			{
+				replyRing.waitForFrame(std::chrono::milliseconds(100), eventHandling::g_defaultSpinCount,
+					strategy != eventHandling::WaitStrategy::busySpin);
+			}
+			if (!replied)
+			{
+				state.SkipWithError("no reply");
+				break;
+			}
+		}
+		publisher.publish("stop");
+		reapChild();
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(shmRoundTrip)->Arg(static_cast<int>(eventHandling::WaitStrategy::spinYield))
+		->Arg(static_cast<int>(eventHandling::WaitStrategy::spinPark))->UseRealTime();
+#endif
+}//namespace
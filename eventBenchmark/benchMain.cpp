@@ -0,0 +1,36 @@
+/// @file benchMain.cpp
+/// This file contains the runner for the Event system benchmarks
+/// It is implemented using constructs from C++14 standard.
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+/// @brief BENCHMARK_MAIN() printing JSON unless --benchmark_format is given
+/// @details the JSON output can be stored and compared between builds, e.g.
+///          with tools/compare.py of Google Benchmark
+int main(int argc, char ** argv)
+{
+	std::vector<char *> arguments(argv, argv + argc);
+	bool formatGiven = false;
+	for (char * argumentPtr : arguments)
+	{
+		formatGiven = formatGiven ||
+			std::strncmp(argumentPtr, "--benchmark_format", 18) == 0;
+	}
+	char jsonFormat[] = "--benchmark_format=json";
+	if (!formatGiven)
+	{
+		arguments.push_back(jsonFormat);
+	}
+	int argumentCount = static_cast<int>(arguments.size());
+	arguments.push_back(nullptr);
+	benchmark::Initialize(&argumentCount, arguments.data());
+	if (benchmark::ReportUnrecognizedArguments(argumentCount, arguments.data()))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
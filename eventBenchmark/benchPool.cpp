@@ -0,0 +1,466 @@
+/// @file benchPool.cpp
+/// This file contains benchmarks for the EventBus dispatch workers
+/// It is implemented using constructs from C++14 standard.
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../eventFramework/eventFrameWork.h"
+
+namespace benchPool
+{
+	const int g_topicCount = 16;
+	const int g_callsPerTopic = 256;
+
+	/// @brief cpu bound callback of roughly a microsecond
+	static void spinFor(std::chrono::nanoseconds duration)
+	{
+		auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end)
+		{
+		}
+	}
+
+	/// @brief independent callback ids dispatched by state.range(0) workers
+	static void dispatchIndependentTopics(benchmark::State & state)
+	{
+		const int workerCount = static_cast<int>(state.range(0));
+		const int totalCalls = g_topicCount * g_callsPerTopic;
+		eventHandling::EventBus eventBus(totalCalls, workerCount);
+		std::atomic<int> dispatched(0);
+		std::function<void(std::string)> work = [&dispatched](std::string) {
+			spinFor(std::chrono::microseconds(1));
+			++dispatched;
+		};
+		std::vector<std::string> topics;
+		for (int i = 0; i < g_topicCount; ++i)
+		{
+			topics.push_back("topic" + std::to_string(i));
+			eventBus.add(topics.back(), work);
+		}
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		const std::string payload("payload");
+		for (auto _ : state)
+		{
+			dispatched = 0;
+			for (int call = 0; call < g_callsPerTopic; ++call)
+			{
+				for (auto & topic : topics)
+				{
+					while (!eventBus.invokeEvent(topic, payload))
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+			while (dispatched.load() < totalCalls)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetItemsProcessed(state.iterations() * totalCalls);
+		double steals = 0;
+		for (auto & stats : eventBus.getWorkerStats())
+		{
+			steals += static_cast<double>(stats.m_stealCount);
+		}
+		state.counters["steals"] = benchmark::Counter(steals, benchmark::Counter::kAvgIterations);
+	}
+
+	BENCHMARK(dispatchIndependentTopics)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+	/// @brief invoke cost by name (0) or by interned TopicId (1), one worker
+	static void invokeByTopic(benchmark::State & state)
+	{
+		const bool useTopicId = state.range(0) != 0;
+		eventHandling::EventBus eventBus(g_callsPerTopic * g_topicCount);
+		std::atomic<int> dispatched(0);
+		std::function<void(int)> count = [&dispatched](int) { ++dispatched; };
+		std::vector<std::string> names;
+		std::vector<eventHandling::TopicId> topics;
+		for (int i = 0; i < g_topicCount; ++i)
+		{
+			names.push_back("topic" + std::to_string(i));
+			topics.push_back(eventBus.topic(names.back()));
+			eventBus.add(topics.back(), count);
+		}
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (auto _ : state)
+		{
+			dispatched = 0;
+			for (int i = 0; i < g_topicCount; ++i)
+			{
+				bool queued = useTopicId ? eventBus.invoke(topics[i], i)
+					: eventBus.invoke(names[i], i);
+				benchmark::DoNotOptimize(queued);
+			}
+			while (dispatched.load() < g_topicCount)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetItemsProcessed(state.iterations() * g_topicCount);
+	}
+
+	BENCHMARK(invokeByTopic)->Arg(0)->Arg(1)->UseRealTime();
+
+	/// @brief 4KB payload to 8 subscribers, copied (0) or shared (1)
+	static void fanOutPayload(benchmark::State & state)
+	{
+		const bool shared = state.range(0) != 0;
+		const int subscribers = 8;
+		eventHandling::EventBus eventBus;
+		std::atomic<int> dispatched(0);
+		std::function<void(std::string)> byValue = [&dispatched](std::string s) {
+			benchmark::DoNotOptimize(s.data());
+			++dispatched;
+		};
+		std::function<void(const std::string&)> byView = [&dispatched](const std::string & s) {
+			benchmark::DoNotOptimize(s.data());
+			++dispatched;
+		};
+		eventHandling::TopicId fanOutTopic = eventBus.topic("fanOut");
+		for (int i = 0; i < subscribers; ++i)
+		{
+			if (shared)
+			{
+				eventBus.addShared(fanOutTopic, byView);
+			}
+			else
+			{
+				eventBus.add(fanOutTopic, byValue);
+			}
+		}
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		const std::string payload(4096, 'x');
+		for (auto _ : state)
+		{
+			dispatched = 0;
+			bool queued = shared ? eventBus.invokeShared(fanOutTopic, payload)
+				: eventBus.invoke(fanOutTopic, payload);
+			benchmark::DoNotOptimize(queued);
+			while (dispatched.load() < subscribers)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetBytesProcessed(state.iterations() * subscribers *
+			static_cast<int64_t>(payload.size()));
+	}
+
+	BENCHMARK(fanOutPayload)->Arg(0)->Arg(1)->UseRealTime();
+
+	/// @brief state.range(0) calls queued one by one (0) or with invokeBatch (1)
+	static void invokeBatchSize(benchmark::State & state)
+	{
+		const int batchSize = static_cast<int>(state.range(0));
+		const bool batched = state.range(1) != 0;
+		eventHandling::EventBus eventBus(2 * batchSize);
+		std::atomic<int> dispatched(0);
+		std::function<void(int)> count = [&dispatched](int) { ++dispatched; };
+		eventHandling::TopicId batchTopic = eventBus.topic("batch");
+		eventBus.add(batchTopic, count);
+		std::vector<int> arguments(batchSize, 1);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (auto _ : state)
+		{
+			dispatched = 0;
+			if (batched)
+			{
+				benchmark::DoNotOptimize(eventBus.invokeBatch(batchTopic, arguments));
+			}
+			else
+			{
+				for (int argument : arguments)
+				{
+					benchmark::DoNotOptimize(eventBus.invoke(batchTopic, argument));
+				}
+			}
+			while (dispatched.load() < batchSize)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetItemsProcessed(state.iterations() * batchSize);
+	}
+
+	BENCHMARK(invokeBatchSize)->ArgsProduct({ { 1, 16, 256, 4096 }, { 0, 1 } })->UseRealTime();
+
+	/// @brief one dispatch to state.range(0) subscribers of a topic, no bus threads
+	/// @details callbacks are a std::function (0) or a lambda stored in place (1)
+	static void fanOutSubscribers(benchmark::State & state)
+	{
+		const int subscribers = static_cast<int>(state.range(0));
+		const bool inPlace = state.range(1) != 0;
+		eventHandling::EventHandler eventHandler("fanOut");
+		int64_t sum = 0;
+		std::function<void(int)> accumulate = [&sum](int i) { sum += i; };
+		for (int i = 0; i < subscribers; ++i)
+		{
+			std::shared_ptr<eventHandling::Event<int>> eventPtr(
+				new eventHandling::Event<int>("fanOut"));
+			if (inPlace)
+			{
+				eventPtr->setCallable<int>([&sum](int i) { sum += i; });
+			}
+			else
+			{
+				eventPtr->setCallback(accumulate);
+			}
+			eventHandler.addEvent(eventPtr);
+		}
+		std::tuple<int> arguments(1);
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(eventHandler.dispatchCalls(arguments));
+		}
+		benchmark::DoNotOptimize(sum);
+		state.SetItemsProcessed(state.iterations() * subscribers);
+		state.counters["ns/subscriber"] = benchmark::Counter(
+			static_cast<double>(state.iterations() * subscribers),
+			benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	}
+
+	BENCHMARK(fanOutSubscribers)->ArgsProduct({ { 1, 10, 100, 1000, 10000 }, { 0, 1 } });
+
+	/// @brief invoke until the callback ran, queued to a worker (0) or synchronous (1)
+	static void invokeLatency(benchmark::State & state)
+	{
+		const bool synchronous = state.range(0) != 0;
+		eventHandling::EventBus eventBus;
+		std::atomic<int> dispatched(0);
+		eventHandling::TopicId latencyTopic = eventBus.topic("latency");
+		eventBus.add(latencyTopic, [&dispatched](int i) {
+			dispatched.store(i, std::memory_order_release); });
+		eventBus.setSynchronous(latencyTopic, synchronous);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		int call = 0;
+		for (auto _ : state)
+		{
+			++call;
+			benchmark::DoNotOptimize(eventBus.invoke(latencyTopic, call));
+			while (dispatched.load(std::memory_order_acquire) != call)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeLatency)->Arg(0)->Arg(1)->UseRealTime();
+
+	/// @brief latency from invoke until an idle worker ran the callback, by WaitStrategy
+	/// @details state.range(0) is the WaitStrategy. Every call follows an idle
+	///          gap in which the worker spins, yields or parks; the time is the
+	///          wakeup latency, the process CPU time includes the idle gap and
+	///          so shows what the waiting costs. A fixed iteration count keeps
+	///          the gaps from dominating the run time.
+	static void wakeupLatency(benchmark::State & state)
+	{
+		const auto strategy = static_cast<eventHandling::WaitStrategy>(state.range(0));
+		eventHandling::EventBus eventBus;
+		std::atomic<long long> dispatchedAt(0);
+		eventHandling::TopicId wakeupTopic = eventBus.topic("wakeup");
+		eventBus.add(wakeupTopic, [&dispatchedAt](int) {
+			dispatchedAt.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+				std::memory_order_release); });
+		eventBus.setLatencySampling(wakeupTopic, 0);
+		eventBus.setWaitStrategy(strategy);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (auto _ : state)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			dispatchedAt.store(0, std::memory_order_relaxed);
+			const auto start = std::chrono::steady_clock::now();
+			benchmark::DoNotOptimize(eventBus.invoke(wakeupTopic, 1));
+			long long end = 0;
+			while ((end = dispatchedAt.load(std::memory_order_acquire)) == 0)
+			{
+				std::this_thread::yield();
+			}
+			state.SetIterationTime(std::chrono::duration<double>(
+				std::chrono::steady_clock::duration(end) - start.time_since_epoch()).count());
+		}
+		eventBus.stop();
+		busThread.join();
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(wakeupLatency)->DenseRange(0, 3)->Iterations(2000)->UseManualTime()
+		->MeasureProcessCPUTime();
+
+	/// @brief invokeLatency of a queued call with tracing off (0) or on (1)
+	/// @details the difference is the cost of the enqueue, dispatch and
+	///          callback records of one call
+	static void invokeTraced(benchmark::State & state)
+	{
+		eventHandling::EventBus eventBus;
+		std::atomic<int> dispatched(0);
+		eventHandling::TopicId tracedTopic = eventBus.topic("traced");
+		eventBus.add(tracedTopic, [&dispatched](int i) {
+			dispatched.store(i, std::memory_order_release); });
+		eventBus.setLatencySampling(tracedTopic, 0);
+		eventBus.setTracing(state.range(0) != 0);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		int call = 0;
+		for (auto _ : state)
+		{
+			++call;
+			benchmark::DoNotOptimize(eventBus.invoke(tracedTopic, call));
+			while (dispatched.load(std::memory_order_acquire) != call)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		eventBus.setTracing(false);
+		eventBus.clearTrace();
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeTraced)->Arg(0)->Arg(1)->UseRealTime();
+
+	/// @brief invoke() of a durable id and wait for the dispatch
+	/// @details argument -1 is not durable, -2 journals without syncing, otherwise
+	///          the sync interval of the journal in microseconds
+	static void invokeDurable(benchmark::State & state)
+	{
+		const std::string directory("benchJournal");
+		eventHandling::Journal::remove(directory);
+		eventHandling::EventBus eventBus;
+		std::atomic<int> dispatched(0);
+		eventHandling::TopicId durableTopic = eventBus.topic("durable");
+		eventBus.add(durableTopic, [&dispatched](std::string) {
+			dispatched.fetch_add(1, std::memory_order_release); });
+		if (state.range(0) != -1)
+		{
+			eventHandling::JournalOptions options;
+			options.m_syncInterval = std::chrono::microseconds(state.range(0));
+			eventBus.openJournal(directory, options);
+			eventBus.setDurable(durableTopic);
+		}
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		const std::string text(64, 'x');
+		int call = 0;
+		for (auto _ : state)
+		{
+			++call;
+			benchmark::DoNotOptimize(eventBus.invoke(durableTopic, text));
+			while (dispatched.load(std::memory_order_acquire) != call)
+			{
+				std::this_thread::yield();
+			}
+		}
+		eventBus.stop();
+		busThread.join();
+		eventHandling::JournalStats stats = eventBus.getJournalStats();
+		state.counters["syncs"] = static_cast<double>(stats.m_syncCount);
+		eventBus.closeJournal();
+		eventHandling::Journal::remove(directory);
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeDurable)->Arg(-1)->Arg(-2)->Arg(0)->Arg(1000)->Arg(10000)->UseRealTime();
+
+	/// @brief open and replay 16 MB of pending journal records with 64 byte arguments
+	/// @details argument 0 only scans the journal, 1 queues the calls with
+	///          EventBus::replayJournal() into a bus which does not run
+	static void replayJournal(benchmark::State & state)
+	{
+		const std::string directory("benchReplayJournal");
+		eventHandling::Journal::remove(directory);
+		eventHandling::JournalOptions options;
+		options.m_syncInterval = std::chrono::microseconds(-1);
+		const std::string text(64, 'x');
+		{
+			eventHandling::Journal journal;
+			journal.open(directory, options);
+			while (journal.getStats().m_appendedBytes < (16 << 20))
+			{
+				journal.append("replay", text.data(), text.size());
+			}
+		}
+		long long bytes = 0, records = 0;
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			std::unique_ptr<eventHandling::EventBus> eventBusPtr(new eventHandling::EventBus);
+			eventBusPtr->add("replay", [](std::string text) { benchmark::DoNotOptimize(text); });
+			eventHandling::Journal journal;
+			state.ResumeTiming();
+			if (state.range(0) == 0)
+			{
+				journal.open(directory, options);
+			}
+			else
+			{
+				eventBusPtr->openJournal(directory, options);
+			}
+			eventHandling::JournalReplayStats stats;
+			if (state.range(0) == 0)
+			{
+				// taken and never completed, pending for the next round
+				stats = journal.replay([](const eventHandling::JournalRecordView & record) {
+					benchmark::DoNotOptimize(record.m_argumentPtr);
+					return true; });
+			}
+			else
+			{
+				stats = eventBusPtr->replayJournal();
+			}
+			state.PauseTiming();
+			bytes += stats.m_bytes;
+			records += stats.m_replayedCount;
+			journal.close();
+			// the queued calls are dropped without completing their records
+			eventBusPtr->closeJournal();
+			eventBusPtr.reset();
+			state.ResumeTiming();
+		}
+		eventHandling::Journal::remove(directory);
+		state.SetBytesProcessed(bytes);
+		state.SetItemsProcessed(records);
+	}
+
+	BENCHMARK(replayJournal)->Arg(0)->Arg(1)->Iterations(10)->Unit(benchmark::kMillisecond);
+
+	/// @brief invokeAsync() and wait for its future, the pooled state is reused
+	static void invokeAsyncWait(benchmark::State & state)
+	{
+		eventHandling::EventBus eventBus;
+		std::atomic<int> dispatched(0);
+		eventHandling::TopicId waitTopic = eventBus.topic("wait");
+		eventBus.add(waitTopic, [&dispatched](int i) {
+			dispatched.store(i, std::memory_order_relaxed); });
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		long long allocations = eventHandling::CompletionPool::instance().getAllocationCount();
+		int call = 0;
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(eventBus.invokeAsync(waitTopic, ++call).getCount());
+		}
+		eventBus.stop();
+		busThread.join();
+		state.counters["stateAllocations"] = static_cast<double>(
+			eventHandling::CompletionPool::instance().getAllocationCount() - allocations);
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(invokeAsyncWait)->UseRealTime();
+}//namespace
@@ -0,0 +1,113 @@
+/// @file benchQueue.cpp
+/// This file contains benchmarks for the EventBus call queue
+/// It is implemented using constructs from C++14 standard.
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../eventFramework/containerWrapper.h"
+#include "../eventFramework/ringQueue.h"
+
+namespace benchQueue
+{
+	/// items pushed by all producers together in one benchmark iteration
+	const size_t g_itemsPerIteration = 1 << 16;
+	const size_t g_queueCapacity = 1024;
+
+	/// @brief adapter so both queues can be driven by the same benchmark
+	struct LockedQueue
+	{
+		QueueWrapper<size_t> m_queue;
+		bool tryPush(size_t && value)
+		{
+			m_queue.push(value);
+			return true;
+		}
+		bool tryPop(size_t & value)
+		{
+			if (m_queue.empty())
+			{
+				return false;
+			}
+			m_queue.get(value);
+			return true;
+		}
+	};
+
+	struct LockFreeQueue
+	{
+		eventHandling::RingQueue<size_t> m_queue;
+		LockFreeQueue() : m_queue(g_queueCapacity) {}
+		bool tryPush(size_t && value)
+		{
+			return m_queue.tryPush(std::move(value));
+		}
+		bool tryPop(size_t & value)
+		{
+			return m_queue.tryPop(value);
+		}
+	};
+
+	/// @brief N producers, one consumer, the consumer is the benchmark thread
+	/// @details state.range(0) is the number of producer threads
+	template<class Queue>
+	static void producersToConsumer(benchmark::State & state)
+	{
+		const size_t producerCount = static_cast<size_t>(state.range(0));
+		const size_t perProducer = g_itemsPerIteration / producerCount;
+		for (auto _ : state)
+		{
+			Queue queue;
+			std::atomic<bool> go(false);
+			std::vector<std::thread> producers;
+			for (size_t p = 0; p < producerCount; ++p)
+			{
+				producers.emplace_back([&] {
+					while (!go.load(std::memory_order_acquire))
+					{
+						std::this_thread::yield();
+					}
+					for (size_t i = 0; i < perProducer; ++i)
+					{
+						size_t value = i;
+						while (!queue.tryPush(std::move(value)))
+						{
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+			auto start = std::chrono::steady_clock::now();
+			go.store(true, std::memory_order_release);
+			size_t received = 0, value = 0;
+			while (received < perProducer * producerCount)
+			{
+				if (queue.tryPop(value))
+				{
+					++received;
+					benchmark::DoNotOptimize(value);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+			state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+			for (auto & producer : producers)
+			{
+				producer.join();
+			}
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() *
+			perProducer * producerCount));
+	}
+
+	BENCHMARK_TEMPLATE(producersToConsumer, LockedQueue)
+		->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseManualTime();
+	BENCHMARK_TEMPLATE(producersToConsumer, LockFreeQueue)
+		->Arg(1)->Arg(4)->Arg(16)->Arg(64)->UseManualTime();
+}//namespace
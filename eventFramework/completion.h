@@ -0,0 +1,201 @@
+/// @file completion.h
+/// This file contains the pooled shared state of invoke results for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+namespace eventHandling
+{
+	class CompletionPool;
+
+	/// @brief Result of one queued call, shared by the call and its waiter
+	/// @details Reference counted and recycled by the CompletionPool, so waiting
+	///          for a result does not allocate once the pool is warm. complete()
+	///          is lock free unless a waiter is parked, waiters check the state
+	///          before they take the lock.
+	class CompletionState
+	{
+		friend class CompletionPool;
+		/// m_aPhase values
+		enum Phase
+		{
+			pending = 0,
+			parked = 1, // pending and a waiter sleeps on m_waitCv
+			done = 2
+		};
+		std::atomic<int> m_aRefCount;
+		std::atomic<int> m_aPhase;
+		int m_count; // written before m_aPhase becomes done
+		int m_status;
+		std::exception_ptr m_exceptionPtr;
+		std::mutex m_waitMtx;
+		std::condition_variable m_waitCv;
+		CompletionPool * m_poolPtr;
+		CompletionState * m_nextPtr; // free list of the pool
+
+		CompletionState() : m_aRefCount(0), m_aPhase(pending), m_count(-1), m_status(0),
+			m_poolPtr(nullptr), m_nextPtr(nullptr) {}
+		/// @brief announce a waiter, false in case the state is done already
+		bool park()
+		{
+			int phase = pending;
+			return m_aPhase.compare_exchange_strong(phase, parked) || phase == parked;
+		}
+	public:
+		CompletionState(const CompletionState&) = delete;
+		CompletionState& operator = (const CompletionState&) = delete;
+		void addRef()
+		{
+			m_aRefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		/// @brief drop a reference, the last one hands the state back to its pool
+		void release();
+		/// @brief publish the result and wake the waiters, only the first call counts
+		void complete(int count, int status, std::exception_ptr exceptionPtr)
+		{
+			if (m_aPhase.load(std::memory_order_acquire) == done)
+			{
+				return;
+			}
+			m_count = count;
+			m_status = status;
+			m_exceptionPtr = std::move(exceptionPtr);
+			if (m_aPhase.exchange(done, std::memory_order_acq_rel) == parked)
+			{
+				// the waiter checks the phase under the lock, no lost wakeup
+				std::lock_guard<std::mutex> lk(m_waitMtx);
+				m_waitCv.notify_all();
+			}
+		}
+		bool isDone() const
+		{
+			return m_aPhase.load(std::memory_order_acquire) == done;
+		}
+		void wait()
+		{
+			if (isDone())
+			{
+				return;
+			}
+			std::unique_lock<std::mutex> lk(m_waitMtx);
+			if (park())
+			{
+				m_waitCv.wait(lk, [this] { return isDone(); });
+			}
+		}
+		/// @return false in case the state is still pending after timeout
+		template<class Rep, class Period>
+		bool waitFor(const std::chrono::duration<Rep, Period> & timeout)
+		{
+			if (isDone())
+			{
+				return true;
+			}
+			std::unique_lock<std::mutex> lk(m_waitMtx);
+			return !park() || m_waitCv.wait_for(lk, timeout, [this] { return isDone(); });
+		}
+		/// only valid once isDone()
+		int getCount() const
+		{
+			return m_count;
+		}
+		int getStatus() const
+		{
+			return m_status;
+		}
+		const std::exception_ptr & getException() const
+		{
+			return m_exceptionPtr;
+		}
+	};
+
+	/// @brief Recycles CompletionStates, shared by all EventBus objects
+	/// @details A state may outlive the bus of its call, so the pool is process
+	///          wide. The free list is guarded by one lock held for two pointer
+	///          writes, acquire() only allocates while the list is empty.
+	class CompletionPool
+	{
+		std::mutex m_freeMtx;
+		CompletionState * m_freePtr;
+		std::atomic<long long> m_aAllocations, m_aReuses;
+
+		CompletionPool() : m_freePtr(nullptr), m_aAllocations(0), m_aReuses(0) {}
+	public:
+		CompletionPool& operator = (CompletionPool&) = delete;
+		~CompletionPool()
+		{
+			while (m_freePtr)
+			{
+				CompletionState * statePtr = m_freePtr;
+				m_freePtr = statePtr->m_nextPtr;
+				delete statePtr;
+			}
+		}
+		static CompletionPool & instance()
+		{
+			static CompletionPool pool;
+			return pool;
+		}
+		/// @brief a pending state holding one reference
+		CompletionState * acquire()
+		{
+			CompletionState * statePtr = nullptr;
+			{
+				std::lock_guard<std::mutex> lk(m_freeMtx);
+				statePtr = m_freePtr;
+				if (statePtr)
+				{
+					m_freePtr = statePtr->m_nextPtr;
+				}
+			}
+			if (statePtr)
+			{
+				m_aReuses.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				m_aAllocations.fetch_add(1, std::memory_order_relaxed);
+				statePtr = new CompletionState;
+				statePtr->m_poolPtr = this;
+			}
+			statePtr->m_nextPtr = nullptr;
+			statePtr->m_count = -1;
+			statePtr->m_status = 0;
+			statePtr->m_aPhase.store(CompletionState::pending, std::memory_order_relaxed);
+			statePtr->m_aRefCount.store(1, std::memory_order_relaxed);
+			return statePtr;
+		}
+		void release(CompletionState * statePtr)
+		{
+			statePtr->m_exceptionPtr = nullptr;
+			std::lock_guard<std::mutex> lk(m_freeMtx);
+			statePtr->m_nextPtr = m_freePtr;
+			m_freePtr = statePtr;
+		}
+		/// states made because the free list was empty
+		long long getAllocationCount() const
+		{
+			return m_aAllocations.load();
+		}
+		long long getReuseCount() const
+		{
+			return m_aReuses.load();
+		}
+	};
+
+	inline void CompletionState::release()
+	{
+		if (m_aRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_poolPtr->release(this);
+		}
+	}
+}//namespace
+
+#endif
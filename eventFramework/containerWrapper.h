@@ -3,6 +3,7 @@
 #define CONTAINER_WRAPPER_H
 
 #include <iostream>
+#include <mutex>
 #include <type_traits>
 #include <string>
 #include <vector>
@@ -29,6 +30,7 @@ namespace
 		bool empty();
 		size_t size();
 		void get(T& value);
+		bool tryGet(T& value);
 	};
 
 	template<class T>
@@ -150,15 +152,26 @@ namespace
 	void QueueWrapper<T>::push(T value)
 	{
 		std::lock_guard<std::mutex> lk(m_dataMtx);
-		this->data.push(value);
+		this->data.push(std::move(value));
 	}
 	template<class T>
 	void QueueWrapper<T>::get(T& value) {
 		std::lock_guard<std::mutex> lk(m_dataMtx);
-		value = this->data.front();
+		value = std::move(this->data.front());
 		this->data.pop();
 	}
 	template<class T>
+	bool QueueWrapper<T>::tryGet(T& value) {
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		if (this->data.empty())
+		{
+			return false;
+		}
+		value = std::move(this->data.front());
+		this->data.pop();
+		return true;
+	}
+	template<class T>
 	bool QueueWrapper<T>::empty()
 	{
 		std::lock_guard<std::mutex> lk(m_dataMtx);
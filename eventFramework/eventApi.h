@@ -5,6 +5,7 @@
 #ifndef MESSAGEBUSAPI_H
 #define MESSAGEBUSAPI_H
 
+#include <algorithm>
 #include <iostream>
 #include <future>
 #include <memory>
@@ -27,12 +28,13 @@ namespace
 	/// @details Provides an ability to add callbacks and run them
 	/// @param eventHandling::EventBus object to use
 	/// @param callBackName identifier for callback
-	/// @param async optional string argument, default  true
+	/// @param async optional argument, default true, false makes the callback id
+	///        synchronous, its invokes run the callbacks on the calling thread
 	/// @param verbose optional argument, default 1
 	/// @return true in case the handler was successfully posted
-	template<typename T>
+	template<class... Args>
 	static bool addEvent(eventHandling::EventBus & eventBus,
-		std::string callBackName, std::function<void(T)> functionObject,
+		std::string callBackName, std::function<void(Args...)> functionObject,
 		bool async = true, int verbose = 1);
 
 	/// @brief Implements basic event type 
@@ -40,27 +42,27 @@ namespace
 	/// @param eventHandling::EventBus object to use
 	/// @param callBackName identifier for callback
 	/// @param functionArgument optional string argument, default empty string
-	/// @param async optional string argument, default  true
+	/// @param async optional argument, default true, false runs the callbacks
+	///        on the calling thread
 	/// @param verbose optional argument, default 1
-	/// @return number of sucesssful calls in the invocation
+	/// @return number of sucesssful calls in the invocation, 1 for a queued call
 	//setting function argument back to simple default, cannot properly detect void now
 	static int invokeEvent(eventHandling::EventBus & eventBus,
-		const std::string & callBackName, const std::string functionArgument = "",
+		const std::string & callBackName, std::string functionArgument = "",
 		bool async = true, int verbose = 1);
 
 	/// @brief Add function as described in the use cases
 	/// @details Provides an ability to add callbacks and  run them
 	/// @param callBackName identifier for callback
-	/// @param functionObject std::function<void(T)>() to store
-	/// only supports string at the moment no return values 
+	/// @param functionObject std::function<void(Args...)>() to store
+	/// no return values, all callbacks of one name take the same arguments
 	/// @return true in case the handler was successfully posted
-	template<typename T>
+	template<class... Args>
 	static bool add(const std::string & callBackName,
-		std::function<void(T)> functionObject)
+		std::function<void(Args...)> functionObject)
 	{
 		if (!g_eventBusPtr.get())
 		{
-			new eventHandling::EventBus;
 			g_eventBusPtr = std::shared_ptr<eventHandling::EventBus>(new eventHandling::EventBus);
 			if (g_eventBusPtr.get())
 			{
@@ -85,52 +87,77 @@ namespace
 	{
 		if (!g_eventBusPtr.get())
 		{
-			if (verbose > 0)
-			{
-				std::cout << ("Please add event first\n");
-			}
+			EVENT_LOG_INFO(verbose, "Please add event first");
 			return false;
 		}
 		return invokeEvent(*(g_eventBusPtr.get()), callBackName, functionArgument);
 	}
 
+	/// @brief Invoke with typed arguments, see EventBus::invoke
+	/// @param callBackName identifier for callback
+	/// @param args have to match the arguments of the added callbacks
+	/// @return true in case the call was queued
+	template<class... Args>
+	static bool invokeTyped(const std::string & callBackName, Args... args)
+	{
+		if (!g_eventBusPtr.get())
+		{
+			EVENT_LOG_ERROR("Please add event first");
+			return false;
+		}
+		return g_eventBusPtr->invoke(callBackName, std::move(args)...);
+	}
+
+	/// @brief Invoke and wait for the outcome when needed, see EventBus::invokeAsync
+	/// @param callBackName identifier for callback
+	/// @param functionArgument optional string argument, default empty string
+	/// @return future of the number of successful calls and the first exception
+	static eventHandling::InvokeFuture invokeAsync(const std::string & callBackName,
+		const std::string & functionArgument="")
+	{
+		if (!g_eventBusPtr.get())
+		{
+			EVENT_LOG_ERROR("Please add event first");
+			return eventHandling::InvokeFuture(eventHandling::InvokeResult::noSuchTopic);
+		}
+		return g_eventBusPtr->invokeEventAsync(callBackName, functionArgument);
+	}
+
 	/// implementation
 
 	static bool startBus(eventHandling::EventBus & eventBus)
 	{
-		std::thread mainthr(&eventHandling::EventBus::run, &eventBus);
-		mainthr.detach();// there must be something better
-		return true;
+		// joined by stopBus() or the destructor of the bus
+		return eventBus.start();
 	}
 
-	template<typename T>
+	template<class... Args>
 	static bool addEvent(eventHandling::EventBus & eventBus,
 		std::string callBackName,
-		std::function<void(T)> functionObject, bool async, int verbose)
+		std::function<void(Args...)> functionObject, bool async, int verbose)
 	{
-		if (true)//if (!async) //TODO
+		EVENT_LOG_INFO(verbose, "__ADD__ " << callBackName);
+		if (eventBus.add(callBackName, functionObject) <= 0)
 		{
-			if (verbose > 0)
-			{
-				std::cout << "\n__ADD__ " << callBackName << "\n";
-			}
-			return eventBus.add(callBackName, functionObject);
+			return false;
 		}
+		if (!async)
+		{
+			eventBus.setSynchronous(callBackName, true);
+		}
+		return true;
 	}
 
 	static int invokeEvent(eventHandling::EventBus & eventBus,
-			const std::string & callBackName, const std::string functionArgument,
+			const std::string & callBackName, std::string functionArgument,
 			bool async, int verbose)
 	{
-		if (true)//if (!async) //TODO
+		EVENT_LOG_INFO(verbose, "__INVOKE__ " << callBackName << " " << functionArgument);
+		if (!async)
 		{
-			if (verbose > 0)
-			{ 
-				std::cout << "\n__INVOKE__ " << callBackName << 
-					" "<< functionArgument <<"\n";
-			}
-			return eventBus.invokeEvent(callBackName, functionArgument);
+			return std::max(eventBus.invokeEventSync(callBackName, std::move(functionArgument)), 0);
 		}
+		return eventBus.invokeEvent(callBackName, std::move(functionArgument));
 	}
 
 	static bool reStartBus(eventHandling::EventBus & eventBus)
@@ -140,13 +167,22 @@ namespace
 	}
 
 	/// @brief Stop the main loop
-	/// @details can take some time for the loop to terminate
+	/// @details waits for the running callbacks, queued calls stay queued
 	/// @param eventHandling::EventBus to stop
 	/// @return true in case the bus was stopped
 	static bool stopBus(eventHandling::EventBus & eventBus)
 	{
-		eventBus.stop();
-		return true;//check state after some wait TODO
+		eventBus.shutdown(std::chrono::steady_clock::now(), eventHandling::ShutdownMode::abort);
+		return eventBus.getRunState() == 2;
+	}
+
+	/// @brief Dispatch the queued calls, then stop the main loop
+	/// @param timeout longest wait for the queued calls
+	/// @return number of calls still queued when the bus stopped
+	static int drainBus(eventHandling::EventBus & eventBus,
+		std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+	{
+		return eventBus.shutdown(timeout, eventHandling::ShutdownMode::drainUntilDeadline).m_pendingCount;
 	}
 
 
@@ -16,8 +16,29 @@
 #include <condition_variable>
 #include <stdexcept>
 #include <future>
+#include <deque>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
 
 #include "containerWrapper.h"
+#include "ringQueue.h"
+#include "topicTable.h"
+#include "sharedPayload.h"
+#include "inlineFunction.h"
+#include "snapshotList.h"
+#include "timerWheel.h"
+#include "completion.h"
+#include "histogram.h"
+#include "eventLog.h"
+#include "eventTrace.h"
+#include "journal.h"
+#include "shmTransport.h"
 
 namespace eventHandling
 {
@@ -49,7 +70,155 @@ namespace eventHandling
 		failed = 2,
 		success = 3
 	};
-	
+	/// @brief what EventBus does with a call while m_maxCapacity calls are queued
+	enum class OverflowPolicy
+	{
+		block = 0, // wait for space until the block timeout
+		dropNewest = 1, // reject the new call
+		dropOldest = 2, // drop the oldest queued call of the worker and queue the new one
+		grow = 3 // queue the call anyway
+	};
+	/// @brief what EventBus::shutdown() does with the queued calls
+	enum class ShutdownMode
+	{
+		drain = 0, // dispatch all queued calls, the deadline is ignored
+		drainUntilDeadline = 1, // dispatch until the deadline, the rest stays queued
+		abort = 2 // stop after the running callbacks, the queued calls stay queued
+	};
+	/// @brief outcome of EventBus::invokeChecked()
+	enum class InvokeResult
+	{
+		queued = 0,
+		dropped = 1, // capacity reached, dropNewest
+		timedOut = 2, // capacity reached, block timeout expired
+		noSuchTopic = 3,
+		wrongArguments = 4,
+		invalid = 5, // no valid callbacks for the topic
+		dispatched = 6, // ran on the calling thread, see EventBus::setSynchronous()
+		completed = 7 // queued and ran on a worker, see InvokeFuture::getResult()
+	};
+	/// true in case the call was queued or ran already
+	inline bool isAccepted(InvokeResult result)
+	{
+		return result == InvokeResult::queued || result == InvokeResult::dispatched ||
+			result == InvokeResult::completed;
+	}
+
+	/// @brief Result of EventBus::invokeAsync(), ready once the callbacks ran
+	/// @details Calls which are rejected or run synchronously are complete when
+	///          the future is made and carry their result in place, queued calls
+	///          share a pooled CompletionState with their EventCall. Move-only,
+	///          one waiter per future.
+	class InvokeFuture
+	{
+		CompletionState * m_statePtr; // nullptr in case the result was known at invoke
+		InvokeResult m_result;
+		int m_count;
+		std::exception_ptr m_exceptionPtr;
+	public:
+		explicit InvokeFuture(InvokeResult result = InvokeResult::invalid, int count = -1,
+			std::exception_ptr exceptionPtr = nullptr) : m_statePtr(nullptr), m_result(result),
+			m_count(count), m_exceptionPtr(std::move(exceptionPtr)) {}
+		/// @brief takes the reference of statePtr
+		explicit InvokeFuture(CompletionState * statePtr) : m_statePtr(statePtr),
+			m_result(InvokeResult::queued), m_count(-1) {}
+		InvokeFuture(InvokeFuture && other) noexcept : m_statePtr(other.m_statePtr),
+			m_result(other.m_result), m_count(other.m_count),
+			m_exceptionPtr(std::move(other.m_exceptionPtr))
+		{
+			other.m_statePtr = nullptr;
+		}
+		InvokeFuture& operator = (InvokeFuture && other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_statePtr)
+				{
+					m_statePtr->release();
+				}
+				m_statePtr = other.m_statePtr;
+				m_result = other.m_result;
+				m_count = other.m_count;
+				m_exceptionPtr = std::move(other.m_exceptionPtr);
+				other.m_statePtr = nullptr;
+			}
+			return *this;
+		}
+		InvokeFuture(const InvokeFuture&) = delete;
+		InvokeFuture& operator = (const InvokeFuture&) = delete;
+		~InvokeFuture()
+		{
+			if (m_statePtr)
+			{
+				m_statePtr->release();
+			}
+		}
+		/// true in case the callbacks ran or the call was rejected or dropped
+		bool ready() const
+		{
+			return !m_statePtr || m_statePtr->isDone();
+		}
+		void wait() const
+		{
+			if (m_statePtr)
+			{
+				m_statePtr->wait();
+			}
+		}
+		/// @return false in case the call is still pending after timeout
+		template<class Rep, class Period>
+		bool waitFor(const std::chrono::duration<Rep, Period> & timeout) const
+		{
+			return !m_statePtr || m_statePtr->waitFor(timeout);
+		}
+		/// @brief waits, completed for calls which ran on a worker, dropped for
+		///        queued calls which never ran, see isAccepted()
+		InvokeResult getResult() const
+		{
+			if (!m_statePtr)
+			{
+				return m_result;
+			}
+			m_statePtr->wait();
+			return static_cast<InvokeResult>(m_statePtr->getStatus());
+		}
+		/// @brief waits, number of successful calls, -1 in case the call never ran
+		int getCount() const
+		{
+			if (!m_statePtr)
+			{
+				return m_count;
+			}
+			m_statePtr->wait();
+			return m_statePtr->getCount();
+		}
+		/// @brief waits, first exception thrown by a callback of the call
+		std::exception_ptr getException() const
+		{
+			if (!m_statePtr)
+			{
+				return m_exceptionPtr;
+			}
+			m_statePtr->wait();
+			return m_statePtr->getException();
+		}
+	};
+	/// @brief priority class of a topic or a single invoke, also its lane index
+	enum class Priority
+	{
+		high = 0,
+		normal = 1,
+		low = 2
+	};
+	/// number of priority lanes of a dispatch worker, one per Priority
+	static const int g_laneCount = 3;
+	/// @brief how a dispatch worker picks the lane of its next task
+	enum class LaneScheduling
+	{
+		strict = 0, // highest non empty lane first
+		weighted = 1 // lanes take turns, each serves up to its weight in tasks
+	};
+
 	/// @brief make state human readable and atomic friendly
 	/// @details Provides an ability to add callbacks and  run them
 	//from stackoverflow, make state human readable and atomic friendly
@@ -104,6 +273,109 @@ namespace eventHandling
 		return utils::underlying_value(val);
 	}
 
+	/// @brief identifies the argument list of a callback without RTTI
+	/// @details one static per decayed argument list, its address is the id
+	namespace details
+	{
+		template<class... Args>
+		struct SignatureTag
+		{
+			static const char m_id;
+		};
+		template<class... Args>
+		const char SignatureTag<Args...>::m_id = 0;
+
+		template<bool... B>
+		struct BoolPack {};
+		/// @brief true in case all Args can be copied to more than one subscriber
+		template<class... Args>
+		struct AllCopyable : std::is_same<BoolPack<true, std::is_copy_constructible<Args>::value...>,
+			BoolPack<std::is_copy_constructible<Args>::value..., true>> {};
+
+		template<class T>
+		T copyOrMove(T & value, bool lastUse, std::true_type)
+		{
+			if (lastUse)
+			{
+				return std::move(value);
+			}
+			return value;
+		}
+		// move-only arguments only have a single subscriber, see EventHandler::addEvent
+		template<class T>
+		T copyOrMove(T & value, bool, std::false_type)
+		{
+			return std::move(value);
+		}
+
+		/// @brief passes a stored argument to a callback parameter of type P
+		/// @details reference parameters see the stored argument, by value parameters
+		///          get a copy, the last subscriber of a call gets it moved
+		template<class P, bool ByReference = std::is_lvalue_reference<P>::value>
+		struct ArgumentPass
+		{
+			template<class T>
+			static T & pass(T & value, bool)
+			{
+				return value;
+			}
+		};
+		template<class P>
+		struct ArgumentPass<P, false>
+		{
+			template<class T>
+			static T pass(T & value, bool lastUse)
+			{
+				return copyOrMove(value, lastUse, std::is_copy_constructible<T>());
+			}
+		};
+
+		/// @brief declared parameters of a lambda, function object or function pointer
+		/// @details generic lambdas and overloaded call operators are not supported
+		template<class F>
+		struct CallableTraits : CallableTraits<decltype(&F::operator())> {};
+		template<class C, class R, class... P>
+		struct CallableTraits<R(C::*)(P...) const>
+		{
+			typedef std::tuple<P...> Parameters;
+		};
+		template<class C, class R, class... P>
+		struct CallableTraits<R(C::*)(P...)>
+		{
+			typedef std::tuple<P...> Parameters;
+		};
+		template<class R, class... P>
+		struct CallableTraits<R(*)(P...)>
+		{
+			typedef std::tuple<P...> Parameters;
+		};
+
+		/// @brief empty std::function or null function pointer, never for lambdas
+		template<class F>
+		bool isNull(const F &)
+		{
+			return false;
+		}
+		template<class R, class... P>
+		bool isNull(R(* const & callable)(P...))
+		{
+			return callable == nullptr;
+		}
+		template<class R, class... P>
+		bool isNull(const std::function<R(P...)> & callable)
+		{
+			return !callable;
+		}
+	} // namespace details
+
+	typedef const void * SignatureId;
+
+	template<class... Args>
+	inline SignatureId signatureOf()
+	{
+		return &details::SignatureTag<typename std::decay<Args>::type...>::m_id;
+	}
+
 	/// @brief Base for ArgumentContainer for different types
 	/// @details Special case for void
 	class ArgumentContainerBase
@@ -141,9 +413,11 @@ namespace eventHandling
 				dynamic_cast<ArgumentContainer<T> *> (functionArgumentContainerPtr);
 			if (argPtr)
 			{
+				argPtr->m_argsType = argType;
 				if (!isVoid)
 				{
 					argPtr->m_Argument = val;
+					argPtr->m_isVoid = false;
 				}
 				else
 				{
@@ -183,6 +457,46 @@ namespace eventHandling
 		return false;
 	}
 
+	namespace details
+	{
+		/// @brief legacy ArgumentContainer path, only void and single argument callbacks
+		template<class... Args>
+		struct ContainerInvoker
+		{
+			template<class Callback>
+			static bool call(const Callback & callback,
+				ArgumentContainerBase * argConPtr)
+			{
+				return false;
+			}
+		};
+		template<>
+		struct ContainerInvoker<>
+		{
+			template<class Callback>
+			static bool call(const Callback & callback,
+				ArgumentContainerBase * argConPtr)
+			{
+				callback(true);
+				return true;
+			}
+		};
+		template<class T>
+		struct ContainerInvoker<T>
+		{
+			template<class Callback>
+			static bool call(const Callback & callback,
+				ArgumentContainerBase * argConPtr)
+			{
+				T functionArgument = T();
+				bool isVoid = true;
+				getContainerArgument(argConPtr, functionArgument, isVoid);
+				callback(true, functionArgument);
+				return true;
+			}
+		};
+	} // namespace details
+
 	/// @brief Base for ArgumentContainer for different types
 	/// @details Special case for void
 	class ObjectBase
@@ -191,11 +505,11 @@ namespace eventHandling
 		ResultState m_ResultState;
 		RunState m_RunState;
 	public:
-		// reset to 0 for a lot of debug output
+		// set to 1 or 2 for a lot of debug output, see EVENT_LOG_INFO and EVENT_LOG_DEBUG
 		ObjectBase(std::string name = "") : m_name(name), m_verbose(0) {}
 		virtual ~ObjectBase() {};
 		std::string m_name;
-		int m_verbose;
+		int m_verbose; // runtime level of the EVENT_LOG macros, compiled in up to EVENT_LOG_LEVEL
 		ArgsTypes argtype;
 		virtual bool isValid() = 0;
 	};
@@ -209,23 +523,31 @@ namespace eventHandling
 		ArgsTypes m_argtype;
 	};
 
-	/// @brief Base for ArgumentContainer for different types
-	/// @details Special case for void
-	template <class T>
+	/// @brief Callback and its state
+	/// @details Args are the decayed argument types of the callback, none for void.
+	///          Events of one EventHandler share the same Args. The callback sees
+	///          the arguments stored in the EventCall, reference parameters are
+	///          not copied, by value parameters are moved for the last subscriber.
+	template <class... Args>
 	class Event : public EventBase
 	{
 		mutable std::mutex m_dataMtx; //m_Callback
 		std::atomic<int> m_aResultState, m_aRunState;
+	public:
+		// first argument is true when the arguments may be moved from
+		typedef InlineFunction<void(bool, Args&...)> Callback;
 	protected:
-		std::function<void(T)> m_Callback;
+		Callback m_Callback;
 		void setRunState(const RunState & val);
 		void setResultState(const ResultState & val);
-		//inital implementation should use argument containers
-		bool invokeInternal(T functionArgument, bool isVoid = false);
-		bool dispatch();
-		template <class A>
-		bool dispatch(A functionArgument);
+		bool invokeInternal(bool lastUse, Args&... args);
+		template <std::size_t... I>
+		bool invokeTuple(std::tuple<Args...> & arguments, bool lastUse, std::index_sequence<I...>)
+		{
+			return invokeInternal(lastUse, std::get<I>(arguments)...);
+		}
 	public:
+		/// @brief legacy path for void and single argument callbacks
 		bool invokeWithContainerArg(std::shared_ptr<ArgumentContainerBase> argConPtr);
 		Event(std::string eventName = "") : EventBase(eventName), m_aRunState(0),
 			m_aResultState(0)
@@ -240,40 +562,374 @@ namespace eventHandling
 		{
 			return getResultState() != ResultState::invalid;
 		}
-		bool setCallback(std::function<void(T)> callback);
-		template <class... Args>
-		auto invoke(Args... args) -> decltype(dispatch(args...))
+		/// @brief P are the declared parameters, they decay to Args
+		template <class... P>
+		bool setCallback(std::function<void(P...)> callback);
+		bool setCallback(std::function<void(Args...)> callback)
+		{
+			return setCallback<Args...>(std::move(callback));
+		}
+		/// @brief store callable in place, without a std::function
+		/// @details P are the declared parameters of callable, callable has to be
+		///          copyable and fit into an InlineFunction
+		template <class... P, class F>
+		bool setCallable(F callable);
+		/// @brief copy of the wrapped callback, empty for blocked or invalid events
+		Callback getCallback() const
+		{
+			std::lock_guard<std::mutex> l(m_dataMtx);
+			if (m_aRunState == valueFromEnum(RunState::blocked) ||
+				m_aResultState == valueFromEnum(ResultState::invalid))
+			{
+				return nullptr;
+			}
+			return m_Callback.clone();
+		}
+		template <class... A>
+		bool invoke(A&&... args)
+		{
+			std::tuple<Args...> arguments(std::forward<A>(args)...);
+			return invokeWithTuple(arguments, true);
+		}
+		/// @brief invoke with the arguments stored in an EventCall
+		/// @param lastUse true in case the arguments may be moved into the callback
+		bool invokeWithTuple(std::tuple<Args...> & arguments, bool lastUse = false)
+		{
+			return invokeTuple(arguments, lastUse, std::index_sequence_for<Args...>());
+		}
+	};
+
+	class EventCall;
+	class EventCallPool;
+
+	/// @brief hands a pooled EventCall back to its pool, deletes others
+	struct EventCallDeleter
+	{
+		void operator()(EventCall * evCallPtr) const;
+	};
+	typedef std::unique_ptr<EventCall, EventCallDeleter> EventCallPtr;
+
+	/// size of the in place argument storage of an EventCall
+	static const size_t g_inlineArgumentSize = 64;
+	/// number of free lists of an EventCallPool
+	static const size_t g_callPoolStripes = 8;
+
+	/// state of a subscriber in a SubscriberTable
+	enum class SubscriberState : uint8_t
+	{
+		ready = 0,
+		blocked = 1
+	};
+
+	/// @brief Callbacks of a SubscriberTable, typed in CallbackColumn
+	class CallbackColumnBase
+	{
+	public:
+		virtual ~CallbackColumnBase() {};
+		virtual CallbackColumnBase * clone() const = 0;
+		/// @brief add a callback which is never called, for untyped events
+		virtual void appendEmpty() = 0;
+		virtual void erase(size_t i) = 0;
+	};
+
+	template<class... Args>
+	class CallbackColumn : public CallbackColumnBase
+	{
+	public:
+		// first argument is true when the arguments may be moved from, see Event
+		typedef InlineFunction<void(bool, Args&...)> Callback;
+		std::vector<Callback> m_callbacks; // stored in place, no allocation per callback
+		CallbackColumn() = default;
+		CallbackColumn(const CallbackColumn & other)
+		{
+			m_callbacks.reserve(other.m_callbacks.size() + 1);
+			for (const Callback & callback : other.m_callbacks)
+			{
+				m_callbacks.push_back(callback.clone());
+			}
+		}
+		CallbackColumn& operator = (const CallbackColumn&) = delete;
+		CallbackColumnBase * clone() const override
+		{
+			return new CallbackColumn(*this);
+		}
+		void appendEmpty() override
+		{
+			m_callbacks.emplace_back();
+		}
+		void erase(size_t i) override
+		{
+			m_callbacks.erase(m_callbacks.begin() + i);
+		}
+	};
+
+	/// @brief Subscribers of an EventHandler as a structure of arrays
+	/// @details Index i of every array belongs to the same subscriber. Dispatching
+	///          only walks the packed callbacks and the state bytes, no Event,
+	///          virtual call or mutex per subscriber. The events are kept as
+	///          handles for removeEvent() and the legacy string path. A table is
+	///          immutable once published, see SnapshotList.
+	class SubscriberTable
+	{
+	public:
+		std::vector<std::shared_ptr<EventBase>> m_eventsPtrs;
+		std::vector<uint8_t> m_states; // SubscriberState
+		std::unique_ptr<CallbackColumnBase> m_callbacksPtr; // created by the first typed event
+
+		SubscriberTable() = default;
+		SubscriberTable(const SubscriberTable & other) : m_eventsPtrs(other.m_eventsPtrs),
+			m_states(other.m_states),
+			m_callbacksPtr(other.m_callbacksPtr ? other.m_callbacksPtr->clone() : nullptr) {}
+		SubscriberTable(SubscriberTable &&) = default;
+		SubscriberTable& operator = (const SubscriberTable&) = delete;
+		SubscriberTable& operator = (SubscriberTable&&) = default;
+		size_t size() const
+		{
+			return m_eventsPtrs.size();
+		}
+		bool empty() const
+		{
+			return m_eventsPtrs.empty();
+		}
+		/// @brief add an event with its callback, all typed events share Args
+		template<class... Args>
+		void append(std::shared_ptr<EventBase> eventObjectPtr,
+			typename CallbackColumn<Args...>::Callback callback)
+		{
+			if (!m_callbacksPtr)
+			{
+				std::unique_ptr<CallbackColumn<Args...>> columnPtr(new CallbackColumn<Args...>());
+				columnPtr->m_callbacks.resize(m_eventsPtrs.size());
+				m_callbacksPtr = std::move(columnPtr);
+			}
+			m_states.push_back(static_cast<uint8_t>(
+				static_cast<bool>(callback) ? SubscriberState::ready : SubscriberState::blocked));
+			static_cast<CallbackColumn<Args...> &>(*m_callbacksPtr).m_callbacks.push_back(
+				std::move(callback));
+			m_eventsPtrs.push_back(std::move(eventObjectPtr));
+		}
+		/// @brief add an event which is only dispatched by the legacy path
+		void appendUntyped(std::shared_ptr<EventBase> eventObjectPtr)
+		{
+			m_states.push_back(static_cast<uint8_t>(SubscriberState::blocked));
+			if (m_callbacksPtr)
+			{
+				m_callbacksPtr->appendEmpty();
+			}
+			m_eventsPtrs.push_back(std::move(eventObjectPtr));
+		}
+		void erase(size_t i)
 		{
-			return dispatch(args...);
+			m_eventsPtrs.erase(m_eventsPtrs.begin() + i);
+			m_states.erase(m_states.begin() + i);
+			if (m_callbacksPtr)
+			{
+				m_callbacksPtr->erase(i);
+			}
 		}
 	};
 
+	/// callbacks of one in g_latencySampleInterval dispatches are timed by default
+	static const int g_latencySampleInterval = 64;
+
 	/// @brief Group of events identified by same id
-	/// @details TODO
+	/// @details Ordered handlers also keep their pending calls, so a worker
+	///          can run them as one batch in FIFO order. The subscribers are a
+	///          SubscriberTable in a SnapshotList, dispatching reads a snapshot
+	///          without locks while addEvent() and removeEvent() publish a new one.
 	class EventHandler : public EventBase
 	{
 		std::atomic<int> m_aResultState, m_aRunState;
+		std::atomic<bool> m_aOrdered, m_aBatchScheduled, m_aSynchronous, m_aDurable;
+		std::atomic<int> m_aSampleInterval; // see setSampleInterval()
+		std::atomic<unsigned> m_aDispatchCount; // picks the sampled dispatches
+		std::atomic<SignatureId> m_aSignature; // set by the first typed event
+		std::atomic<int> m_aPriority; // Priority
+		std::atomic<int> m_aTraceNameId; // -1 until the id is traced
+		LatencyHistogram m_waitHistogram; // queued until dispatched
+		LatencyHistogram m_callbackHistogram; // per subscriber
 	protected:
 		std::string m_callbackId;
-		VectorWrapper<std::shared_ptr<EventBase>> m_eventsPtrs;
+		size_t m_callbackHash;
+		typedef SnapshotList<std::shared_ptr<EventBase>, SubscriberTable> Subscribers;
+		Subscribers m_subscribers;
+		std::mutex m_pendingMtx; //m_pendingHeadPtr, m_pendingTailPtr
+		// 0..*, ordered only, owned and linked through EventCall::m_nextCallPtr
+		EventCall * m_pendingHeadPtr, * m_pendingTailPtr;
 		void setRunState(const RunState & val);
 		void setResultState(const ResultState & val);
+		template<class... Args, size_t... I>
+		static bool invokeCallback(const typename CallbackColumn<Args...>::Callback & callback,
+			bool lastUse, std::tuple<Args...> & arguments, std::exception_ptr * exceptionPtr,
+			std::index_sequence<I...>);
 
 	public:
-		EventHandler(const std::string &callbackId="") : m_callbackId(callbackId), m_aResultState(0) {}
+		EventHandler(const std::string &callbackId="") : m_aResultState(0),
+			m_aOrdered(true), m_aBatchScheduled(false), m_aSynchronous(false), m_aDurable(false),
+			m_aSampleInterval(g_latencySampleInterval), m_aDispatchCount(0), m_aSignature(nullptr),
+			m_aPriority(static_cast<int>(Priority::normal)), m_aTraceNameId(-1), m_callbackId(callbackId),
+			m_callbackHash(std::hash<std::string>()(callbackId)), m_pendingHeadPtr(nullptr),
+			m_pendingTailPtr(nullptr) {}
+		~EventHandler() override;
 		bool isValid() override
 		{
-			return !m_eventsPtrs.data.empty();//TODO
+			return !m_subscribers.empty();
 		}
 		std::string getCallbackId()
 		{
 			return m_callbackId;
 		}
+		/// hash of the callback id, used to pick the dispatch worker
+		size_t getCallbackHash() const
+		{
+			return m_callbackHash;
+		}
 		ResultState getResultState();
 		bool getEventCount();
 		void setBlockState(const bool setToState);
+		bool isBlocked() const
+		{
+			return m_aRunState == valueFromEnum(RunState::blocked);
+		}
 		bool addEvent(std::shared_ptr <EventBase> eventObjectPtr);
+		/// @brief add a typed event
+		/// @return false in case the handler already has events with other Args,
+		///         or a second event for move-only Args
+		template<class... Args>
+		bool addEvent(std::shared_ptr<Event<Args...>> eventObjectPtr);
+		/// @brief remove an event, running dispatches finish with their snapshot
+		/// @return false in case eventObjectPtr is not an event of this handler
+		bool removeEvent(const std::shared_ptr<EventBase> & eventObjectPtr);
+		/// @return number of removed events
+		int removeAllEvents();
+		template<class... Args>
+		bool acceptsArguments() const
+		{
+			return m_aSignature.load() == signatureOf<Args...>();
+		}
+		/// @brief legacy path, string and void callbacks only
 		int dispatchAllCalls(std::shared_ptr<ArgumentContainerBase> argContainer);
+		/// @brief invoke all events with the stored arguments
+		/// @param exceptionPtr optional, receives the first exception of a callback
+		/// @return number of successful calls, -1 in case the Args do not match
+		template<class... Args>
+		int dispatchCalls(std::tuple<Args...> & arguments,
+			std::exception_ptr * exceptionPtr = nullptr);
+
+		/// ordered ids are never run by two workers at the same time, default true
+		bool isOrdered() const
+		{
+			return m_aOrdered.load();
+		}
+		void setOrdered(const bool ordered)
+		{
+			m_aOrdered = ordered;
+		}
+		/// synchronous ids run their callbacks on the invoking thread, default false
+		bool isSynchronous() const
+		{
+			return m_aSynchronous.load(std::memory_order_relaxed);
+		}
+		void setSynchronous(const bool synchronous)
+		{
+			m_aSynchronous = synchronous;
+		}
+		/// queued calls of durable ids are written to the journal of the bus, default false
+		bool isDurable() const
+		{
+			return m_aDurable.load(std::memory_order_relaxed);
+		}
+		void setDurable(const bool durable)
+		{
+			m_aDurable = durable;
+		}
+		/// @brief every sampleInterval-th dispatch records the run time of its
+		///        callbacks, 1 for all, 0 for none, default g_latencySampleInterval
+		void setSampleInterval(const int sampleInterval)
+		{
+			m_aSampleInterval = std::max(sampleInterval, 0);
+		}
+		int getSampleInterval() const
+		{
+			return m_aSampleInterval.load(std::memory_order_relaxed);
+		}
+		/// true in case the current dispatch is timed
+		bool takeSample()
+		{
+			const int sampleInterval = getSampleInterval();
+			if (sampleInterval <= 0)
+			{
+				return false;
+			}
+			// no read-modify-write, a count lost between workers only shifts the samples
+			unsigned dispatchCount = m_aDispatchCount.load(std::memory_order_relaxed);
+			m_aDispatchCount.store(dispatchCount + 1, std::memory_order_relaxed);
+			return dispatchCount % static_cast<unsigned>(sampleInterval) == 0;
+		}
+		/// @brief time from invoke until a worker took the call, queued calls only
+		LatencyHistogram & getWaitHistogram()
+		{
+			return m_waitHistogram;
+		}
+		/// @brief run time of each callback of the sampled dispatches
+		LatencyHistogram & getCallbackHistogram()
+		{
+			return m_callbackHistogram;
+		}
+		/// @brief name of the callback id in the EventTrace, looked up once
+		uint32_t getTraceNameId()
+		{
+			int nameId = m_aTraceNameId.load(std::memory_order_relaxed);
+			if (nameId < 0)
+			{
+				nameId = static_cast<int>(EventTrace::instance().nameId(m_callbackId));
+				m_aTraceNameId.store(nameId, std::memory_order_relaxed);
+			}
+			return static_cast<uint32_t>(nameId);
+		}
+		/// lane of the calls of this id, default Priority::normal
+		Priority getPriority() const
+		{
+			return static_cast<Priority>(m_aPriority.load());
+		}
+		void setPriority(Priority priority)
+		{
+			m_aPriority = static_cast<int>(priority);
+		}
+		/// @brief queue a call of an ordered id
+		/// @return true in case the caller has to schedule the batch
+		bool pushPendingCall(EventCallPtr evCallPtr);
+		/// @brief queue the linked calls headPtr..tailPtr of this id with one lock
+		/// @return true in case the caller has to schedule the batch
+		bool pushPendingCalls(EventCallPtr headPtr, EventCall * tailPtr);
+		bool popPendingCall(EventCallPtr & evCallPtr);
+		/// @brief drop calls which were never dispatched
+		void clearPendingCalls();
+		/// @brief end of a batch
+		/// @return true in case new calls arrived and the caller has to schedule again
+		bool finishBatch();
+	};
+
+	/// @brief Arguments of one EventCall, stored in their real type
+	class CallArgumentsBase
+	{
+	public:
+		virtual ~CallArgumentsBase() {};
+		/// @return number of successful calls, -1 in case the handler has other Args
+		virtual int dispatch(EventHandler & eventHandler, std::exception_ptr * exceptionPtr) = 0;
+	};
+
+	template<class... Args>
+	class CallArguments : public CallArgumentsBase
+	{
+	public:
+		template<class... A>
+		CallArguments(A&&... args) : m_arguments(std::forward<A>(args)...) {}
+		std::tuple<Args...> m_arguments;
+		int dispatch(EventHandler & eventHandler, std::exception_ptr * exceptionPtr) override
+		{
+			return eventHandler.dispatchCalls(m_arguments, exceptionPtr);
+		}
 	};
 
 	/// @brief //Job, keep state and result
@@ -282,18 +938,79 @@ namespace eventHandling
 	{
 		mutable std::mutex m_dataMtx, m_argMtx;
 		std::atomic<int> m_aResultState, m_aRunState;
+		friend class EventCallPool;
+		friend struct EventCallDeleter;
+		EventCallPool * m_poolPtr; // owner, nullptr for calls made with new
 	protected:
 		std::shared_ptr < EventHandler> m_EventHandlerPtr;
 		std::shared_ptr<ArgumentContainerBase> m_functionArgumentContainerPtr;
+		CallArgumentsBase * m_argumentsPtr; // in m_argumentStorage or on the heap
+		bool m_argumentsInline;
+		typename std::aligned_storage<g_inlineArgumentSize,
+			alignof(std::max_align_t)>::type m_argumentStorage;
+		CompletionState * m_completionPtr; // result of invokeAsync(), one reference
+		std::shared_ptr<Journal> m_journalPtr; // journal of a durable call
+		uint64_t m_journalSequence;
 		std::chrono::system_clock::time_point m_startTime;
 		void setRunState(const RunState & val);
 		void setResultState(const ResultState & val);
+		void destroyArguments();
+		/// @brief complete m_completionPtr as dropped in case the call never ran
+		void abandonCompletion();
+		template<class T, class... A>
+		CallArgumentsBase * constructArguments(std::true_type, A&&... args)
+		{
+			return new (&m_argumentStorage) T(std::forward<A>(args)...);
+		}
+		template<class T, class... A>
+		CallArgumentsBase * constructArguments(std::false_type, A&&... args);
+		/// @brief clear the call for reuse by the pool
+		void recycle();
 	public:
-		EventCall() : m_aRunState(0), m_aResultState(0), m_startTime(std::chrono::system_clock::now()) {}
+		EventCall() : m_aResultState(0), m_aRunState(0), m_poolPtr(nullptr),
+			m_argumentsPtr(nullptr), m_argumentsInline(false), m_completionPtr(nullptr),
+			m_journalSequence(0),
+			m_startTime(std::chrono::system_clock::now()), m_nextCallPtr(nullptr),
+			m_lane(static_cast<int>(Priority::normal)), m_traceId(0) {}
+		~EventCall() override
+		{
+			abandonCompletion();
+			destroyArguments();
+		}
+		EventCall * m_nextCallPtr; // intrusive link for pool free lists and pending calls
+		int m_lane; // Priority, set when the call is made
+		std::chrono::steady_clock::time_point m_queuedTime; // for the lane wait time
+		uint64_t m_traceId; // flow of the call in the EventTrace, 0 while not traced
+		/// @brief record the enqueue at m_queuedTime, only while the EventTrace is enabled
+		void traceEnqueue()
+		{
+			EventTrace & trace = EventTrace::instance();
+			m_traceId = trace.newCallId();
+			trace.record(TraceKind::enqueue, m_EventHandlerPtr->getTraceNameId(), m_queuedTime,
+				std::chrono::steady_clock::duration(0), m_traceId);
+		}
 		std::shared_ptr<ArgumentContainerBase> getArgument()
 		{
 			return m_functionArgumentContainerPtr;
 		}
+		void setArgument(std::shared_ptr<ArgumentContainerBase> argContainerPtr)
+		{
+			std::lock_guard<std::mutex> lk(m_dataMtx);
+			m_functionArgumentContainerPtr = argContainerPtr;
+		}
+		/// @brief report the result of the dispatch to completionPtr
+		/// @details takes a reference, calls which are dropped complete as
+		///          InvokeResult::dropped
+		void setCompletion(CompletionState * completionPtr)
+		{
+			completionPtr->addRef();
+			std::lock_guard<std::mutex> lk(m_dataMtx);
+			m_completionPtr = completionPtr;
+		}
+		/// @brief typed arguments, used instead of the argument container
+		/// @details stored in place when they fit into g_inlineArgumentSize bytes
+		template<class... Args, class... A>
+		void emplaceArguments(A&&... args);
 		bool isValid() override
 		{
 			std::lock_guard<std::mutex> lk(m_dataMtx);
@@ -303,317 +1020,1321 @@ namespace eventHandling
 		RunState getRunState();
 		ResultState getResultState();
 		void setEventHandler(std::shared_ptr < EventHandler> eventHandlerPtr);
+		std::shared_ptr<EventHandler> getEventHandler()
+		{
+			std::lock_guard<std::mutex> lk(m_dataMtx);
+			return m_EventHandlerPtr;
+		}
+		/// @brief unlocked, only while the caller owns the call
+		const EventHandler * getEventHandlerPtr() const
+		{
+			return m_EventHandlerPtr.get();
+		}
+		EventHandler * getEventHandlerPtr()
+		{
+			return m_EventHandlerPtr.get();
+		}
+		/// @brief record of the call in journalPtr, completed by completeJournal()
+		void setJournal(std::shared_ptr<Journal> journalPtr, uint64_t sequence)
+		{
+			m_journalPtr = std::move(journalPtr);
+			m_journalSequence = sequence;
+		}
+		/// @brief mark the journal record of the call done, calls which are
+		///        recycled without it are replayed after a restart
+		void completeJournal()
+		{
+			if (m_journalPtr)
+			{
+				m_journalPtr->complete(m_journalSequence);
+				m_journalPtr.reset();
+			}
+		}
 		void setBlockState();
 		void setUpdateTimeStamp();
 		int dispatchAllCalls();
 	};
 
-	/// @brief Processing Queue
-	/// @details runs in a infinite loop unless stopped
-	class EventBus : public ObjectBase
+	/// @brief Allocation counters of an EventCallPool
+	struct AllocationStats
 	{
-		std::mutex m_runMtx;
-		std::condition_variable m_cond;
-	protected:
-		int m_stopped = 0;// 0 running, 1 interrupt, 2 stop processing like RunState enum
-		QueueWrapper<std::unique_ptr<EventCall>> m_eventCallPtrs; // 0*
-		UnordMapWrapper <std::string, std::shared_ptr<EventHandler>>  m_EventHandlerMap;
+		long long m_eventCallAllocations; // EventCalls made because the pool was empty
+		long long m_eventCallReuses;
+		long long m_argumentAllocations; // arguments too large for the in place storage
+	};
 
-		void setState(int val);
+	/// @brief Counters of the EventBus overflow policies, calls not capacity slots
+	struct OverflowStats
+	{
+		long long m_blockedCount; // calls which waited for space
+		long long m_blockTimeoutCount; // calls rejected after waiting
+		long long m_droppedNewestCount;
+		long long m_droppedOldestCount; // queued calls dropped for newer ones
+		long long m_grownCount; // calls queued beyond m_maxCapacity
+	};
 
-		/// @brief intern
-		/// @details make a new EventCall object and queue it
-		template<typename T>
-		bool invokeEventInternal(std::string pFunctionName, 
-			T functionArgument, bool isVoid = false)//TODO use enum
+	/// @brief Recycles the EventCalls of one EventBus
+	/// @details Released calls go to a free list picked by the releasing thread,
+	///          acquire() tries its own free list first and then the others, so
+	///          calls released by the workers are reused by the producers.
+	///          After warm up an invoke does not allocate, unless the arguments
+	///          themselves do. Must outlive all calls it handed out.
+	class EventCallPool
+	{
+		struct Stripe
 		{
-			bool exists = hasCallback(pFunctionName);
-			if (getCallsCount() > m_maxCapacity || !exists)
-			{
-				if (m_verbose > 0 && !exists)
-				{
-					std::cout << "EventBus::invokeEvent No such callback " << pFunctionName
-						<< " " << std::this_thread::get_id() << "\n";
-				}
-				return false;
-			}
-			std::unique_ptr <EventCall> evCallPtr(new EventCall);
-			//add handler
-			evCallPtr->setEventHandler(m_EventHandlerMap.data[pFunctionName]);
-			std::shared_ptr <ArgumentContainerBase> argConPtr(new ArgumentContainer<T>());
-			/*
-			//TODO use a string for now, out of time unfortunately
-			*/
-			std::string argString;
-			std::stringstream ss(functionArgument);
-			if (std::istringstream(functionArgument))
-			{
-				argString = ss.str();
-			}
-			std::shared_ptr<ArgumentContainerBase> argBasePtr = evCallPtr->getArgument();
-			argBasePtr = std::shared_ptr<eventHandling::ArgumentContainerBase> 
-				(new eventHandling::ArgumentContainer<std::string>());
-			if (argBasePtr.get())
-			{
-				setContainerArgumentString(std::string(), 
-					 argBasePtr.get(), argString, ArgsTypes::stringType);
-			}
-			else if (m_verbose > 0)
-			{
-				std::cout << "EventBus::invokeEvent No argument container " << pFunctionName
-						<< " " << std::this_thread::get_id() << "\n";
+			std::mutex m_freeMtx;
+			EventCall * m_freePtr;
+			char m_pad[g_cacheLineSize];
+		};
+		Stripe m_stripes[g_callPoolStripes];
+		std::atomic<long long> m_aAllocations, m_aReuses, m_aArgumentAllocations;
+		static size_t stripeIndex();
+		EventCall * popFree(Stripe & stripe);
+	public:
+		EventCallPool();
+		~EventCallPool();
+		EventCallPool& operator = (EventCallPool&) = delete;
+		EventCallPtr acquire();
+		void release(EventCall * evCallPtr);
+		void countArgumentAllocation()
+		{
+			m_aArgumentAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+		AllocationStats getStats() const;
+	};
+
+	template<class T, class... A>
+	CallArgumentsBase * EventCall::constructArguments(std::false_type, A&&... args)
+	{
+		if (m_poolPtr)
+		{
+			m_poolPtr->countArgumentAllocation();
+		}
+		return new T(std::forward<A>(args)...);
+	}
+
+	template<class... Args, class... A>
+	void EventCall::emplaceArguments(A&&... args)
+	{
+		typedef CallArguments<Args...> ArgumentsType;
+		typedef std::integral_constant<bool, sizeof(ArgumentsType) <= g_inlineArgumentSize &&
+			alignof(ArgumentsType) <= alignof(std::max_align_t)> FitsInline;
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		destroyArguments();
+		m_argumentsPtr = constructArguments<ArgumentsType>(FitsInline(), std::forward<A>(args)...);
+		m_argumentsInline = FitsInline::value;
+	}
+
+	/// @brief Unit of work of a DispatchWorker
+	/// @details Either calls of unordered callback ids or the pending calls
+	///          of an ordered callback id, which are run as one batch
+	struct DispatchTask
+	{
+		DispatchTask() : m_lane(static_cast<int>(Priority::normal)) {}
+		EventCallPtr m_eventCallPtr; // 0..*, linked through EventCall::m_nextCallPtr
+		std::shared_ptr<EventHandler> m_batchHandlerPtr;
+		int m_lane; // Priority of the calls
+		std::chrono::steady_clock::time_point m_queuedTime; // for starvation protection
+	};
+
+	/// @brief Payload of a timer of the EventBus
+	struct TimerTask
+	{
+		TimerTask() : m_periodTicks(0) {}
+		EventCallPtr m_eventCallPtr; // one shot, made when the timer is scheduled
+		std::function<EventCallPtr()> m_makeCall; // periodic, makes the call of each period
+		uint64_t m_periodTicks; // 0 for one shot timers
+	};
+
+	/// @brief Counters of one DispatchWorker
+	struct WorkerStats
+	{
+		int m_index;
+		long long m_dispatchedCount;
+		long long m_stealCount; // tasks this worker took from other workers
+		long long m_idleNanoseconds;
+	};
+
+	/// @brief Outcome of EventBus::shutdown()
+	struct ShutdownResult
+	{
+		bool m_drained; // no calls were queued when the workers stopped
+		long long m_dispatchedCount; // calls dispatched during the shutdown
+		int m_pendingCount; // calls left in the queues, they run after reset() and run()
+		std::chrono::nanoseconds m_duration;
+	};
+
+	/// @brief Counters of EventBus::attachShmTransport()
+	struct ShmTransportStats
+	{
+		long long m_receivedCount; // frames read from the ring
+		long long m_droppedCount; // unknown id, other arguments or rejected by the overflow policy
+		long long m_fullCount; // publishes rejected for lack of space, over all publishers
+	};
+
+	/// @brief Counters of one priority lane, summed over all workers
+	struct LaneStats
+	{
+		Priority m_priority;
+		int m_queuedCalls; // current depth
+		long long m_dispatchedCount;
+		long long m_agedCount; // tasks served before higher lanes because they waited too long
+		long long m_totalWaitNanoseconds; // queued until dispatched
+		long long m_maxWaitNanoseconds;
+	};
+
+	/// @brief Latency percentiles of one callback id, see EventBus::getLatencyStats()
+	struct TopicLatencyStats
+	{
+		TopicId m_topicId;
+		std::string m_callbackId;
+		LatencyStats m_wait; // invoke until a worker took the call
+		LatencyStats m_callback; // run time of each callback
+	};
+
+	/// @brief One dispatch thread of the EventBus
+	/// @details Producers push into the lock-free inbox of the worker picked by
+	///          the callback id hash. The worker moves its inbox into one deque
+	///          per priority lane and takes tasks from the front of the lane picked
+	///          by the lane scheduling, idle workers steal from the back of the
+	///          highest lane or, while the owner is busy, from its inbox.
+	class DispatchWorker
+	{
+	public:
+		DispatchWorker(int index, size_t capacity) : m_index(index),
+			m_inbox(capacity), m_aDispatchedCount(0), m_aStealCount(0),
+			m_aIdleNanoseconds(0)
+		{
+			for (int & credit : m_laneCredits)
+			{
+				credit = 0;
 			}
+		}
+		int m_index;
+		RingQueue<DispatchTask> m_inbox; // 0..*
+		std::mutex m_tasksMtx; // m_lanes, m_laneCredits, consumer side of m_inbox
+		std::deque<DispatchTask> m_lanes[g_laneCount]; // 0..* each, by Priority
+		int m_laneCredits[g_laneCount]; // tasks left in the current weighted round
+		std::atomic<long long> m_aDispatchedCount, m_aStealCount, m_aIdleNanoseconds;
+		bool hasLocalTasks() const
+		{
+			for (const auto & lane : m_lanes)
+			{
+				if (!lane.empty())
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	class EventBus;
+
+	/// calls EventBus::replayJournal() queues with one push, at most the capacity
+	static const int g_replayBatchSize = 256;
+	/// frames the receiver of EventBus::attachShmTransport() queues with one push,
+	/// at most the capacity
+	static const int g_shmBatchSize = 256;
+
+	/// @brief Calls collected for one EventBus::invokeBatch()
+	/// @details Calls may be for different topics, they are checked when added and
+	///          queued with one push and one wakeup per dispatch worker.
+	///          Calls left in the batch are dropped when it is destroyed.
+	class EventBatch
+	{
+		friend class EventBus;
+		EventBus & m_eventBus;
+		EventCallPtr m_headPtr; // 0..*, linked through EventCall::m_nextCallPtr
+		EventCall * m_tailPtr;
+		int m_size;
+		void append(EventCallPtr evCallPtr);
+	public:
+		explicit EventBatch(EventBus & eventBus) : m_eventBus(eventBus), m_tailPtr(nullptr),
+			m_size(0) {}
+		EventBatch& operator = (EventBatch&) = delete;
+		/// @brief add a call, same rules as EventBus::invoke()
+		/// @return false in case the topic does not exist or takes other arguments
+		template<class... Args>
+		bool add(TopicId topicId, Args... args);
+		template<class... Args>
+		bool add(const std::string & callBackName, Args... args);
+		int size() const
+		{
+			return m_size;
+		}
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+		void clear()
+		{
+			m_headPtr.reset();
+			m_tailPtr = nullptr;
+			m_size = 0;
+		}
+	};
+
+	namespace details
+	{
+		/// @brief element of a range, moved in case the range is an rvalue
+		template<class Range, class E>
+		typename std::conditional<std::is_lvalue_reference<Range>::value, E&,
+			typename std::remove_reference<E>::type &&>::type forwardElement(E & element)
+		{
+			return static_cast<typename std::conditional<std::is_lvalue_reference<Range>::value,
+				E&, typename std::remove_reference<E>::type &&>::type>(element);
+		}
+	} // namespace details
+
+	/// @brief Processing Queue
+	/// @details runs in a infinite loop unless stopped
+	class EventBus : public ObjectBase
+	{
+		friend class EventBatch;
+	protected:
+		std::atomic<int> m_aStopped;// 0 running, 1 interrupt, 2 stop processing like RunState enum
+		std::atomic<int> m_aRunningWorkers;
+		std::atomic<int> m_aQueuedCalls;
+		std::atomic<int> m_aQueuedTasks; // tasks in worker inboxes and deques
+		EventCallPool m_callPool; // declared first, outlives the queued calls
+		std::vector<std::unique_ptr<DispatchWorker>> m_workers; // 1..*
+		std::shared_ptr<Journal> m_journalPtr; // std::atomic_load, queued calls share it
+		mutable std::mutex m_shmMtx; // m_shmRing, m_shmThread
+		ShmRing m_shmRing; // read by m_shmThread only
+		std::thread m_shmThread; // runShmReceiver()
+		std::atomic<bool> m_aShmStopping;
+		std::atomic<long long> m_aShmReceivedCount, m_aShmDroppedCount;
+		std::mutex m_runMtx; // m_runThread
+		std::thread m_runThread; // run() started by start(), joined by shutdown()
+		std::atomic<bool> m_aRunThreadDone; // run() of m_runThread returned
+		TopicTable<EventHandler> m_topics; // handlers by TopicId
+		std::mutex m_timerMtx; // m_timers
+		TimerWheel<TimerTask> m_timers; // milliseconds since m_timerEpoch, holds pooled calls
+		std::chrono::steady_clock::time_point m_timerEpoch;
+		std::atomic<long long> m_aNextTimerTick; // lower bound, max() without timers
+		std::atomic<int> m_aOverflowPolicy; // OverflowPolicy
+		std::atomic<long long> m_aBlockTimeoutMs;
+		std::atomic<long long> m_aBlockedCount, m_aBlockTimeoutCount, m_aDroppedNewestCount,
+			m_aDroppedOldestCount, m_aGrownCount;
+		std::atomic<int> m_aWaitingProducers;
+		std::mutex m_spaceMtx; // m_spaceCond
+		std::condition_variable m_spaceCond; // signalled when calls leave the queue
+		struct LaneCounters
+		{
+			std::atomic<int> m_aQueuedCalls;
+			std::atomic<long long> m_aDispatchedCount, m_aAgedCount, m_aWaitNanoseconds,
+				m_aMaxWaitNanoseconds;
+		};
+		LaneCounters m_laneCounters[g_laneCount]; // by Priority
+		std::atomic<int> m_aLaneScheduling; // LaneScheduling
+		std::atomic<long long> m_aLaneAgingMs; // starvation protection
+		std::atomic<int> m_aLaneWeights[g_laneCount];
+		std::atomic<int> m_aWaitStrategy; // WaitStrategy of the workers
+		std::atomic<int> m_aSpinCount;
 
-			if (evCallPtr->isValid())
-			{ 
-				m_eventCallPtrs.data.push(std::move(evCallPtr));//TODO
-				setState(1);
-				m_cond.notify_all(); // notify the condition variable 
+		void setState(int val);
+		void createWorkers(int workerCount);
+		/// @brief worker owning all calls of this handler
+		DispatchWorker & workerFor(const EventHandler & eventHandler)
+		{
+			return *m_workers[eventHandler.getCallbackHash() % m_workers.size()];
+		}
+		/// @brief dispatch loop of one worker, see run()
+		void runWorker(size_t workerIndex);
+		/// @brief hand a call to the worker of its handler, its slot is reserved
+		void enqueueCall(std::shared_ptr<EventHandler> eventHandlerPtr,
+			EventCallPtr evCallPtr);
+		/// @brief hand linked calls to their workers, one push and wakeup per worker
+		/// @details maxCalls slots have to be reserved
+		/// @return number of queued calls, calls after maxCalls are dropped
+		int enqueueCalls(EventCallPtr headPtr, int maxCalls);
+		/// @brief push the batch token of an ordered handler
+		void scheduleBatch(DispatchWorker & worker,
+			std::shared_ptr<EventHandler> eventHandlerPtr, bool notify);
+		void pushLocalTask(DispatchWorker & worker, DispatchTask && task, bool front = false);
+		bool takeLocalTask(DispatchWorker & worker, DispatchTask & task);
+		/// @brief next task of the lane picked by the lane scheduling, holding m_tasksMtx
+		bool takeLaneTask(DispatchWorker & worker, DispatchTask & task);
+		/// @brief lane of a call, the topic priority unless lane overrides it
+		/// @details ordered ids always use their topic lane to stay in FIFO order
+		int laneFor(const EventHandler & eventHandler, int lane) const
+		{
+			if (lane < 0 || lane >= g_laneCount || eventHandler.isOrdered())
+			{
+				return static_cast<int>(eventHandler.getPriority());
 			}
-			else if (m_verbose > 0)
+			return lane;
+		}
+		void initLanes();
+		bool stealTask(DispatchWorker & thief, DispatchTask & task);
+		void wakeIdleWorker(DispatchWorker & busyWorker);
+		void executeTask(DispatchWorker & worker, DispatchTask & task);
+		void dispatchCall(DispatchWorker & worker, EventCallPtr evCallPtr);
+		/// @brief take up to count free capacity slots, never waits
+		int tryReserveCalls(int count);
+		/// @brief take count capacity slots, the overflow policy decides about missing ones
+		/// @param workerIndex worker of the calls, dropOldest evicts from it first
+		/// @param mayBlock false to drop instead of waiting for OverflowPolicy::block
+		/// @return number of reserved slots
+		int reserveCalls(int count, size_t workerIndex, bool mayBlock = true);
+		/// @brief queue all calls of batch, see invokeBatch()
+		int queueBatch(EventBatch & batch, bool mayBlock);
+		/// @brief milliseconds since m_timerEpoch, rounded up for deadlines
+		uint64_t timerTick(std::chrono::steady_clock::time_point time, bool roundUp) const;
+		TimerId scheduleTimer(uint64_t deadline, TimerTask && timer);
+		/// @brief queue the calls of all expired timers, any worker may call it
+		void fireTimers();
+		bool timersDue() const
+		{
+			long long nextTick = m_aNextTimerTick.load();
+			return nextTick != std::numeric_limits<long long>::max() &&
+				static_cast<uint64_t>(nextTick) <= timerTick(std::chrono::steady_clock::now(), false);
+		}
+		template<class... Args, size_t... I>
+		EventCallPtr makeCallCopy(TopicId topicId, const std::tuple<Args...> & arguments,
+			std::index_sequence<I...>)
+		{
+			return makeCall(topicId, std::get<I>(arguments)...);
+		}
+		/// @brief add(), P are the parameters of callable
+		template<class F, class... P>
+		int addCallable(TopicId topicId, F callable, std::tuple<P...> * parameters);
+		/// @brief hand eventPtr to the handler of topicId, see add()
+		template<class... Args>
+		int addEventObject(TopicId topicId, std::shared_ptr<Event<Args...>> eventPtr);
+		/// @brief give back slots of calls which were not queued
+		void releaseCalls(int count);
+		/// @brief drop the oldest queued call, its slot is kept for the caller
+		bool evictOldestCall(size_t workerIndex);
+		/// @brief check that topicId has valid callbacks taking Args
+		/// @return queued in case a call can be made
+		template<class... Args>
+		InvokeResult checkCall(TopicId topicId)
+		{
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+			if (!eventHandlerPtr)
 			{
-				std::cout << "EventBus::invokeEvent Invalid callback in " << pFunctionName
-					<< " " << std::this_thread::get_id() << "\n";
+				EVENT_LOG_INFO(m_verbose, "EventBus::invokeEvent No such callback " << topicId.getIndex());
+				return InvokeResult::noSuchTopic;
 			}
+			if (!eventHandlerPtr->isValid())
+			{
+				EVENT_LOG_INFO(m_verbose, "EventBus::invokeEvent Invalid callback in "
+					<< eventHandlerPtr->getCallbackId());
+				return InvokeResult::invalid;
+			}
+			if (!eventHandlerPtr->acceptsArguments<Args...>())
+			{
+				EVENT_LOG_INFO(m_verbose, "EventBus::invokeEvent Wrong arguments for "
+					<< eventHandlerPtr->getCallbackId());
+				return InvokeResult::wrongArguments;
+			}
+			return InvokeResult::queued;
+		}
 
+		/// @brief intern
+		/// @details make a new EventCall object with the typed arguments
+		/// @return empty pointer in case checkCall() fails
+		template<class... Args>
+		EventCallPtr makeCall(TopicId topicId, Args&&... args)
+		{
+			if (checkCall<Args...>(topicId) != InvokeResult::queued)
+			{
+				return EventCallPtr();
+			}
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+			EventCallPtr evCallPtr = m_callPool.acquire();
+			evCallPtr->setEventHandler(eventHandlerPtr);
+			evCallPtr->emplaceArguments<typename std::decay<Args>::type...>(
+				std::forward<Args>(args)...);
+			evCallPtr->m_lane = laneFor(*eventHandlerPtr, -1);
+			return evCallPtr;
+		}
+
+		/// @brief append a call of a durable id to the journal
+		/// @details only calls without arguments or with one std::string can be
+		///          serialized, setDurable() rejects ids taking other arguments
+		/// @return false in case the journal could not take the call
+		template<class... A>
+		bool journalCall(EventCall &, const std::string &, const A&...)
+		{
+			return false;
+		}
+		bool journalCall(EventCall & evCall, const std::string & callbackId)
+		{
+			return appendJournal(evCall, callbackId, nullptr, 0, g_journalFlagNoArgument);
+		}
+		bool journalCall(EventCall & evCall, const std::string & callbackId,
+			const std::string & argument)
+		{
+			return appendJournal(evCall, callbackId, argument.data(), argument.size(), 0);
+		}
+		bool appendJournal(EventCall & evCall, const std::string & callbackId,
+			const char * argumentPtr, size_t argumentSize, uint16_t flags);
+		/// @brief timers are not journaled, a replay could not keep their time
+		bool isDurableTimer(EventHandler & eventHandler)
+		{
+			if (!eventHandler.isDurable())
+			{
+				return false;
+			}
+			EVENT_LOG_ERROR("EventBus::invokeAt timers of durable " << eventHandler.getCallbackId()
+				<< " are not supported");
 			return true;
 		}
+		/// @brief true while the thread of start() has not returned from run()
+		bool isRunThreadActive()
+		{
+			std::lock_guard<std::mutex> lk(m_runMtx);
+			return m_runThread.joinable() && !m_aRunThreadDone;
+		}
+		/// @brief read the shared memory ring until detachShmTransport()
+		void runShmReceiver();
+		/// @brief queue replayed calls, they wait for space instead of being dropped
+		/// @details the queue grows in case no worker runs which could make space
+		void queueReplayed(EventBatch & batch);
+
+		/// @brief run the callbacks of eventHandler on the calling thread
+		/// @param exceptionPtr optional, receives the first exception of a callback
+		/// @return number of successful calls
+		template<class... Args>
+		int dispatchSync(EventHandler & eventHandler, std::exception_ptr * exceptionPtr,
+			Args&&... args)
+		{
+			std::tuple<typename std::decay<Args>::type...> arguments(std::forward<Args>(args)...);
+			return eventHandler.dispatchCalls(arguments, exceptionPtr);
+		}
+
+		/// @brief intern
+		/// @details make a new EventCall object with the typed arguments and queue it,
+		///          the overflow policy applies in case the capacity is reached
+		/// @param lane Priority of the call, -1 for the priority of the topic
+		/// @param futurePtr optional, receives the future of the call, see invokeAsync()
+		template<class... Args>
+		InvokeResult invokeEventInternal(TopicId topicId, int lane, InvokeFuture * futurePtr,
+			Args&&... args)
+		{
+			InvokeResult result = checkCall<Args...>(topicId);
+			if (result != InvokeResult::queued)
+			{
+				if (futurePtr)
+				{
+					*futurePtr = InvokeFuture(result);
+				}
+				return result;
+			}
+			const std::shared_ptr<EventHandler> & topicHandlerPtr = m_topics.get(topicId);
+			if (topicHandlerPtr->isSynchronous())
+			{
+				std::exception_ptr exceptionPtr;
+				int count = dispatchSync(*topicHandlerPtr, futurePtr ? &exceptionPtr : nullptr,
+					std::forward<Args>(args)...);
+				if (futurePtr)
+				{
+					*futurePtr = InvokeFuture(InvokeResult::dispatched, count, std::move(exceptionPtr));
+				}
+				return InvokeResult::dispatched;
+			}
+			std::shared_ptr<EventHandler> eventHandlerPtr = topicHandlerPtr;
+			if (reserveCalls(1, static_cast<size_t>(workerFor(*eventHandlerPtr).m_index)) == 0)
+			{
+				result = getOverflowPolicy() == OverflowPolicy::block ?
+					InvokeResult::timedOut : InvokeResult::dropped;
+				if (futurePtr)
+				{
+					*futurePtr = InvokeFuture(result);
+				}
+				return result;
+			}
+			EventCallPtr evCallPtr = m_callPool.acquire();
+			evCallPtr->setEventHandler(eventHandlerPtr);
+			if (eventHandlerPtr->isDurable() &&
+				!journalCall(*evCallPtr, eventHandlerPtr->getCallbackId(), args...))
+			{
+				releaseCalls(1);
+				if (futurePtr)
+				{
+					*futurePtr = InvokeFuture(InvokeResult::dropped);
+				}
+				return InvokeResult::dropped;
+			}
+			evCallPtr->emplaceArguments<typename std::decay<Args>::type...>(
+				std::forward<Args>(args)...);
+			evCallPtr->m_lane = laneFor(*eventHandlerPtr, lane);
+			if (futurePtr)
+			{
+				CompletionState * completionPtr = CompletionPool::instance().acquire();
+				evCallPtr->setCompletion(completionPtr);
+				*futurePtr = InvokeFuture(completionPtr);
+			}
+			// wakes the worker loop only if it is parked
+			enqueueCall(std::move(eventHandlerPtr), std::move(evCallPtr));
+			return InvokeResult::queued;
+		}
 
 	public:
 		int m_maxCapacity;
-		EventBus(int maxCapacity = 100) : m_maxCapacity(maxCapacity) {}
+		int m_maxBatchSize; // calls of an ordered id run before the batch is requeued
+		/// @param maxCapacity maximum number of queued calls
+		/// @param workerCount number of dispatch threads started by run()
+		EventBus(int maxCapacity = 100, int workerCount = 1) : m_aStopped(0),
+			m_aRunningWorkers(0), m_aQueuedCalls(0), m_aQueuedTasks(0),
+			m_aShmStopping(false), m_aShmReceivedCount(0), m_aShmDroppedCount(0), m_aRunThreadDone(false),
+			m_timerEpoch(std::chrono::steady_clock::now()),
+			m_aNextTimerTick(std::numeric_limits<long long>::max()),
+			m_aOverflowPolicy(static_cast<int>(OverflowPolicy::dropNewest)),
+			m_aBlockTimeoutMs(100), m_aBlockedCount(0), m_aBlockTimeoutCount(0),
+			m_aDroppedNewestCount(0), m_aDroppedOldestCount(0), m_aGrownCount(0),
+			m_aWaitingProducers(0), m_aLaneScheduling(static_cast<int>(LaneScheduling::strict)),
+			m_aLaneAgingMs(50), m_aWaitStrategy(static_cast<int>(WaitStrategy::spinPark)),
+			m_aSpinCount(g_defaultSpinCount),
+			m_maxCapacity(maxCapacity), m_maxBatchSize(64)
+		{
+			initLanes();
+			createWorkers(workerCount);
+		}
+		~EventBus() override;
 		bool isValid() override
 		{
-			return !m_EventHandlerMap.empty();
+			return !m_topics.empty();
 		}
 		int getRunState();
 		int getCallbacksCount();
 		int getCallsCount();
+		int getWorkerCount();
+		/// @brief change number of dispatch workers, only while the bus is not running
+		/// @return false in case the bus is running or the calls are still queued
+		bool setWorkerCount(int workerCount);
+		std::vector<WorkerStats> getWorkerStats();
+		/// @brief EventCall pool counters, allocations stay flat once the pool is warm
+		AllocationStats getAllocationStats() const
+		{
+			return m_callPool.getStats();
+		}
+		/// @brief choose what happens to calls while m_maxCapacity calls are queued,
+		///        default is OverflowPolicy::dropNewest
+		/// @param blockTimeout longest wait of a producer for OverflowPolicy::block,
+		///        a callback invoking on its own bus can only wait for other workers
+		void setOverflowPolicy(OverflowPolicy policy,
+			std::chrono::milliseconds blockTimeout = std::chrono::milliseconds(100))
+		{
+			m_aBlockTimeoutMs = blockTimeout.count();
+			m_aOverflowPolicy = static_cast<int>(policy);
+		}
+		OverflowPolicy getOverflowPolicy() const
+		{
+			return static_cast<OverflowPolicy>(m_aOverflowPolicy.load());
+		}
+		OverflowStats getOverflowStats() const;
+		/// @brief lane order of the workers, default LaneScheduling::strict
+		/// @param agingTimeout a task waiting longer is served first whatever its
+		///        lane, so busy high lanes cannot starve the low ones
+		void setLaneScheduling(LaneScheduling scheduling,
+			std::chrono::milliseconds agingTimeout = std::chrono::milliseconds(50))
+		{
+			m_aLaneAgingMs = agingTimeout.count();
+			m_aLaneScheduling = static_cast<int>(scheduling);
+		}
+		/// @brief how idle workers wait for calls, default WaitStrategy::spinPark
+		/// @details busySpin and spinYield trade a core per idle worker for wakeup
+		///          latency, blocking saves the spinning of short idle phases.
+		///          Invokes only signal a worker which is parked, whatever the strategy.
+		/// @param spinCount checks before a worker yields or parks
+		void setWaitStrategy(WaitStrategy strategy, int spinCount = g_defaultSpinCount);
+		WaitStrategy getWaitStrategy() const
+		{
+			return static_cast<WaitStrategy>(m_aWaitStrategy.load());
+		}
+		/// @brief write the queued calls of durable ids to a journal in directory
+		/// @details see Journal, a journal which is open already is closed first
+		/// @return false in case the journal can not be opened
+		bool openJournal(const std::string & directory,
+			const JournalOptions & options = JournalOptions());
+		/// @brief sync and close the journal, calls which did not run stay in it
+		void closeJournal();
+		/// @brief queue the calls the previous process left pending in the journal
+		/// @details Call it after openJournal() and the add()s of the durable ids,
+		///          before new calls are invoked. The segments are streamed, one is
+		///          mapped at a time, and the calls are queued in batches with their
+		///          original sequence, which completes once they ran. After start()
+		///          the replay waits for queue space, so memory stays bounded by the
+		///          queue; without running workers the queue grows to hold them all.
+		///          Records of unknown ids or other arguments count as skipped.
+		/// @return counts, zero in case no journal is open or it was replayed already
+		JournalReplayStats replayJournal();
+		/// @brief invokes of durable ids are appended to the journal before they
+		///        are queued, default false
+		/// @details Only ids whose callbacks take no arguments or one std::string
+		///          can be durable. invoke(), invokeBatch() and the shared memory
+		///          transport journal their calls, timers of durable ids are rejected.
+		///          The record is done once the call was dispatched, skipped or dropped.
+		/// @return false in case the id does not exist or its arguments can not be journaled
+		bool setDurable(const std::string & pFunctionName, bool durable = true);
+		bool setDurable(TopicId topicId, bool durable = true);
+		/// @brief counters of the journal, zero while none is open
+		JournalStats getJournalStats() const;
+		/// @brief dispatch calls other processes publish with a ShmPublisher to name
+		/// @details Creates the ShmRing name in shared memory, a stale one is replaced.
+		///          A receiver thread of the bus reads the frames in batches of
+		///          g_shmBatchSize and queues them like invokeBatch(), so the
+		///          overflow policy applies and durable ids are not journaled. It
+		///          waits for frames as the wait strategy says, with spinPark the
+		///          publishers only make a syscall while it is parked. Calls with one
+		///          std::string argument or none can be published.
+		/// @param capacity ring bytes, see ShmRing::create()
+		/// @return false in case the ring can not be created
+		bool attachShmTransport(const std::string & name, size_t capacity = g_shmDefaultCapacity);
+		/// @brief stop the receiver thread and remove the ring, shutdown() calls it
+		void detachShmTransport();
+		ShmTransportStats getShmTransportStats() const;
+		/// @brief tasks a lane serves per round of LaneScheduling::weighted, default 8:4:1
+		bool setLaneWeight(Priority priority, int weight);
+		/// @brief depth and wait time per lane, indexed by Priority
+		std::vector<LaneStats> getLaneStats() const;
+		/// @brief lane of all calls of an id, default Priority::normal
+		bool setPriority(const std::string & pFunctionName, Priority priority);
+		bool setPriority(TopicId topicId, Priority priority);
+		/// @brief ordered ids run one call at a time in FIFO order (default),
+		///        calls of unordered ids can be stolen and run in parallel
+		bool setOrdered(const std::string & pFunctionName, bool ordered = true);
+		bool setOrdered(TopicId topicId, bool ordered = true);
+		/// @brief invokes of synchronous ids run the callbacks on the calling thread
+		///        like invokeSync() and return InvokeResult::dispatched, default false
+		bool setSynchronous(const std::string & pFunctionName, bool synchronous = true);
+		bool setSynchronous(TopicId topicId, bool synchronous = true);
+		/// @brief time the callbacks of every sampleInterval-th dispatch of an id
+		/// @details 1 times all, 0 none, default g_latencySampleInterval. A timed
+		///          dispatch reads the clock once per callback, the queue wait of a
+		///          call is always recorded.
+		bool setLatencySampling(const std::string & pFunctionName, int sampleInterval);
+		bool setLatencySampling(TopicId topicId, int sampleInterval);
+		/// @brief percentiles of the queue wait and callback time of an id
+		/// @details computed from lock free histograms when asked for, the
+		///          dispatch path only adds to counters. Unknown ids have no counts.
+		TopicLatencyStats getLatencyStats(TopicId topicId) const;
+		TopicLatencyStats getLatencyStats(const std::string & pFunctionName) const
+		{
+			return getLatencyStats(findTopic(pFunctionName));
+		}
+		/// @brief getLatencyStats() of all ids with recorded calls
+		std::vector<TopicLatencyStats> getLatencyStats() const;
+		/// @brief start a new measurement of all ids
+		void resetLatencyStats();
+		/// @brief record enqueue, dispatch and callbacks into the EventTrace
+		/// @details process wide, for all EventBus objects; a few ns per record
+		///          plus one clock read per callback while enabled
+		void setTracing(const bool enabled)
+		{
+			EventTrace::instance().setEnabled(enabled);
+		}
+		bool isTracing() const
+		{
+			return EventTrace::isEnabled();
+		}
+		/// @brief write the recorded events as Chrome trace JSON, see EventTrace::dump()
+		/// @return false in case path can not be written
+		bool dumpTrace(const std::string & path) const
+		{
+			return EventTrace::instance().dump(path);
+		}
+		/// @brief drop the recorded events
+		void clearTrace()
+		{
+			EventTrace::instance().clear();
+		}
 		//make a new event call object and add to queue
 		bool blockEvent(std::string pFunctionName, bool val=true);
 		void stop();
 		bool reset();
+		/// @brief run() on a thread owned by the bus, joined by shutdown() or the destructor
+		/// @details a thread of an earlier start() whose run() returned after stop()
+		///          is joined first
+		/// @return false in case the thread of an earlier start() still runs
+		bool start();
+		/// @brief stop the workers after the queued calls were handled as mode says
+		/// @details Waits until the workers returned from run(), including threads
+		///          which called run() themselves, and joins the thread of start().
+		///          Invokes during the drain are dispatched too, stop the producers
+		///          first. A bus which is not running is started for the drain.
+		///          Timers which are not due yet do not count as queued. The bus
+		///          stays stopped, reset() and run() continue with the pending calls.
+		///          Must not be called from a callback.
+		/// @param deadline end of the drain for ShutdownMode::drainUntilDeadline
+		ShutdownResult shutdown(std::chrono::steady_clock::time_point deadline,
+			ShutdownMode mode = ShutdownMode::drainUntilDeadline);
+		ShutdownResult shutdown(std::chrono::milliseconds timeout,
+			ShutdownMode mode = ShutdownMode::drainUntilDeadline)
+		{
+			return shutdown(std::chrono::steady_clock::now() + timeout, mode);
+		}
 		bool hasCallback(const std::string & pFunctionName);
 
-		template<typename T>
-		int add(T dummy, std::string pFunctionName, std::function<void(T)> functionObject);
-		//addEventHandler if needed, also used to block objects
-		template<typename T>
-		int add(std::string pFunctionName, std::function<void(T)> functionObject);
-		//back to simple, varaiadic templated on my reading list
-		bool invokeEvent(const std::string & callBackName)
+		/// @brief intern a callback id, creates the handler if needed
+		/// @details resolve once and use the TopicId overloads of add() and invoke()
+		///          to skip the string lookup per call
+		/// @return invalid TopicId in case the topic table is full
+		TopicId topic(const std::string & pFunctionName);
+		/// @return invalid TopicId in case nothing was added for pFunctionName
+		TopicId findTopic(const std::string & pFunctionName) const
+		{
+			return m_topics.find(pFunctionName);
+		}
+
+		/// @brief add a callback for pFunctionName
+		/// @details all callbacks of one name must take the same (decayed) arguments,
+		///          std::function<void()> adds a void callback
+		/// @return 1 if added, 0 if disabled, -1 failed
+		template<class... Args>
+		int add(TopicId topicId, std::function<void(Args...)> functionObject);
+		template<class... Args>
+		int add(const std::string & pFunctionName, std::function<void(Args...)> functionObject)
+		{
+			return add(topic(pFunctionName), functionObject);
+		}
+		/// @brief add a lambda, function object or function pointer
+		/// @details the parameters are deduced from callable, which is stored in
+		///          place without a std::function, see InlineFunction. Subscriber
+		///          changes copy it, state of mutable lambdas is not shared.
+		template<class F>
+		int add(TopicId topicId, F callable)
+		{
+			return addCallable(topicId, std::move(callable),
+				static_cast<typename details::CallableTraits<F>::Parameters *>(nullptr));
+		}
+		template<class F>
+		int add(const std::string & pFunctionName, F callable)
+		{
+			return add(topic(pFunctionName), std::move(callable));
+		}
+		/// @brief remove all callbacks of topicId, the id stays interned
+		/// @details calls which are queued or running finish with the callbacks they
+		///          started with, later invokes fail until a callback is added again
+		/// @return number of removed callbacks, -1 in case of an unknown id
+		int remove(TopicId topicId);
+		int remove(const std::string & pFunctionName)
+		{
+			return remove(findTopic(pFunctionName));
+		}
+
+		/// @brief queue a call of all callbacks added for callBackName
+		/// @details Arguments are stored in their own type and have to match the
+		///          arguments of the added callbacks, no conversions or RTTI.
+		///          String literals are not converted, use invoke<std::string>()
+		/// @return true in case the call was queued, or dispatched for synchronous ids
+		template<class... Args>
+		bool invoke(TopicId topicId, Args... args)
+		{
+			return isAccepted(invokeEventInternal(topicId, -1, nullptr, std::move(args)...));
+		}
+		template<class... Args>
+		bool invoke(const std::string & callBackName, Args... args)
+		{
+			return invoke(findTopic(callBackName), std::move(args)...);
+		}
+		/// @brief run all callbacks of topicId on the calling thread
+		/// @details No queue, worker wakeup or overflow policy. Blocked ids and
+		///          callbacks are skipped and exceptions of callbacks are kept like
+		///          for queued calls. The bus does not need to run, calls of the
+		///          same ordered id which are still queued may run at the same time.
+		/// @return number of successful calls, -1 in case invokeChecked() would fail
+		template<class... Args>
+		int invokeSync(TopicId topicId, Args... args)
+		{
+			if (checkCall<Args...>(topicId) != InvokeResult::queued)
+			{
+				return -1;
+			}
+			return dispatchSync(*m_topics.get(topicId), nullptr, std::move(args)...);
+		}
+		template<class... Args>
+		int invokeSync(const std::string & callBackName, Args... args)
+		{
+			return invokeSync(findTopic(callBackName), std::move(args)...);
+		}
+		/// @brief invoke() which reports the outcome of the call
+		/// @details The future is ready once the callbacks ran on a worker and
+		///          carries the number of successful calls and the first exception
+		///          of a callback. Rejected calls and synchronous ids complete at
+		///          once, see InvokeFuture::getResult(). The shared state is pooled,
+		///          waiting does not allocate per call.
+		template<class... Args>
+		InvokeFuture invokeAsync(TopicId topicId, Args... args)
+		{
+			InvokeFuture future;
+			invokeEventInternal(topicId, -1, &future, std::move(args)...);
+			return future;
+		}
+		template<class... Args>
+		InvokeFuture invokeAsync(const std::string & callBackName, Args... args)
+		{
+			return invokeAsync(findTopic(callBackName), std::move(args)...);
+		}
+		/// @brief invoke() which tells why a call was not queued
+		template<class... Args>
+		InvokeResult invokeChecked(TopicId topicId, Args... args)
+		{
+			return invokeEventInternal(topicId, -1, nullptr, std::move(args)...);
+		}
+		template<class... Args>
+		InvokeResult invokeChecked(const std::string & callBackName, Args... args)
+		{
+			return invokeEventInternal(findTopic(callBackName), -1, nullptr, std::move(args)...);
+		}
+		/// @brief invoke() in the lane of priority instead of the topic lane
+		/// @details only for unordered ids, calls of ordered ids keep their FIFO order
+		///          and use the topic lane, see setPriority()
+		template<class... Args>
+		InvokeResult invokeWithPriority(TopicId topicId, Priority priority, Args... args)
+		{
+			return invokeEventInternal(topicId, static_cast<int>(priority), nullptr,
+				std::move(args)...);
+		}
+		template<class... Args>
+		InvokeResult invokeWithPriority(const std::string & callBackName, Priority priority,
+			Args... args)
+		{
+			return invokeWithPriority(findTopic(callBackName), priority, std::move(args)...);
+		}
+		/// @brief wrap value once into a SharedPayload and queue it for all subscribers
+		/// @details subscribers are added with addShared() or take a SharedPayload<T>,
+		///          a SharedPayload can also be passed to invoke() for several topics
+		template<class T>
+		bool invokeShared(TopicId topicId, T && value)
+		{
+			return isAccepted(invokeEventInternal(topicId, -1, nullptr,
+				makeSharedPayload(std::forward<T>(value))));
+		}
+		template<class T>
+		bool invokeShared(const std::string & callBackName, T && value)
+		{
+			return invokeShared(findTopic(callBackName), std::forward<T>(value));
+		}
+		/// @brief add a subscriber which gets a const view of the payload of invokeShared()
+		template<class T>
+		int addShared(TopicId topicId, std::function<void(const T&)> functionObject)
+		{
+			std::function<void(const SharedPayload<T>&)> viewObject;
+			if (functionObject)
+			{
+				viewObject = [functionObject](const SharedPayload<T> & payload) {
+					functionObject(payload.get()); };
+			}
+			return add(topicId, viewObject);
+		}
+		template<class T>
+		int addShared(const std::string & pFunctionName, std::function<void(const T&)> functionObject)
+		{
+			return addShared(topic(pFunctionName), functionObject);
+		}
+		/// @brief queue one call per element of arguments with a single push and wakeup
+		/// @details elements are the argument of a single argument topic, they are
+		///          moved in case arguments is an rvalue
+		/// @return number of queued calls, less than the range in case the overflow
+		///         policy rejects calls or an element does not match the topic
+		template<class Range>
+		int invokeBatch(TopicId topicId, Range && arguments)
+		{
+			EventBatch batch(*this);
+			for (auto && argument : arguments)
+			{
+				if (!batch.add(topicId, details::forwardElement<Range>(argument)))
+				{
+					break;
+				}
+			}
+			return invokeBatch(batch);
+		}
+		template<class Range>
+		int invokeBatch(const std::string & callBackName, Range && arguments)
+		{
+			return invokeBatch(findTopic(callBackName), std::forward<Range>(arguments));
+		}
+		/// @brief queue all calls of batch, calls of several topics are grouped per worker
+		/// @return number of queued calls, batch is empty afterwards
+		int invokeBatch(EventBatch & batch)
+		{
+			return queueBatch(batch, true);
+		}
+
+		/// @brief queue a call at time, same rules as invoke()
+		/// @details The call is made now and kept in a timer wheel, a dispatch worker
+		///          queues it once the millisecond of time has passed, so the bus has to
+		///          run. The overflow policy applies then, OverflowPolicy::block drops
+		///          instead of stalling the worker.
+		///          Durable ids are rejected, their calls are journaled when queued.
+		/// @return handle for cancelTimer(), invalid in case the call can not be made
+		template<class... Args>
+		TimerId invokeAt(TopicId topicId, std::chrono::steady_clock::time_point time,
+			Args... args)
 		{
-			if (m_verbose > 0)
+			TimerTask timer;
+			timer.m_eventCallPtr = makeCall(topicId, std::move(args)...);
+			if (!timer.m_eventCallPtr || isDurableTimer(*timer.m_eventCallPtr->getEventHandlerPtr()))
 			{
-				std::cout << " EventBus::invokeEvent dispatch no args" << std::this_thread::get_id() << "\n";
+				return TimerId();
 			}
-			return invokeEventInternal(callBackName, false, true);
+			return scheduleTimer(timerTick(time, true), std::move(timer));
+		}
+		template<class... Args>
+		TimerId invokeAt(const std::string & callBackName,
+			std::chrono::steady_clock::time_point time, Args... args)
+		{
+			return invokeAt(findTopic(callBackName), time, std::move(args)...);
+		}
+		/// @brief invokeAt() now plus delay
+		template<class Rep, class Period, class... Args>
+		TimerId invokeAfter(TopicId topicId, std::chrono::duration<Rep, Period> delay,
+			Args... args)
+		{
+			return invokeAt(topicId, std::chrono::steady_clock::now() +
+				std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+				std::move(args)...);
+		}
+		template<class Rep, class Period, class... Args>
+		TimerId invokeAfter(const std::string & callBackName,
+			std::chrono::duration<Rep, Period> delay, Args... args)
+		{
+			return invokeAfter(findTopic(callBackName), delay, std::move(args)...);
+		}
+		/// @brief queue a copy of args every period until cancelTimer(), first after one period
+		/// @details periods missed while the bus was busy or stopped are skipped
+		template<class Rep, class Period, class... Args>
+		TimerId invokeEvery(TopicId topicId, std::chrono::duration<Rep, Period> period,
+			Args... args)
+		{
+			if (checkCall<Args...>(topicId) != InvokeResult::queued ||
+				isDurableTimer(*m_topics.get(topicId)))
+			{
+				return TimerId();
+			}
+			TimerTask timer;
+			timer.m_periodTicks = std::max<uint64_t>(1, static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::milliseconds>(period).count()));
+			std::tuple<Args...> arguments(std::move(args)...);
+			timer.m_makeCall = [this, topicId, arguments]() {
+				return makeCallCopy(topicId, arguments, std::index_sequence_for<Args...>()); };
+			return scheduleTimer(timerTick(std::chrono::steady_clock::now(), true) +
+				timer.m_periodTicks, std::move(timer));
+		}
+		template<class Rep, class Period, class... Args>
+		TimerId invokeEvery(const std::string & callBackName,
+			std::chrono::duration<Rep, Period> period, Args... args)
+		{
+			return invokeEvery(findTopic(callBackName), period, std::move(args)...);
+		}
+		/// @return false in case the timer already fired or was cancelled
+		bool cancelTimer(TimerId timerId);
+		/// @brief number of scheduled timers, periodic ones count once
+		int getTimerCount();
+		/// @brief string api, an empty argument also invokes void callbacks
+		bool invokeEvent(TopicId topicId, std::string functionArgument="")
+		{
+			EVENT_LOG_INFO(m_verbose, "EventBus::invokeEvent dispatch args " << functionArgument);
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+			if (functionArgument.empty() && eventHandlerPtr && 
+				eventHandlerPtr->acceptsArguments<>())
+			{
+				return isAccepted(invokeEventInternal(topicId, -1, nullptr));
+			}
+			return isAccepted(invokeEventInternal(topicId, -1, nullptr, std::move(functionArgument)));
+		}
+		bool invokeEvent(const std::string & callBackName, std::string functionArgument="")
+		{
+			return invokeEvent(findTopic(callBackName), std::move(functionArgument));
+		}
+		/// @brief string api of invokeAsync()
+		InvokeFuture invokeEventAsync(TopicId topicId, std::string functionArgument="")
+		{
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+			if (functionArgument.empty() && eventHandlerPtr &&
+				eventHandlerPtr->acceptsArguments<>())
+			{
+				return invokeAsync(topicId);
+			}
+			return invokeAsync(topicId, std::move(functionArgument));
+		}
+		InvokeFuture invokeEventAsync(const std::string & callBackName, std::string functionArgument="")
+		{
+			return invokeEventAsync(findTopic(callBackName), std::move(functionArgument));
 		}
-		bool invokeEvent(const std::string & callBackName, const std::string functionArgument="")
+		/// @brief string api of invokeSync()
+		int invokeEventSync(TopicId topicId, std::string functionArgument="")
 		{
-			if (m_verbose > 0)
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+			if (functionArgument.empty() && eventHandlerPtr &&
+				eventHandlerPtr->acceptsArguments<>())
 			{
-				std::cout << "EventBus::invokeEvent dispatch args" << functionArgument
-					<< std::this_thread::get_id() << "\n";
+				return invokeSync(topicId);
 			}
-			return invokeEventInternal(callBackName, functionArgument, false);
+			return invokeSync(topicId, std::move(functionArgument));
+		}
+		int invokeEventSync(const std::string & callBackName, std::string functionArgument="")
+		{
+			return invokeEventSync(findTopic(callBackName), std::move(functionArgument));
 		}
 
 		/// @brief Event loop execution function. 
-		/// @details When a new eventCall is added to queue the condition variable
-		///          signals and the thread will continue execution of the event loop. 
-		///          This function exits when stop() is called.
+		/// @details Starts one thread per additional worker and runs the first
+		///          worker on the calling thread. Calls are sharded by callback id
+		///          hash, idle workers steal single calls of unordered ids or the
+		///          whole batch of an ordered id from busy workers. Ordered ids are
+		///          processed in FIFO order, unrelated ids run in parallel.
+		///          When a new eventCall is added to queue a parked worker is woken
+		///          and continues execution of its loop. 
+		///          This function exits when stop() is called, after all workers quit.
 		///          After stopping use reset() member function to enable the state for it
 		///          to execute again
 		void run()
 		{
-			while (true)
+			std::vector<std::thread> workerThreads;
+			for (size_t i = 1; i < m_workers.size(); ++i)
 			{
-				//	lock
-				while (!m_eventCallPtrs.empty())
-				{
-					if (m_stopped == 1)
-					{
-						std::cout << "EventBus::run  m_stoppedthread " << std::this_thread::get_id() << "\n";
-						break;
-					}
-					else if (m_stopped == 2)
-					{
-						std::cout << " EventBus::run  quit " << std::this_thread::get_id() << "\n";
-						return;
-					}
-					if (m_verbose > 0)
-					{
-						std::cout << "EventBus::run  processing " <<
-							m_eventCallPtrs.data.front()->isValid() << " : " <<
-							m_eventCallPtrs.data.front()->m_name << m_stopped <<
-							" " << std::this_thread::get_id() << "\n";
-						m_eventCallPtrs.data.front()->m_verbose = 1;//DEBUG
-					}
-					//
-					if (m_eventCallPtrs.data.front()->isValid() &&
-						m_eventCallPtrs.data.front()->getRunState() != RunState::blocked)
-					{
-						//bool res = m_eventCallPtrs.data.front()->dispatchAll();
-						bool res = m_eventCallPtrs.data.front()->dispatchAllCalls();
-					}
-					m_eventCallPtrs.pop();
-				}//while
-				//wait
-				std::unique_lock<std::mutex> lk(m_runMtx);//locked?
-				m_cond.wait(lk, [&] {return m_stopped == 1; });//true: wake up
-				if (m_stopped == 2)
-				{
-					return;
-				}
-				//run
-				m_stopped = 0;
-				lk.unlock();
-				if (m_verbose > 0)
-				{
-					std::cout << " EventBus::run :: wakeup queue " <<
-						m_eventCallPtrs.size()<<" "
-						<< m_stopped << " " << std::this_thread::get_id() << "\n";
-				}
+				workerThreads.emplace_back(&EventBus::runWorker, this, i);
+			}
+			runWorker(0);
+			for (auto & workerThread : workerThreads)
+			{
+				workerThread.join();
 			}
 			return;
 		}
 	};
-		//UNfortunately could not  get this to properly work  and run out of time, TODO
-		/*
-		template <class... Args>
-		auto invoke(const std::string & callBackName, Args... args) -> decltype(dispatch(args...))
+	
+	//addEventHandler if needed, can also block invalid objects
+	// 1 if added -1 failed
+	template<class... Args>
+	int EventBus::add(TopicId topicId, std::function<void(Args...)> functionObject)
+	{
+		typedef Event<typename std::decay<Args>::type...> EventType;
+		std::shared_ptr<EventType> eventPtr(new EventType());
+		//will set blocked state for invalid objects
+		eventPtr->setCallback(functionObject);
+		return addEventObject(topicId, eventPtr);
+	}
+
+	template<class F, class... P>
+	int EventBus::addCallable(TopicId topicId, F callable, std::tuple<P...> *)
+	{
+		typedef Event<typename std::decay<P>::type...> EventType;
+		std::shared_ptr<EventType> eventPtr(new EventType());
+		eventPtr->template setCallable<P...>(std::move(callable));
+		return addEventObject(topicId, eventPtr);
+	}
+
+	template<class... Args>
+	int EventBus::addEventObject(TopicId topicId, std::shared_ptr<Event<Args...>> eventPtr)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
 		{
-			return dispatch(callBackName, args...);
+			return -1;
 		}
-		bool invoke(const std::string & callBackName)
+		EVENT_LOG_DEBUG(m_verbose, "EventBus::add :: pFunctionName " << eventHandlerPtr->getCallbackId());
+		//addEvent to handler
+		eventHandlerPtr->setBlockState(false);
+		eventPtr->m_name = eventHandlerPtr->getCallbackId();
+		if (!eventPtr->isValid() || !eventHandlerPtr->addEvent(eventPtr))
 		{
-			return invokeEventInternal(callBackName, false, true);
+			EVENT_LOG_INFO(m_verbose, "EventBus::add :: failed, other arguments or invalid "
+				<< eventHandlerPtr->getCallbackId());
+			return -1;
 		}
-		bool invoke(const std::string & callBackName,
-			const std::string & functionArgument="")
-		{
-			return invokeEventInternal(callBackName, functionArgument, false);
-		}*/
-	
-	
-	//addEventHandler if needed, can also block invalid objects
-		//last minute hack to fix the type, sorry
-	// 0 if disabled 1 if added -1 failed
-	template<typename T>
-	int EventBus::add(std::string pFunctionName, std::function<void(T)> functionObject)
+		return 1;
+	}
+
+	template<class... Args>
+	bool EventBatch::add(TopicId topicId, Args... args)
 	{
-		bool handlerExists = hasCallback(pFunctionName);
-		if (!handlerExists)
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_eventBus.m_topics.get(topicId);
+		if (eventHandlerPtr && eventHandlerPtr->isDurable())
 		{
-			m_EventHandlerMap.push(pFunctionName,
-				std::shared_ptr<EventHandler>(new EventHandler(pFunctionName)));
+			// the arguments are still needed for the record
+			EventCallPtr evCallPtr = m_eventBus.makeCall(topicId, args...);
+			if (!evCallPtr || !m_eventBus.journalCall(*evCallPtr, eventHandlerPtr->getCallbackId(), args...))
+			{
+				return false;
+			}
+			append(std::move(evCallPtr));
+			return true;
 		}
-		if (!hasCallback(pFunctionName))
+		EventCallPtr evCallPtr = m_eventBus.makeCall(topicId, std::move(args)...);
+		if (!evCallPtr)
+		{
+			return false;
+		}
+		append(std::move(evCallPtr));
+		return true;
+	}
+
+	template<class... Args>
+	bool EventBatch::add(const std::string & callBackName, Args... args)
+	{
+		return add(m_eventBus.findTopic(callBackName), std::move(args)...);
+	}
+
+	//EventHandler typed imple
+	template<class... Args>
+	bool EventHandler::addEvent(std::shared_ptr<Event<Args...>> eventObjectPtr)
+	{
+		if (!eventObjectPtr.get())
 		{
+			// rejected before it can fix the signature of the handler
+			setResultState(ResultState::invalid);
 			return false;
 		}
-		if (m_verbose > 1)
+		SignatureId signature = signatureOf<Args...>();
+		SignatureId expected = nullptr;
+		if (!m_aSignature.compare_exchange_strong(expected, signature) &&
+			expected != signature)
 		{
-			std::cout << " EventBus::add :: pFunctionName " <<
-				pFunctionName << " " << std::this_thread::get_id() << "\n";
+			return false;
 		}
-		//addEvent to handler
-		bool res = blockEvent(pFunctionName, false);
-		std::shared_ptr <EventBase> eventBasePtr(new Event<T>(pFunctionName));
-		if (!eventBasePtr)
+		// the callback is packed into the table, later changes of the event are not seen
+		typename CallbackColumn<Args...>::Callback callback = eventObjectPtr->getCallback();
+		return m_subscribers.update([&eventObjectPtr, &callback](SubscriberTable & table) {
+			// move-only arguments can only be handed to one subscriber
+			if (!details::AllCopyable<Args...>::value && !table.empty())
+			{
+				return false;
+			}
+			table.append<Args...>(std::static_pointer_cast<EventBase>(eventObjectPtr),
+				std::move(callback));
+			return true; });
+	}
+
+	template<class... Args, size_t... I>
+	bool EventHandler::invokeCallback(const typename CallbackColumn<Args...>::Callback & callback,
+		bool lastUse, std::tuple<Args...> & arguments, std::exception_ptr * exceptionPtr,
+		std::index_sequence<I...>)
+	{
+		try
 		{
-			return -1;
+			callback(lastUse, std::get<I>(arguments)...);
+			return true;
 		}
-		Event<T> * eventPtr = dynamic_cast<Event<T> *>(eventBasePtr.get());
-		if (!eventPtr)
+		catch (...)
 		{
-			if (m_verbose > 0)
+			if (exceptionPtr && !*exceptionPtr)
 			{
-				std::cout << " EventBus::add :: failed " <<
-					pFunctionName << " " << std::this_thread::get_id() << "\n";
+				*exceptionPtr = std::current_exception();
 			}
-			return -1;
 		}
+		return false;
+	}
 
-		//will set blocked state for invalid objects
-		eventPtr->setCallback(functionObject);
-		if (eventPtr->isValid())
+	template<class... Args>
+	int EventHandler::dispatchCalls(std::tuple<Args...> & arguments,
+		std::exception_ptr * exceptionPtr)
+	{
+		if (!acceptsArguments<Args...>())
+		{
+			return -1;
+		}
+		const bool traced = EventTrace::isEnabled();
+		if (isBlocked())
 		{
-			auto it = m_EventHandlerMap.data.find(pFunctionName);
-			if ((*it).second.get())
+			if (traced)
 			{
-				(*it).second->addEvent(eventBasePtr);
+				EventTrace::instance().record(TraceKind::blocked, getTraceNameId(),
+					std::chrono::steady_clock::now());
 			}
-			else
+			return 0;
+		}
+		int i = 0;
+		Subscribers::ReadView subscribers(m_subscribers);
+		const SubscriberTable * tablePtr = subscribers.get();
+		if (!tablePtr || !tablePtr->m_callbacksPtr)
+		{
+			return 0;
+		}
+		// the column is CallbackColumn<Args...>, checked in addEvent
+		const std::vector<typename CallbackColumn<Args...>::Callback> & callbacks =
+			static_cast<const CallbackColumn<Args...> &>(*tablePtr->m_callbacksPtr).m_callbacks;
+		const uint8_t * statesPtr = tablePtr->m_states.data();
+		const size_t eventCount = callbacks.size();
+		const bool sampled = takeSample();
+		if (sampled || traced)
+		{
+			EventTrace & trace = EventTrace::instance();
+			const uint32_t nameId = traced ? getTraceNameId() : 0;
+			// the end of one callback is the start of the next one
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (size_t e = 0; e < eventCount; ++e)
 			{
-				if (m_verbose > 0)
+				if (statesPtr[e] != static_cast<uint8_t>(SubscriberState::ready))
+				{
+					if (traced)
+					{
+						trace.record(TraceKind::skipped, nameId, start, std::chrono::steady_clock::duration(0),
+							0, static_cast<uint32_t>(e));
+					}
+					continue;
+				}
+				if (invokeCallback(callbacks[e], e + 1 == eventCount, arguments, exceptionPtr,
+					std::index_sequence_for<Args...>()))
 				{
-					std::cout << " EventBus::add :: failed2 " <<
-						pFunctionName << " " << std::this_thread::get_id() << "\n";
+					++i;
 				}
-				return -1;
+				std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+				if (sampled)
+				{
+					m_callbackHistogram.record(
+						std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+				}
+				if (traced)
+				{
+					trace.record(TraceKind::callback, nameId, start, end - start, 0,
+						static_cast<uint32_t>(e));
+				}
+				start = end;
 			}
+			return i;
 		}
-		else
+		for (size_t e = 0; e < eventCount; ++e)
 		{
-			if (m_verbose > 0)
+			// the last subscriber may take the arguments
+			if (statesPtr[e] == static_cast<uint8_t>(SubscriberState::ready) &&
+				invokeCallback(callbacks[e], e + 1 == eventCount, arguments, exceptionPtr,
+					std::index_sequence_for<Args...>()))
 			{
-				std::cout << " EventBus::add :: failed2 " <<
-					pFunctionName << " " << std::this_thread::get_id() << "\n";
+				++i;
 			}
-			return -1;
 		}
-		return 1;
+		return i;
 	}
-	/*
-	template <class T>
-	int EventBus:::add(T dummy, std::string pFunctionName, std::function<void(T)> functionObject)
-	{
-		return EventBus::add(pFunctionName, functionObject);
-	}
-	*/
+
 	//Event imple TODO move has trouble namespace
-	template <class T>
-	bool Event<T>::dispatch()
-	{
-		return invokeInternal(false, true);
-	}
-	template <class T>
-	template <class A>
-	bool Event<T>::dispatch(A functionArgument)
-	{
-		return invokeInternal(functionArgument, false);
-	}
-	template <class T>
-	RunState Event<T>::getRunState()
+	template <class... Args>
+	RunState Event<Args...>::getRunState()
 	{
 		return getRunStateAsEnum(m_aRunState);
 	}
-	template <class T>
-	void Event<T>::setResultState(const ResultState & val)
+	template <class... Args>
+	void Event<Args...>::setResultState(const ResultState & val)
 	{
 		m_aResultState = valueFromEnum(val);
 	}
-	template <class T>
-	void Event<T>::setRunState(const RunState & val)
+	template <class... Args>
+	void Event<Args...>::setRunState(const RunState & val)
 	{
 		m_aRunState = valueFromEnum(val);
 	}
-	template <class T>
-	ResultState Event<T>::getResultState()
+	template <class... Args>
+	ResultState Event<Args...>::getResultState()
 	{
 		return getResultStateAsEnum(m_aResultState);
 	}
 
-	template <class T>
-	bool Event<T>::invokeWithContainerArg(
+	template <class... Args>
+	bool Event<Args...>::invokeWithContainerArg(
 		std::shared_ptr<ArgumentContainerBase> argConPtr)
 	{
-		if (argConPtr.get())
-		{ 
-			std::cout << "Event<T>::invokeWithContainerArg No valid argument container "
-				<< m_name << " " << std::this_thread::get_id() << "\n";
+		if (!argConPtr.get())
+		{
+			EVENT_LOG_INFO(m_verbose, "Event<T>::invokeWithContainerArg No valid argument container "
+				<< m_name);
 		}
 		//skipping blocked objects
 		if (getRunState() == RunState::blocked 
@@ -625,133 +2346,101 @@ namespace eventHandling
 		setRunState(RunState::running);
 
 		std::lock_guard<std::mutex> l(m_dataMtx);
-		if (argConPtr.get() && argConPtr->m_argsType != ArgsTypes::voidType)
+		EVENT_LOG_INFO(m_verbose, "Event<T>:: dispatching container argument " << m_name);
+		try
 		{
-			T functionArgument;
-			bool isVoid = false;
-			bool res = getContainerArgument(argConPtr.get(), functionArgument, isVoid);//TODO change to enum
-			//TODO use return invokeInternal(functionArgument, isVoid);
-			if (m_verbose > 0)
+			if (details::ContainerInvoker<Args...>::call(m_Callback, argConPtr.get()))
 			{
-				std::cout << "EventBus::invokeEvent No argument container " << m_name
-					<< " "<< functionArgument << std::this_thread::get_id() << "\n";
-			}
-			try
-			{
-				m_Callback(functionArgument);
 				setRunState(RunState::notRunning);
 				setResultState(ResultState::success);
 				return true;
 			}
-			catch (...)
-			{
-				g_excPtr = std::current_exception();
-			}
 		}
-		else //if (argConPtr.get())
+		catch (...)
 		{
-			if (m_verbose > 0)
-			{
-				std::cout << "Event<T>:: dispatching void " << m_name
-					<< " " << std::this_thread::get_id() << "\n";
-			}
-			try
-			{
-				m_Callback;
-				setRunState(RunState::notRunning);
-				setResultState(ResultState::success);
-				return true;
-			}
-			catch (...)
-			{
-				g_excPtr = std::current_exception();
-			}
+			g_excPtr = std::current_exception();
 		}
 		setRunState(RunState::notRunning);
 		return false;
 	}
 
-	//Inital implementation, should use container as argument
-	template <class T>
-	bool Event<T>::invokeInternal(T functionArgument, bool isVoid)
+	template <class... Args>
+	bool Event<Args...>::invokeInternal(bool lastUse, Args&... args)
 	{
-		if (m_verbose > 0)
-		{
-			std::cout << "Event<T>::dispatching "
-				<< isValid() << " from " << m_name << " with argument " <<
-				functionArgument << " " << std::this_thread::get_id() << "\n";
-		}
+		EVENT_LOG_INFO(m_verbose, "Event<T>::dispatching " << isValid() << " from " << m_name);
 		//skipping blocked objects
 		if (getRunState() == RunState::blocked || getResultState() == ResultState::invalid)
 		{
-			if (m_verbose > 0)
-			{
-				std::cout << " Event<T>::invokeInternal _Skipping blocked object " << m_name
-					<< " " << std::this_thread::get_id() << "\n";
-			}
+			EVENT_LOG_INFO(m_verbose, "Event<T>::invokeInternal _Skipping blocked object " << m_name);
 			return false;
 		}
 		//set state
 		setResultState(ResultState::failed);
 		setRunState(RunState::running);
 		std::lock_guard<std::mutex> l(m_dataMtx);
-		if (isVoid)
+		try
 		{
-			try
-			{
-				m_Callback;
-			}
-			catch (...)
-			{
-				g_excPtr = std::current_exception();
-			}
+			m_Callback(lastUse, args...);
+			setRunState(RunState::notRunning);
+			setResultState(ResultState::success);
+			return true;
 		}
-		else
+		catch (...)
 		{
-			try
-			{
-				m_Callback(functionArgument);
-				setRunState(RunState::notRunning);
-				setResultState(ResultState::success);
-				return true;
-			}
-			catch (...)
-			{
-				g_excPtr = std::current_exception();
-			}
+			g_excPtr = std::current_exception();
 		}
 		setRunState(RunState::notRunning);
 		return false;
 	}
 
 	//will set blocked state for invalid objects, can be void now
-	template <class T>
-	bool Event<T>::setCallback(std::function<void(T)> callback)
+	template <class... Args>
+	template <class... P>
+	bool Event<Args...>::setCallback(std::function<void(P...)> callback)
 	{
+		return setCallable<P...>(std::move(callback));
+	}
+
+	template <class... Args>
+	template <class... P, class F>
+	bool Event<Args...>::setCallable(F callable)
+	{
+		static_assert(std::is_copy_constructible<F>::value,
+			"Event::setCallable: subscriber tables copy their callbacks");
 		setRunState(RunState::ready);
 		//not possible to distinguish invalid object and nullptr here
-		if (!callback)
+		const bool isNull = details::isNull(callable);
+		if (isNull)
 		{
 			setRunState(RunState::blocked);
 		}
-		if (std::is_same<T, void>::value)//??? TODO
+		if (sizeof...(Args) == 0)
 		{
 			m_argtype = ArgsTypes::voidType;
 		}
-		else if (typeid(T) == typeid(std::string))
+		else if (std::is_same<std::tuple<Args...>, std::tuple<std::string>>::value)
 		{
 			m_argtype = ArgsTypes::stringType;
 		}
-		else if (typeid(T) == typeid(int))
+		else if (std::is_same<std::tuple<Args...>, std::tuple<int>>::value)
 		{
 			m_argtype = ArgsTypes::intType;
 		}
 		else
 		{
-			//unsupported
+			m_argtype = ArgsTypes::unkown;
+		}
+		Callback wrapped;
+		if (!isNull)
+		{
+			// mutable, stateful callables keep their state between calls
+			wrapped = Callback([callable](bool lastUse, Args&... args) mutable {
+				(void)lastUse; // callables without parameters
+				callable(details::ArgumentPass<P>::pass(args, lastUse)...);
+			});
 		}
 		std::lock_guard<std::mutex> l(m_dataMtx);
-		m_Callback = callback;
+		m_Callback = std::move(wrapped);
 		return true;
 	}
 }//namespace
@@ -7,6 +7,7 @@
 //#endif
 
 //#include "stdafx.h"  
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include <functional>
@@ -39,7 +40,7 @@ namespace eventHandling
 	}
 	bool EventHandler::getEventCount()
 	{
-		return m_eventsPtrs.data.size();//TODO
+		return m_subscribers.size() > 0;
 	}
 	void EventHandler::setRunState(const RunState & val)
 	{
@@ -55,15 +56,15 @@ namespace eventHandling
 		std::shared_ptr<ArgumentContainerBase> argContainerPtr)
 	{
 		int i = 0;
-		size_t arry_size = m_eventsPtrs.data.size();
-		if (m_verbose > 0)
+		Subscribers::ReadView subscribers(m_subscribers);
+		EVENT_LOG_INFO(m_verbose, "EventHandler::dispatching num of events: "
+			<< subscribers.size() << " from " << m_name);
+
+		if (!subscribers.get())
 		{
-			std::cout << "EventHandler::dispatching num of events: "
-				<< arry_size << " from " << m_name << " with "
-				<< " " << std::this_thread::get_id() << "\n";
+			return 0;
 		}
-
-		for (auto & baseEventPtr : m_eventsPtrs.data)//TODO
+		for (auto & baseEventPtr : subscribers.get()->m_eventsPtrs)
 		{
 			if (!baseEventPtr.get())
 			{
@@ -74,32 +75,106 @@ namespace eventHandling
 				dynamic_cast<Event<std::string> *>(baseEventPtr.get());
 			if (eventPtr && eventPtr->isValid())
 			{
+#if EVENT_LOG_LEVEL >= 2
 				if (m_verbose > 0)
 				{
 					eventPtr->m_verbose = 1;
 				}
+#endif
 				if (eventPtr->invokeWithContainerArg(argContainerPtr))
 				{
 					++i;
 				}
 				else
 				{
-					if (m_verbose > 0)
-					{
-						std::cout << "EventHandler:: failed call  from " << baseEventPtr->m_name << " with "
-							<< " " << std::this_thread::get_id() << "\n";
-					}
+					EVENT_LOG_INFO(m_verbose, "EventHandler:: failed call  from " << baseEventPtr->m_name);
 				}
 			}
-			else if (m_verbose > 0)
+			else
 			{
-				std::cout << "EventHandler:: not dispatching bad call  from " << baseEventPtr->m_name << " with "
-						<< " " << std::this_thread::get_id() << "\n";
+				EVENT_LOG_INFO(m_verbose, "EventHandler:: not dispatching bad call  from "
+					<< baseEventPtr->m_name);
 			}
 		}
 		return i;
 	}
 
+	EventHandler::~EventHandler()
+	{
+		clearPendingCalls();
+	}
+
+	bool EventHandler::pushPendingCall(EventCallPtr evCallPtr)
+	{
+		evCallPtr->m_nextCallPtr = nullptr;
+		EventCall * tailPtr = evCallPtr.get();
+		return pushPendingCalls(std::move(evCallPtr), tailPtr);
+	}
+
+	bool EventHandler::pushPendingCalls(EventCallPtr headPtr, EventCall * tailPtr)
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_pendingMtx);
+			EventCall * evCallRawPtr = headPtr.release();
+			if (m_pendingTailPtr)
+			{
+				m_pendingTailPtr->m_nextCallPtr = evCallRawPtr;
+			}
+			else
+			{
+				m_pendingHeadPtr = evCallRawPtr;
+			}
+			m_pendingTailPtr = tailPtr;
+		}
+		bool expected = false;
+		return m_aBatchScheduled.compare_exchange_strong(expected, true);
+	}
+
+	bool EventHandler::popPendingCall(EventCallPtr & evCallPtr)
+	{
+		std::lock_guard<std::mutex> lk(m_pendingMtx);
+		if (!m_pendingHeadPtr)
+		{
+			return false;
+		}
+		EventCall * evCallRawPtr = m_pendingHeadPtr;
+		m_pendingHeadPtr = evCallRawPtr->m_nextCallPtr;
+		if (!m_pendingHeadPtr)
+		{
+			m_pendingTailPtr = nullptr;
+		}
+		evCallRawPtr->m_nextCallPtr = nullptr;
+		evCallPtr.reset(evCallRawPtr);
+		return true;
+	}
+
+	void EventHandler::clearPendingCalls()
+	{
+		EventCallPtr evCallPtr;
+		while (popPendingCall(evCallPtr))
+		{
+			evCallPtr.reset();
+		}
+	}
+
+	bool EventHandler::finishBatch()
+	{
+		m_aBatchScheduled = false;
+		bool empty = true;
+		{
+			std::lock_guard<std::mutex> lk(m_pendingMtx);
+			empty = m_pendingHeadPtr == nullptr;
+		}
+		if (empty)
+		{
+			return false;
+		}
+		// a producer may have seen the flag still set, take over its scheduling
+		bool expected = false;
+		return m_aBatchScheduled.compare_exchange_strong(expected, true);
+	}
+
+	// untyped events are only dispatched by dispatchAllCalls
 	bool EventHandler::addEvent(std::shared_ptr <EventBase> eventObjectPtr)
 	{
 		if (!eventObjectPtr.get())
@@ -107,11 +182,91 @@ namespace eventHandling
 			setResultState(ResultState::invalid);//TODO
 			return false;
 		}
-		m_eventsPtrs.data.emplace_back(eventObjectPtr);//TODO
-		return true;
+		return m_subscribers.update([&eventObjectPtr](SubscriberTable & table) {
+			table.appendUntyped(std::move(eventObjectPtr));
+			return true; });
+	}
+
+	bool EventHandler::removeEvent(const std::shared_ptr<EventBase> & eventObjectPtr)
+	{
+		return m_subscribers.update([&eventObjectPtr](SubscriberTable & table) {
+			auto it = std::find(table.m_eventsPtrs.begin(), table.m_eventsPtrs.end(), eventObjectPtr);
+			if (it == table.m_eventsPtrs.end())
+			{
+				return false;
+			}
+			table.erase(static_cast<size_t>(it - table.m_eventsPtrs.begin()));
+			return true; });
+	}
+
+	int EventHandler::removeAllEvents()
+	{
+		int removed = 0;
+		m_subscribers.update([&removed](SubscriberTable & table) {
+			removed = static_cast<int>(table.size());
+			table = SubscriberTable();
+			return removed > 0; });
+		return removed;
 	}
 
 	// EventCall
+	// an EventCallPtr owns the calls linked after it
+	void EventCallDeleter::operator()(EventCall * evCallPtr) const
+	{
+		while (evCallPtr)
+		{
+			EventCall * nextPtr = evCallPtr->m_nextCallPtr;
+			evCallPtr->m_nextCallPtr = nullptr;
+			if (evCallPtr->m_poolPtr)
+			{
+				evCallPtr->m_poolPtr->release(evCallPtr);
+			}
+			else
+			{
+				delete evCallPtr;
+			}
+			evCallPtr = nextPtr;
+		}
+	}
+	void EventCall::destroyArguments()
+	{
+		if (!m_argumentsPtr)
+		{
+			return;
+		}
+		if (m_argumentsInline)
+		{
+			m_argumentsPtr->~CallArgumentsBase();
+		}
+		else
+		{
+			delete m_argumentsPtr;
+		}
+		m_argumentsPtr = nullptr;
+		m_argumentsInline = false;
+	}
+	void EventCall::abandonCompletion()
+	{
+		if (m_completionPtr)
+		{
+			m_completionPtr->complete(-1, static_cast<int>(InvokeResult::dropped), nullptr);
+			m_completionPtr->release();
+			m_completionPtr = nullptr;
+		}
+	}
+	void EventCall::recycle()
+	{
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		abandonCompletion();
+		destroyArguments();
+		m_EventHandlerPtr.reset();
+		m_functionArgumentContainerPtr.reset();
+		m_aRunState = 0;
+		m_aResultState = 0;
+		m_nextCallPtr = nullptr;
+		m_traceId = 0;
+		m_journalPtr.reset();
+	}
 	std::string EventCall::getCallbackId()
 	{
 		if (m_EventHandlerPtr.get())
@@ -158,69 +313,1446 @@ namespace eventHandling
 		}
 		setRunState(RunState::running);
 		setResultState(ResultState::failed);
-		if (m_verbose > 0)
-		{
-			std::cout << "EventCall:: dispatchAllCalls():" << m_EventHandlerPtr->m_name
-				<< " " << std::this_thread::get_id() << "\n";
-		}
+		EVENT_LOG_INFO(m_verbose, "EventCall:: dispatchAllCalls():" << m_EventHandlerPtr->m_name);
 		int res = -1;
+		std::exception_ptr exceptionPtr;
 		std::lock_guard<std::mutex> lk(m_dataMtx);
 		try
 		{
-			res = m_EventHandlerPtr->dispatchAllCalls(m_functionArgumentContainerPtr);
+			if (m_argumentsPtr)
+			{
+				res = m_argumentsPtr->dispatch(*m_EventHandlerPtr,
+					m_completionPtr ? &exceptionPtr : nullptr);
+			}
+			else
+			{
+				res = m_EventHandlerPtr->dispatchAllCalls(m_functionArgumentContainerPtr);
+			}
 		}
 		catch (...)
 		{
-			g_excPtr = std::current_exception();
+			exceptionPtr = std::current_exception();
 		}
 		setRunState(RunState::notRunning);
-		setResultState(ResultState::success);
+		setResultState(res < 0 ? ResultState::invalid : ResultState::success);
+		if (m_completionPtr)
+		{
+			m_completionPtr->complete(res, static_cast<int>(res < 0 ?
+				InvokeResult::invalid : InvokeResult::completed), std::move(exceptionPtr));
+			m_completionPtr->release();
+			m_completionPtr = nullptr;
+		}
 		return res;
 	}
 
+	// EventCallPool
+	EventCallPool::EventCallPool() : m_aAllocations(0), m_aReuses(0), m_aArgumentAllocations(0)
+	{
+		for (auto & stripe : m_stripes)
+		{
+			stripe.m_freePtr = nullptr;
+		}
+	}
+	EventCallPool::~EventCallPool()
+	{
+		for (auto & stripe : m_stripes)
+		{
+			while (EventCall * evCallPtr = popFree(stripe))
+			{
+				delete evCallPtr;
+			}
+		}
+	}
+	size_t EventCallPool::stripeIndex()
+	{
+		static thread_local size_t index =
+			std::hash<std::thread::id>()(std::this_thread::get_id()) % g_callPoolStripes;
+		return index;
+	}
+	EventCall * EventCallPool::popFree(Stripe & stripe)
+	{
+		std::lock_guard<std::mutex> lk(stripe.m_freeMtx);
+		EventCall * evCallPtr = stripe.m_freePtr;
+		if (evCallPtr)
+		{
+			stripe.m_freePtr = evCallPtr->m_nextCallPtr;
+			evCallPtr->m_nextCallPtr = nullptr;
+		}
+		return evCallPtr;
+	}
+	EventCallPtr EventCallPool::acquire()
+	{
+		size_t first = stripeIndex();
+		for (size_t i = 0; i < g_callPoolStripes; ++i)
+		{
+			EventCall * evCallPtr = popFree(m_stripes[(first + i) % g_callPoolStripes]);
+			if (evCallPtr)
+			{
+				m_aReuses.fetch_add(1, std::memory_order_relaxed);
+				evCallPtr->setUpdateTimeStamp();
+				return EventCallPtr(evCallPtr);
+			}
+		}
+		m_aAllocations.fetch_add(1, std::memory_order_relaxed);
+		EventCallPtr evCallPtr(new EventCall);
+		evCallPtr->m_poolPtr = this;
+		return evCallPtr;
+	}
+	void EventCallPool::release(EventCall * evCallPtr)
+	{
+		evCallPtr->recycle();
+		Stripe & stripe = m_stripes[stripeIndex()];
+		std::lock_guard<std::mutex> lk(stripe.m_freeMtx);
+		evCallPtr->m_nextCallPtr = stripe.m_freePtr;
+		stripe.m_freePtr = evCallPtr;
+	}
+	AllocationStats EventCallPool::getStats() const
+	{
+		AllocationStats stats;
+		stats.m_eventCallAllocations = m_aAllocations.load();
+		stats.m_eventCallReuses = m_aReuses.load();
+		stats.m_argumentAllocations = m_aArgumentAllocations.load();
+		return stats;
+	}
+
+	// EventBatch
+	void EventBatch::append(EventCallPtr evCallPtr)
+	{
+		EventCall * evCallRawPtr = evCallPtr.get();
+		evCallRawPtr->m_nextCallPtr = nullptr;
+		if (m_tailPtr)
+		{
+			m_tailPtr->m_nextCallPtr = evCallPtr.release();
+		}
+		else
+		{
+			m_headPtr = std::move(evCallPtr);
+		}
+		m_tailPtr = evCallRawPtr;
+		++m_size;
+	}
+
 	//EventBus
+	EventBus::~EventBus()
+	{
+		detachShmTransport();
+		if (m_runThread.joinable())
+		{
+			shutdown(std::chrono::steady_clock::now(), ShutdownMode::abort);
+		}
+		closeJournal();
+		// pending calls hold their handler, break the cycle while the pool is alive
+		for (int i = 0; i < m_topics.size(); ++i)
+		{
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(TopicId(i));
+			if (eventHandlerPtr)
+			{
+				eventHandlerPtr->clearPendingCalls();
+			}
+		}
+	}
 	bool EventBus::hasCallback(const std::string & pFunctionName)
 	{
-		return m_EventHandlerMap.data.find(pFunctionName) != m_EventHandlerMap.data.end();//TODO
+		return m_topics.find(pFunctionName).isValid();
+	}
+	TopicId EventBus::topic(const std::string & pFunctionName)
+	{
+		return m_topics.intern(pFunctionName, [&pFunctionName]() {
+			return std::make_shared<EventHandler>(pFunctionName); });
 	}
 	void EventBus::setState(int val)
 	{
-		std::unique_lock<std::mutex> lk(m_runMtx);
-		m_stopped = val;
+		m_aStopped = val;
+		for (auto & workerPtr : m_workers)
+		{
+			workerPtr->m_inbox.wake();
+		}
+		{
+			// blocked producers give up on stop
+			std::lock_guard<std::mutex> lk(m_spaceMtx);
+			m_spaceCond.notify_all();
+		}
 		return;
 	}
 	int EventBus::getCallbacksCount()
 	{
-		return static_cast<int>(m_EventHandlerMap.data.size());//TODO
+		return m_topics.size();
 	}
 	int EventBus::getCallsCount()
 	{
-		return static_cast<int>(m_eventCallPtrs.data.size());//TODO
+		return m_aQueuedCalls;
 	}
-	void EventBus::stop()
+	int EventBus::getWorkerCount()
 	{
-		setState(2);
-		m_cond.notify_all();
+		return static_cast<int>(m_workers.size());
 	}
-	bool EventBus::reset()
+	bool EventBus::setWorkerCount(int workerCount)
 	{
-		setState(0);
-		m_cond.notify_all();
+		if (workerCount < 1 || m_aRunningWorkers > 0 || getCallsCount() > 0)
+		{
+			return false;
+		}
+		createWorkers(workerCount);
+		return true;
+	}
+	std::vector<WorkerStats> EventBus::getWorkerStats()
+	{
+		std::vector<WorkerStats> res;
+		for (auto & workerPtr : m_workers)
+		{
+			WorkerStats stats;
+			stats.m_index = workerPtr->m_index;
+			stats.m_dispatchedCount = workerPtr->m_aDispatchedCount;
+			stats.m_stealCount = workerPtr->m_aStealCount;
+			stats.m_idleNanoseconds = workerPtr->m_aIdleNanoseconds;
+			res.push_back(stats);
+		}
+		return res;
+	}
+	int EventBus::remove(TopicId topicId)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return -1;
+		}
+		return eventHandlerPtr->removeAllEvents();
+	}
+	bool EventBus::setOrdered(const std::string & pFunctionName, bool ordered)
+	{
+		return setOrdered(findTopic(pFunctionName), ordered);
+	}
+	bool EventBus::setOrdered(TopicId topicId, bool ordered)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return false;
+		}
+		eventHandlerPtr->setOrdered(ordered);
+		return true;
+	}
+	bool EventBus::setSynchronous(const std::string & pFunctionName, bool synchronous)
+	{
+		return setSynchronous(findTopic(pFunctionName), synchronous);
+	}
+	bool EventBus::setSynchronous(TopicId topicId, bool synchronous)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return false;
+		}
+		eventHandlerPtr->setSynchronous(synchronous);
+		return true;
+	}
+	bool EventBus::setDurable(const std::string & pFunctionName, bool durable)
+	{
+		return setDurable(findTopic(pFunctionName), durable);
+	}
+	bool EventBus::setDurable(TopicId topicId, bool durable)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return false;
+		}
+		if (durable && !eventHandlerPtr->acceptsArguments<>() &&
+			!eventHandlerPtr->acceptsArguments<std::string>())
+		{
+			EVENT_LOG_ERROR("EventBus::setDurable arguments of " << eventHandlerPtr->getCallbackId()
+				<< " can not be journaled");
+			return false;
+		}
+		eventHandlerPtr->setDurable(durable);
+		return true;
+	}
+	bool EventBus::openJournal(const std::string & directory, const JournalOptions & options)
+	{
+		closeJournal();
+		std::shared_ptr<Journal> journalPtr = std::make_shared<Journal>();
+		if (!journalPtr->open(directory, options))
+		{
+			EVENT_LOG_ERROR("EventBus::openJournal can not open " << directory);
+			return false;
+		}
+		std::atomic_store(&m_journalPtr, journalPtr);
+		return true;
+	}
+	void EventBus::closeJournal()
+	{
+		std::shared_ptr<Journal> journalPtr = std::atomic_exchange(&m_journalPtr,
+			std::shared_ptr<Journal>());
+		if (journalPtr)
+		{
+			journalPtr->close();
+		}
+	}
+	JournalStats EventBus::getJournalStats() const
+	{
+		std::shared_ptr<Journal> journalPtr = std::atomic_load(&m_journalPtr);
+		if (!journalPtr)
+		{
+			JournalStats stats = {};
+			return stats;
+		}
+		return journalPtr->getStats();
+	}
+	JournalReplayStats EventBus::replayJournal()
+	{
+		std::shared_ptr<Journal> journalPtr = std::atomic_load(&m_journalPtr);
+		if (!journalPtr)
+		{
+			JournalReplayStats stats = {};
+			return stats;
+		}
+		EventBatch batch(*this);
+		// a batch larger than the queue would never get its slots
+		const int batchSize = std::max(1, std::min(g_replayBatchSize, m_maxCapacity));
+		std::string callbackId;
+		TopicId topicId = findTopic(callbackId);
+		JournalReplayStats stats = journalPtr->replay([this, &journalPtr, &batch, batchSize,
+			&callbackId, &topicId](const JournalRecordView & record) {
+			// records of one id tend to follow each other
+			if (record.m_nameSize != callbackId.size() ||
+				std::memcmp(record.m_namePtr, callbackId.data(), record.m_nameSize) != 0)
+			{
+				callbackId.assign(record.m_namePtr, record.m_nameSize);
+				topicId = findTopic(callbackId);
+			}
+			EventCallPtr evCallPtr = (record.m_flags & g_journalFlagNoArgument) ? makeCall(topicId) :
+				makeCall(topicId, std::string(record.m_argumentPtr, record.m_argumentSize));
+			if (!evCallPtr)
+			{
+				return false;
+			}
+			evCallPtr->setJournal(journalPtr, record.m_sequence);
+			batch.append(std::move(evCallPtr));
+			if (batch.size() >= batchSize)
+			{
+				queueReplayed(batch);
+			}
+			return true;
+		});
+		queueReplayed(batch);
+		EVENT_LOG_INFO(m_verbose, "EventBus::replayJournal replayed " << stats.m_replayedCount
+			<< " skipped " << stats.m_skippedCount << " corrupt " << stats.m_corruptCount);
+		return stats;
+	}
+	void EventBus::queueReplayed(EventBatch & batch)
+	{
+		EventCallPtr headPtr = std::move(batch.m_headPtr);
+		const int count = batch.size();
+		batch.clear();
+		if (!headPtr)
+		{
+			return;
+		}
+		int reserved = tryReserveCalls(count);
+		if (reserved < count)
+		{
+			auto dispatching = [this] {
+				return m_aStopped != 2 && (m_aRunningWorkers > 0 || isRunThreadActive());
+			};
+			++m_aWaitingProducers;
+			{
+				std::unique_lock<std::mutex> lk(m_spaceMtx);
+				while (reserved < count && dispatching())
+				{
+					reserved += tryReserveCalls(count - reserved);
+					if (reserved < count)
+					{
+						m_spaceCond.wait_for(lk, std::chrono::milliseconds(1));
+					}
+				}
+			}
+			--m_aWaitingProducers;
+			if (reserved < count)
+			{
+				m_aQueuedCalls += count - reserved;
+				m_aGrownCount += count - reserved;
+			}
+		}
+		enqueueCalls(std::move(headPtr), count);
+	}
+	bool EventBus::attachShmTransport(const std::string & name, size_t capacity)
+	{
+		detachShmTransport();
+		std::lock_guard<std::mutex> lk(m_shmMtx);
+		if (!m_shmRing.create(name, capacity))
+		{
+			EVENT_LOG_ERROR("EventBus::attachShmTransport can not create " << name);
+			return false;
+		}
+		m_aShmStopping = false;
+		m_shmThread = std::thread(&EventBus::runShmReceiver, this);
+		return true;
+	}
+	void EventBus::detachShmTransport()
+	{
+		std::lock_guard<std::mutex> lk(m_shmMtx);
+		if (!m_shmThread.joinable())
+		{
+			return;
+		}
+		m_aShmStopping = true;
+		m_shmRing.wake();
+		m_shmThread.join();
+		m_shmRing.close();
+	}
+	ShmTransportStats EventBus::getShmTransportStats() const
+	{
+		ShmTransportStats stats;
+		stats.m_receivedCount = m_aShmReceivedCount;
+		stats.m_droppedCount = m_aShmDroppedCount;
+		std::lock_guard<std::mutex> lk(m_shmMtx);
+		stats.m_fullCount = m_shmRing.getFullCount();
+		return stats;
+	}
+	void EventBus::runShmReceiver()
+	{
+		EventBatch batch(*this);
+		// a batch larger than the queue would never get its slots
+		const size_t batchSize = static_cast<size_t>(std::max(1, std::min(g_shmBatchSize, m_maxCapacity)));
+		std::string callbackId;
+		TopicId topicId = findTopic(callbackId);
+		long long dropped = 0;
+		auto onFrame = [this, &batch, &callbackId, &topicId, &dropped](const ShmFrameView & frame) {
+			if (frame.m_nameSize != callbackId.size() ||
+				std::memcmp(frame.m_namePtr, callbackId.data(), frame.m_nameSize) != 0)
+			{
+				callbackId.assign(frame.m_namePtr, frame.m_nameSize);
+				topicId = findTopic(callbackId);
+			}
+			EventCallPtr evCallPtr = (frame.m_flags & g_shmFlagNoArgument) ? makeCall(topicId) :
+				makeCall(topicId, std::string(frame.m_argumentPtr, frame.m_argumentSize));
+			if (!evCallPtr)
+			{
+				++dropped;
+				return;
+			}
+			if (evCallPtr->getEventHandlerPtr()->isDurable() &&
+				!appendJournal(*evCallPtr, callbackId, frame.m_argumentPtr, frame.m_argumentSize,
+					(frame.m_flags & g_shmFlagNoArgument) ? g_journalFlagNoArgument : 0))
+			{
+				++dropped;
+				return;
+			}
+			batch.append(std::move(evCallPtr));
+		};
+		while (!m_aShmStopping)
+		{
+			const size_t count = m_shmRing.consume(onFrame, batchSize);
+			if (count == 0)
+			{
+				const WaitStrategy strategy = getWaitStrategy();
+				m_shmRing.waitForFrame(std::chrono::milliseconds(100),
+					strategy == WaitStrategy::blocking ? 0 : m_aSpinCount.load(),
+					strategy != WaitStrategy::busySpin);
+				continue;
+			}
+			const int size = batch.size();
+			dropped += size - queueBatch(batch, true);
+			m_aShmReceivedCount += static_cast<long long>(count);
+			m_aShmDroppedCount += dropped;
+			dropped = 0;
+		}
+	}
+	bool EventBus::appendJournal(EventCall & evCall, const std::string & callbackId,
+		const char * argumentPtr, size_t argumentSize, uint16_t flags)
+	{
+		std::shared_ptr<Journal> journalPtr = std::atomic_load(&m_journalPtr);
+		if (!journalPtr)
+		{
+			return true;// durable once a journal is open
+		}
+		uint64_t sequence = journalPtr->append(callbackId, argumentPtr, argumentSize, flags);
+		if (sequence == 0)
+		{
+			EVENT_LOG_ERROR("EventBus::invokeEvent journal append failed for " << callbackId);
+			return false;
+		}
+		evCall.setJournal(std::move(journalPtr), sequence);
 		return true;
 	}
+	bool EventBus::setLatencySampling(const std::string & pFunctionName, int sampleInterval)
+	{
+		return setLatencySampling(findTopic(pFunctionName), sampleInterval);
+	}
+	bool EventBus::setLatencySampling(TopicId topicId, int sampleInterval)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return false;
+		}
+		eventHandlerPtr->setSampleInterval(sampleInterval);
+		return true;
+	}
+	TopicLatencyStats EventBus::getLatencyStats(TopicId topicId) const
+	{
+		TopicLatencyStats stats = TopicLatencyStats();
+		stats.m_topicId = topicId;
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (eventHandlerPtr)
+		{
+			stats.m_callbackId = eventHandlerPtr->getCallbackId();
+			stats.m_wait = eventHandlerPtr->getWaitHistogram().getStats();
+			stats.m_callback = eventHandlerPtr->getCallbackHistogram().getStats();
+		}
+		return stats;
+	}
+	std::vector<TopicLatencyStats> EventBus::getLatencyStats() const
+	{
+		std::vector<TopicLatencyStats> res;
+		for (int i = 0; i < m_topics.size(); ++i)
+		{
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(TopicId(i));
+			if (eventHandlerPtr && (eventHandlerPtr->getWaitHistogram().getCount() > 0 ||
+				eventHandlerPtr->getCallbackHistogram().getCount() > 0))
+			{
+				res.push_back(getLatencyStats(TopicId(i)));
+			}
+		}
+		return res;
+	}
+	void EventBus::resetLatencyStats()
+	{
+		for (int i = 0; i < m_topics.size(); ++i)
+		{
+			const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(TopicId(i));
+			if (eventHandlerPtr)
+			{
+				eventHandlerPtr->getWaitHistogram().reset();
+				eventHandlerPtr->getCallbackHistogram().reset();
+			}
+		}
+	}
+	void EventBus::createWorkers(int workerCount)
+	{
+		m_workers.clear();
+		for (int i = 0; i < std::max(workerCount, 1); ++i)
+		{
+			// every worker can hold the whole capacity, calls may all be for one id
+			m_workers.emplace_back(new DispatchWorker(i,
+				static_cast<size_t>(std::max(m_maxCapacity, 1)) + 1));
+			m_workers.back()->m_inbox.parker().setStrategy(getWaitStrategy(), m_aSpinCount);
+		}
+	}
+	void EventBus::setWaitStrategy(WaitStrategy strategy, int spinCount)
+	{
+		m_aSpinCount = spinCount;
+		m_aWaitStrategy = static_cast<int>(strategy);
+		for (auto & workerPtr : m_workers)
+		{
+			// parked workers wake up and wait again with the new strategy
+			workerPtr->m_inbox.parker().setStrategy(strategy, spinCount);
+		}
+	}
+
+	void EventBus::scheduleBatch(DispatchWorker & worker,
+		std::shared_ptr<EventHandler> eventHandlerPtr, bool notify)
+	{
+		DispatchTask task;
+		task.m_lane = static_cast<int>(eventHandlerPtr->getPriority());
+		task.m_queuedTime = std::chrono::steady_clock::now();
+		task.m_batchHandlerPtr = std::move(eventHandlerPtr);
+		++m_aQueuedTasks;
+		if (!worker.m_inbox.tryPush(std::move(task), notify))
+		{
+			// the calls are queued already, the batch must not get lost
+			--m_aQueuedTasks;
+			pushLocalTask(worker, std::move(task));
+			if (notify)
+			{
+				worker.m_inbox.parker().notify();
+			}
+		}
+	}
+
+	void EventBus::enqueueCall(std::shared_ptr<EventHandler> eventHandlerPtr,
+		EventCallPtr evCallPtr)
+	{
+		DispatchWorker & worker = workerFor(*eventHandlerPtr);
+		DispatchTask task;
+		evCallPtr->m_queuedTime = std::chrono::steady_clock::now();
+		if (EventTrace::isEnabled())
+		{
+			evCallPtr->traceEnqueue();
+		}
+		++m_laneCounters[evCallPtr->m_lane].m_aQueuedCalls;
+		if (eventHandlerPtr->isOrdered())
+		{
+			if (!eventHandlerPtr->pushPendingCall(std::move(evCallPtr)))
+			{
+				return;// batch is already scheduled
+			}
+			scheduleBatch(worker, std::move(eventHandlerPtr), true);
+		}
+		else
+		{
+			task.m_lane = evCallPtr->m_lane;
+			task.m_queuedTime = evCallPtr->m_queuedTime;
+			task.m_eventCallPtr = std::move(evCallPtr);
+			++m_aQueuedTasks;
+			if (!worker.m_inbox.tryPush(std::move(task)))
+			{
+				// inbox is full after OverflowPolicy::grow, the slot is reserved already
+				--m_aQueuedTasks;
+				pushLocalTask(worker, std::move(task));
+				worker.m_inbox.parker().notify();
+			}
+		}
+		if (worker.m_inbox.size() > 1)
+		{
+			// the owner is busy, let an idle worker steal
+			wakeIdleWorker(worker);
+		}
+	}
+
+	int EventBus::tryReserveCalls(int count)
+	{
+		int queued = m_aQueuedCalls.load();
+		int reserved = 0;
+		do
+		{
+			reserved = std::min(count, std::max(0, m_maxCapacity - queued));
+			if (reserved == 0)
+			{
+				return 0;
+			}
+		} while (!m_aQueuedCalls.compare_exchange_weak(queued, queued + reserved));
+		return reserved;
+	}
+
+	int EventBus::reserveCalls(int count, size_t workerIndex, bool mayBlock)
+	{
+		int reserved = tryReserveCalls(count);
+		int missing = count - reserved;
+		if (missing == 0)
+		{
+			return reserved;
+		}
+		switch (getOverflowPolicy())
+		{
+		case OverflowPolicy::grow:
+			m_aQueuedCalls += missing;
+			m_aGrownCount += missing;
+			return count;
+		case OverflowPolicy::dropOldest:
+			while (missing > 0 && evictOldestCall(workerIndex))
+			{
+				--missing;
+				++reserved;
+			}
+			m_aDroppedNewestCount += missing;
+			return reserved;
+		case OverflowPolicy::block:
+		{
+			if (!mayBlock)
+			{
+				m_aDroppedNewestCount += missing;
+				return reserved;
+			}
+			m_aBlockedCount += missing;
+			auto deadline = std::chrono::steady_clock::now() +
+				std::chrono::milliseconds(m_aBlockTimeoutMs.load());
+			// registered before the check below, dispatchCall() notifies
+			++m_aWaitingProducers;
+			{
+				std::unique_lock<std::mutex> lk(m_spaceMtx);
+				while (reserved < count && m_aStopped != 2)
+				{
+					reserved += tryReserveCalls(count - reserved);
+					if (reserved < count &&
+						m_spaceCond.wait_until(lk, deadline) == std::cv_status::timeout)
+					{
+						reserved += tryReserveCalls(count - reserved);
+						break;
+					}
+				}
+			}
+			--m_aWaitingProducers;
+			if (reserved < count)
+			{
+				m_aBlockTimeoutCount += count - reserved;
+			}
+			return reserved;
+		}
+		default:
+			m_aDroppedNewestCount += missing;
+			return reserved;
+		}
+	}
+
+	void EventBus::releaseCalls(int count)
+	{
+		if (count <= 0)
+		{
+			return;
+		}
+		m_aQueuedCalls -= count;
+		if (m_aWaitingProducers > 0)
+		{
+			std::lock_guard<std::mutex> lk(m_spaceMtx);
+			m_spaceCond.notify_all();
+		}
+	}
+
+	bool EventBus::evictOldestCall(size_t workerIndex)
+	{
+		EventCallPtr evictedPtr; // released after the lock
+		for (size_t i = 0; i < m_workers.size() && !evictedPtr; ++i)
+		{
+			DispatchWorker & worker = *m_workers[(workerIndex + i) % m_workers.size()];
+			std::lock_guard<std::mutex> lk(worker.m_tasksMtx);
+			DispatchTask inboxTask;
+			while (worker.m_inbox.tryPop(inboxTask))
+			{
+				worker.m_lanes[inboxTask.m_lane].push_back(std::move(inboxTask));
+			}
+			// lowest lane first, the front task is the oldest one of a lane,
+			// a running task is not in the lanes
+			for (int lane = g_laneCount - 1; lane >= 0 && !evictedPtr; --lane)
+			{
+				std::deque<DispatchTask> & tasks = worker.m_lanes[lane];
+				for (auto it = tasks.begin(); it != tasks.end(); ++it)
+				{
+					if (it->m_eventCallPtr)
+					{
+						EventCall * nextPtr = it->m_eventCallPtr->m_nextCallPtr;
+						it->m_eventCallPtr->m_nextCallPtr = nullptr;
+						evictedPtr = std::move(it->m_eventCallPtr);
+						it->m_eventCallPtr.reset(nextPtr);
+						if (!nextPtr)
+						{
+							tasks.erase(it);
+							--m_aQueuedTasks;
+						}
+						break;
+					}
+					// an empty batch is finished when it runs
+					if (it->m_batchHandlerPtr && it->m_batchHandlerPtr->popPendingCall(evictedPtr))
+					{
+						break;
+					}
+				}
+			}
+		}
+		if (!evictedPtr)
+		{
+			return false;
+		}
+		--m_laneCounters[evictedPtr->m_lane].m_aQueuedCalls;
+		++m_aDroppedOldestCount;
+		evictedPtr->completeJournal();
+		return true;
+	}
+
+	OverflowStats EventBus::getOverflowStats() const
+	{
+		OverflowStats stats;
+		stats.m_blockedCount = m_aBlockedCount;
+		stats.m_blockTimeoutCount = m_aBlockTimeoutCount;
+		stats.m_droppedNewestCount = m_aDroppedNewestCount;
+		stats.m_droppedOldestCount = m_aDroppedOldestCount;
+		stats.m_grownCount = m_aGrownCount;
+		return stats;
+	}
+
+	void EventBus::initLanes()
+	{
+		const int weights[g_laneCount] = { 8, 4, 1 };
+		for (int lane = 0; lane < g_laneCount; ++lane)
+		{
+			LaneCounters & counters = m_laneCounters[lane];
+			counters.m_aQueuedCalls = 0;
+			counters.m_aDispatchedCount = 0;
+			counters.m_aAgedCount = 0;
+			counters.m_aWaitNanoseconds = 0;
+			counters.m_aMaxWaitNanoseconds = 0;
+			m_aLaneWeights[lane] = weights[lane];
+		}
+	}
+
+	bool EventBus::setLaneWeight(Priority priority, int weight)
+	{
+		if (weight < 1)
+		{
+			return false;
+		}
+		m_aLaneWeights[static_cast<int>(priority)] = weight;
+		return true;
+	}
+
+	std::vector<LaneStats> EventBus::getLaneStats() const
+	{
+		std::vector<LaneStats> res;
+		for (int lane = 0; lane < g_laneCount; ++lane)
+		{
+			const LaneCounters & counters = m_laneCounters[lane];
+			LaneStats stats;
+			stats.m_priority = static_cast<Priority>(lane);
+			stats.m_queuedCalls = counters.m_aQueuedCalls;
+			stats.m_dispatchedCount = counters.m_aDispatchedCount;
+			stats.m_agedCount = counters.m_aAgedCount;
+			stats.m_totalWaitNanoseconds = counters.m_aWaitNanoseconds;
+			stats.m_maxWaitNanoseconds = counters.m_aMaxWaitNanoseconds;
+			res.push_back(stats);
+		}
+		return res;
+	}
+
+	bool EventBus::setPriority(const std::string & pFunctionName, Priority priority)
+	{
+		return setPriority(findTopic(pFunctionName), priority);
+	}
+	bool EventBus::setPriority(TopicId topicId, Priority priority)
+	{
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(topicId);
+		if (!eventHandlerPtr)
+		{
+			return false;
+		}
+		eventHandlerPtr->setPriority(priority);
+		return true;
+	}
+
+	void EventBus::wakeIdleWorker(DispatchWorker & busyWorker)
+	{
+		for (auto & workerPtr : m_workers)
+		{
+			if (workerPtr.get() != &busyWorker && workerPtr->m_inbox.parker().isParked())
+			{
+				workerPtr->m_inbox.parker().notify();
+				return;
+			}
+		}
+	}
+
+	int EventBus::queueBatch(EventBatch & batch, bool mayBlock)
+	{
+		EventCallPtr headPtr = std::move(batch.m_headPtr);
+		const int count = batch.size();
+		batch.clear();
+		if (!headPtr)
+		{
+			return 0;
+		}
+		const EventHandler * eventHandlerPtr = headPtr->getEventHandlerPtr();
+		size_t workerIndex = eventHandlerPtr ?
+			static_cast<size_t>(workerFor(*eventHandlerPtr).m_index) : 0;
+		int reserved = reserveCalls(count, workerIndex, mayBlock);
+		if (reserved < count)
+		{
+			// calls after the reserved ones are dropped by enqueueCalls(), their
+			// journal records are done
+			int queueable = 0;
+			for (EventCall * evCallRawPtr = headPtr.get(); evCallRawPtr;
+				evCallRawPtr = evCallRawPtr->m_nextCallPtr)
+			{
+				EventHandler * handlerPtr = evCallRawPtr->getEventHandlerPtr();
+				if (!handlerPtr || !handlerPtr->isValid())
+				{
+					continue;
+				}
+				if (++queueable > reserved)
+				{
+					evCallRawPtr->completeJournal();
+				}
+			}
+		}
+		int queued = enqueueCalls(std::move(headPtr), reserved);
+		releaseCalls(reserved - queued);
+		return queued;
+	}
+
+	uint64_t EventBus::timerTick(std::chrono::steady_clock::time_point time, bool roundUp) const
+	{
+		if (time <= m_timerEpoch)
+		{
+			return 0;
+		}
+		auto elapsed = time - m_timerEpoch;
+		if (roundUp)
+		{
+			// a timer never fires before its time
+			elapsed += std::chrono::milliseconds(1) - std::chrono::steady_clock::duration(1);
+		}
+		return static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+	}
+
+	TimerId EventBus::scheduleTimer(uint64_t deadline, TimerTask && timer)
+	{
+		TimerId timerId;
+		bool earlier = false;
+		{
+			std::lock_guard<std::mutex> lk(m_timerMtx);
+			timerId = m_timers.schedule(deadline, std::move(timer));
+			long long nextTick = static_cast<long long>(std::min<uint64_t>(m_timers.nextExpiry(),
+				static_cast<uint64_t>(std::numeric_limits<long long>::max())));
+			earlier = nextTick < m_aNextTimerTick;
+			m_aNextTimerTick = nextTick;
+		}
+		if (earlier)
+		{
+			// the first worker parks until the next timer
+			m_workers[0]->m_inbox.parker().notify();
+		}
+		return timerId;
+	}
+
+	void EventBus::fireTimers()
+	{
+		std::unique_lock<std::mutex> lk(m_timerMtx, std::try_to_lock);
+		if (!lk.owns_lock())
+		{
+			return;// another worker is at it
+		}
+		const uint64_t now = timerTick(std::chrono::steady_clock::now(), false);
+		EventBatch batch(*this);
+		m_timers.advance(now, [&batch, now](TimerTask & timer, uint64_t & deadline) {
+			if (timer.m_periodTicks == 0)
+			{
+				batch.append(std::move(timer.m_eventCallPtr));
+				return false;
+			}
+			EventCallPtr evCallPtr = timer.m_makeCall();
+			if (evCallPtr)
+			{
+				batch.append(std::move(evCallPtr));
+			}
+			// missed periods are skipped, no burst after a stall
+			deadline += ((now - deadline) / timer.m_periodTicks + 1) * timer.m_periodTicks;
+			return true;
+		});
+		m_aNextTimerTick = static_cast<long long>(std::min<uint64_t>(m_timers.nextExpiry(),
+			static_cast<uint64_t>(std::numeric_limits<long long>::max())));
+		lk.unlock();
+		if (!batch.empty())
+		{
+			queueBatch(batch, false);
+		}
+	}
+
+	bool EventBus::cancelTimer(TimerId timerId)
+	{
+		std::lock_guard<std::mutex> lk(m_timerMtx);
+		return m_timers.cancel(timerId);
+	}
+
+	int EventBus::getTimerCount()
+	{
+		std::lock_guard<std::mutex> lk(m_timerMtx);
+		return static_cast<int>(m_timers.size());
+	}
+
+	int EventBus::enqueueCalls(EventCallPtr headPtr, int maxCalls)
+	{
+		struct WorkerChain
+		{
+			EventCall * m_headPtr;
+			EventCall * m_tailPtr;
+			bool m_touched;
+		};
+		// one chain per worker and lane, reused by the producer thread
+		static thread_local std::vector<WorkerChain> chains;
+		chains.assign(m_workers.size() * g_laneCount, WorkerChain{ nullptr, nullptr, false });
+		const auto now = std::chrono::steady_clock::now();
+		const bool traced = EventTrace::isEnabled();
+		int queued = 0;
+		EventCall * evCallRawPtr = headPtr.release();
+		while (evCallRawPtr && queued < maxCalls)
+		{
+			std::shared_ptr<EventHandler> eventHandlerPtr = evCallRawPtr->getEventHandler();
+			if (!eventHandlerPtr || !eventHandlerPtr->isValid())
+			{
+				EventCall * nextPtr = evCallRawPtr->m_nextCallPtr;
+				evCallRawPtr->m_nextCallPtr = nullptr;
+				EventCallPtr invalidPtr(evCallRawPtr);
+				evCallRawPtr = nextPtr;
+				continue;
+			}
+			DispatchWorker & worker = workerFor(*eventHandlerPtr);
+			const int lane = evCallRawPtr->m_lane;
+			WorkerChain & chain = chains[worker.m_index * g_laneCount + lane];
+			// the first chain of a worker marks it for the wakeup
+			chains[worker.m_index * g_laneCount].m_touched = true;
+			// run of consecutive calls of the same id
+			EventCall * runTailPtr = evCallRawPtr;
+			runTailPtr->m_queuedTime = now;
+			if (traced)
+			{
+				runTailPtr->traceEnqueue();
+			}
+			int runSize = 1;
+			while (runTailPtr->m_nextCallPtr && queued + runSize < maxCalls &&
+				runTailPtr->m_nextCallPtr->getEventHandlerPtr() == eventHandlerPtr.get())
+			{
+				runTailPtr = runTailPtr->m_nextCallPtr;
+				runTailPtr->m_queuedTime = now;
+				if (traced)
+				{
+					runTailPtr->traceEnqueue();
+				}
+				++runSize;
+			}
+			EventCall * nextPtr = runTailPtr->m_nextCallPtr;
+			runTailPtr->m_nextCallPtr = nullptr;
+			m_laneCounters[lane].m_aQueuedCalls += runSize;
+			queued += runSize;
+			if (eventHandlerPtr->isOrdered())
+			{
+				if (eventHandlerPtr->pushPendingCalls(EventCallPtr(evCallRawPtr), runTailPtr))
+				{
+					scheduleBatch(worker, std::move(eventHandlerPtr), false);
+				}
+			}
+			else
+			{
+				if (chain.m_tailPtr)
+				{
+					chain.m_tailPtr->m_nextCallPtr = evCallRawPtr;
+				}
+				else
+				{
+					chain.m_headPtr = evCallRawPtr;
+				}
+				chain.m_tailPtr = runTailPtr;
+			}
+			evCallRawPtr = nextPtr;
+		}
+		// no reserved slot, dropped
+		EventCallPtr droppedPtr(evCallRawPtr);
+		for (auto & workerPtr : m_workers)
+		{
+			DispatchWorker & worker = *workerPtr;
+			bool chained = false;
+			for (int lane = 0; lane < g_laneCount; ++lane)
+			{
+				WorkerChain & chain = chains[worker.m_index * g_laneCount + lane];
+				if (!chain.m_headPtr)
+				{
+					continue;
+				}
+				chained = true;
+				DispatchTask task;
+				task.m_lane = lane;
+				task.m_queuedTime = now;
+				task.m_eventCallPtr.reset(chain.m_headPtr);
+				++m_aQueuedTasks;
+				if (!worker.m_inbox.tryPush(std::move(task), false))
+				{
+					--m_aQueuedTasks;
+					pushLocalTask(worker, std::move(task));
+				}
+			}
+			if (chains[worker.m_index * g_laneCount].m_touched)
+			{
+				// one wakeup per worker and batch
+				worker.m_inbox.parker().notify();
+				if (worker.m_inbox.size() > 1 || chained)
+				{
+					wakeIdleWorker(worker);
+				}
+			}
+		}
+		return queued;
+	}
+
+	void EventBus::pushLocalTask(DispatchWorker & worker, DispatchTask && task, bool front)
+	{
+		std::lock_guard<std::mutex> lk(worker.m_tasksMtx);
+		std::deque<DispatchTask> & tasks = worker.m_lanes[task.m_lane];
+		if (front)
+		{
+			tasks.push_front(std::move(task));
+		}
+		else
+		{
+			tasks.push_back(std::move(task));
+		}
+		++m_aQueuedTasks;
+	}
+
+	// the inbox is single consumer, it is only popped while holding m_tasksMtx
+	bool EventBus::takeLocalTask(DispatchWorker & worker, DispatchTask & task)
+	{
+		std::lock_guard<std::mutex> lk(worker.m_tasksMtx);
+		DispatchTask inboxTask;
+		while (worker.m_inbox.tryPop(inboxTask))
+		{
+			worker.m_lanes[inboxTask.m_lane].push_back(std::move(inboxTask));
+		}
+		if (!takeLaneTask(worker, task))
+		{
+			return false;
+		}
+		--m_aQueuedTasks;
+		if (worker.hasLocalTasks())
+		{
+			wakeIdleWorker(worker);
+		}
+		return true;
+	}
+
+	bool EventBus::takeLaneTask(DispatchWorker & worker, DispatchTask & task)
+	{
+		if (!worker.hasLocalTasks())
+		{
+			return false;
+		}
+		// starvation protection, the longest waiting front task past the aging timeout
+		auto now = std::chrono::steady_clock::now();
+		auto agingTimeout = std::chrono::milliseconds(m_aLaneAgingMs.load());
+		int lane = -1;
+		for (int l = 0; l < g_laneCount; ++l)
+		{
+			if (!worker.m_lanes[l].empty() &&
+				now - worker.m_lanes[l].front().m_queuedTime > agingTimeout &&
+				(lane < 0 || worker.m_lanes[l].front().m_queuedTime <
+					worker.m_lanes[lane].front().m_queuedTime))
+			{
+				lane = l;
+			}
+		}
+		if (lane >= 0)
+		{
+			// only counted when a higher lane had to wait for it
+			for (int l = 0; l < lane; ++l)
+			{
+				if (!worker.m_lanes[l].empty())
+				{
+					++m_laneCounters[lane].m_aAgedCount;
+					break;
+				}
+			}
+		}
+		else if (static_cast<LaneScheduling>(m_aLaneScheduling.load()) == LaneScheduling::weighted)
+		{
+			// each non empty lane serves up to its weight, then the credits are refilled
+			for (int round = 0; round < 2 && lane < 0; ++round)
+			{
+				for (int l = 0; l < g_laneCount && lane < 0; ++l)
+				{
+					if (!worker.m_lanes[l].empty() && worker.m_laneCredits[l] > 0)
+					{
+						lane = l;
+					}
+				}
+				if (lane < 0)
+				{
+					for (int l = 0; l < g_laneCount; ++l)
+					{
+						worker.m_laneCredits[l] = m_aLaneWeights[l];
+					}
+				}
+			}
+			--worker.m_laneCredits[lane];
+		}
+		else
+		{
+			lane = 0;
+			while (worker.m_lanes[lane].empty())
+			{
+				++lane;
+			}
+		}
+		task = std::move(worker.m_lanes[lane].front());
+		worker.m_lanes[lane].pop_front();
+		return true;
+	}
+
+	bool EventBus::stealTask(DispatchWorker & thief, DispatchTask & task)
+	{
+		for (size_t i = 1; i < m_workers.size(); ++i)
+		{
+			DispatchWorker & victim = *m_workers[(thief.m_index + i) % m_workers.size()];
+			std::unique_lock<std::mutex> lk(victim.m_tasksMtx, std::try_to_lock);
+			if (!lk.owns_lock())
+			{
+				continue;
+			}
+			// newest task of the highest lane, else the oldest of a busy owner's inbox
+			int lane = 0;
+			while (lane < g_laneCount && victim.m_lanes[lane].empty())
+			{
+				++lane;
+			}
+			if (lane < g_laneCount)
+			{
+				task = std::move(victim.m_lanes[lane].back());
+				victim.m_lanes[lane].pop_back();
+			}
+			else if (!victim.m_inbox.tryPop(task))
+			{
+				continue;
+			}
+			--m_aQueuedTasks;
+			++thief.m_aStealCount;
+			return true;
+		}
+		return false;
+	}
+
+	void EventBus::dispatchCall(DispatchWorker & worker, EventCallPtr evCallPtr)
+	{
+		releaseCalls(1);
+		LaneCounters & counters = m_laneCounters[evCallPtr->m_lane];
+		const auto dispatchStart = std::chrono::steady_clock::now();
+		long long waitNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			dispatchStart - evCallPtr->m_queuedTime).count();
+		--counters.m_aQueuedCalls;
+		++counters.m_aDispatchedCount;
+		counters.m_aWaitNanoseconds += waitNanoseconds;
+		long long maxWait = counters.m_aMaxWaitNanoseconds;
+		while (waitNanoseconds > maxWait &&
+			!counters.m_aMaxWaitNanoseconds.compare_exchange_weak(maxWait, waitNanoseconds))
+		{
+		}
+		if (EventHandler * eventHandlerPtr = evCallPtr->getEventHandlerPtr())
+		{
+			eventHandlerPtr->getWaitHistogram().record(waitNanoseconds);
+		}
+		EVENT_LOG_INFO(m_verbose, "EventBus::run  processing " << evCallPtr->isValid() << " : "
+			<< evCallPtr->m_name << " worker " << worker.m_index);
+#if EVENT_LOG_LEVEL >= 2
+		if (m_verbose > 0)
+		{
+			evCallPtr->m_verbose = 1;//DEBUG
+		}
+#endif
+		const bool dispatched = evCallPtr->isValid() &&
+			evCallPtr->getRunState() != RunState::blocked;
+		if (dispatched)
+		{
+			evCallPtr->dispatchAllCalls();
+		}
+		evCallPtr->completeJournal();
+		EventHandler * tracedHandlerPtr = evCallPtr->getEventHandlerPtr();
+		if (tracedHandlerPtr && EventTrace::isEnabled())
+		{
+			if (dispatched)
+			{
+				EventTrace::instance().record(TraceKind::dispatch, tracedHandlerPtr->getTraceNameId(),
+					dispatchStart, std::chrono::steady_clock::now() - dispatchStart, evCallPtr->m_traceId);
+			}
+			else
+			{
+				EventTrace::instance().record(TraceKind::skipped, tracedHandlerPtr->getTraceNameId(),
+					dispatchStart, std::chrono::steady_clock::duration(0), evCallPtr->m_traceId);
+			}
+		}
+		++worker.m_aDispatchedCount;
+	}
+
+	void EventBus::executeTask(DispatchWorker & worker, DispatchTask & task)
+	{
+		if (task.m_eventCallPtr)
+		{
+			EventCall * evCallRawPtr = task.m_eventCallPtr.release();
+			for (int i = 0; evCallRawPtr; ++i)
+			{
+				if (i > 0 && (i == m_maxBatchSize || m_aStopped == 2))
+				{
+					// rest of a chain from invokeBatch, thieves may take it
+					task.m_eventCallPtr.reset(evCallRawPtr);
+					pushLocalTask(worker, std::move(task), m_aStopped == 2);
+					wakeIdleWorker(worker);
+					return;
+				}
+				EventCall * nextPtr = evCallRawPtr->m_nextCallPtr;
+				evCallRawPtr->m_nextCallPtr = nullptr;
+				dispatchCall(worker, EventCallPtr(evCallRawPtr));
+				evCallRawPtr = nextPtr;
+			}
+			return;
+		}
+		std::shared_ptr<EventHandler> eventHandlerPtr = task.m_batchHandlerPtr;
+		if (!eventHandlerPtr)
+		{
+			return;
+		}
+		EventCallPtr evCallPtr;
+		for (int i = 0; i < m_maxBatchSize; ++i)
+		{
+			if (m_aStopped == 2)
+			{
+				// keep the batch scheduled, it continues after reset()
+				pushLocalTask(worker, std::move(task), true);
+				return;
+			}
+			if (!eventHandlerPtr->popPendingCall(evCallPtr))
+			{
+				break;
+			}
+			dispatchCall(worker, std::move(evCallPtr));
+		}
+		if (eventHandlerPtr->finishBatch())
+		{
+			// back of the deque, other ids get their turn and thieves may take it
+			pushLocalTask(worker, std::move(task));
+		}
+	}
+
+	void EventBus::runWorker(size_t workerIndex)
+	{
+		DispatchWorker & worker = *m_workers[workerIndex];
+		auto stopRequested = [this] { return m_aStopped.load() == 2; };
+		++m_aRunningWorkers;
+		while (!stopRequested())
+		{
+			if (timersDue())
+			{
+				fireTimers();
+			}
+			DispatchTask task;
+			if (takeLocalTask(worker, task) || stealTask(worker, task))
+			{
+				executeTask(worker, task);
+				continue;
+			}
+			auto idleStart = std::chrono::steady_clock::now();
+			auto parkTimeout = std::chrono::milliseconds(100);
+			const long long nextTimerTick = m_aNextTimerTick;
+			if (workerIndex == 0 && nextTimerTick != std::numeric_limits<long long>::max())
+			{
+				// wake for the next timer, an earlier timer changes nextTimerTick
+				long long untilTimer = nextTimerTick -
+					static_cast<long long>(timerTick(idleStart, false));
+				parkTimeout = std::min(parkTimeout,
+					std::chrono::milliseconds(std::max(untilTimer, 0LL)));
+			}
+			auto workAvailable = [this, &worker, &stopRequested, workerIndex, nextTimerTick] {
+				return stopRequested() || !worker.m_inbox.empty() || m_aQueuedTasks > 0 ||
+					(workerIndex == 0 && m_aNextTimerTick != nextTimerTick); };
+			worker.m_inbox.parker().wait(workAvailable, parkTimeout);
+			worker.m_aIdleNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - idleStart).count();
+		}
+		EVENT_LOG_INFO(m_verbose, "EventBus::run  quit");
+		--m_aRunningWorkers;
+	}
+
+	void EventBus::stop()
+	{
+		setState(2);
+	}
+	bool EventBus::reset()
+	{
+		setState(0);
+		return true;
+	}
+	bool EventBus::start()
+	{
+		std::lock_guard<std::mutex> lk(m_runMtx);
+		if (m_runThread.joinable())
+		{
+			if (!m_aRunThreadDone)
+			{
+				return false;
+			}
+			// run() returned after stop(), only the thread is left
+			m_runThread.join();
+		}
+		m_aRunThreadDone = false;
+		m_runThread = std::thread([this] {
+			run();
+			m_aRunThreadDone = true; });
+		return true;
+	}
+	ShutdownResult EventBus::shutdown(std::chrono::steady_clock::time_point deadline,
+		ShutdownMode mode)
+	{
+		const auto shutdownStart = std::chrono::steady_clock::now();
+		// no new calls from other processes, the drain covers the received ones
+		detachShmTransport();
+		auto dispatchedCount = [this] {
+			long long count = 0;
+			for (auto & workerPtr : m_workers)
+			{
+				count += workerPtr->m_aDispatchedCount;
+			}
+			return count;
+		};
+		const long long dispatchedBefore = dispatchedCount();
+		if (mode != ShutdownMode::abort && getCallsCount() > 0 && m_aRunningWorkers == 0 &&
+			(mode == ShutdownMode::drain || shutdownStart < deadline))
+		{
+			// nobody would drain, run the workers for it
+			reset();
+			if (!start())
+			{
+				EVENT_LOG_INFO(m_verbose, "EventBus::shutdown the run thread is still starting");
+			}
+		}
+		if (mode != ShutdownMode::abort)
+		{
+			// releaseCalls() notifies m_spaceCond while producers are registered
+			++m_aWaitingProducers;
+			{
+				std::unique_lock<std::mutex> lk(m_spaceMtx);
+				while (getCallsCount() > 0 && m_aStopped != 2)
+				{
+					if (m_aRunningWorkers == 0 && !isRunThreadActive())
+					{
+						// nothing drains, the calls are reported as pending
+						EVENT_LOG_ERROR("EventBus::shutdown no worker runs to drain "
+							<< getCallsCount() << " calls");
+						break;
+					}
+					auto wakeTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+					if (mode == ShutdownMode::drainUntilDeadline)
+					{
+						if (std::chrono::steady_clock::now() >= deadline)
+						{
+							break;
+						}
+						wakeTime = std::min(wakeTime, deadline);
+					}
+					m_spaceCond.wait_until(lk, wakeTime);
+				}
+			}
+			--m_aWaitingProducers;
+		}
+		stop();
+		std::thread runThread;
+		{
+			std::lock_guard<std::mutex> lk(m_runMtx);
+			runThread = std::move(m_runThread);
+		}
+		if (runThread.joinable())
+		{
+			runThread.join();
+		}
+		// threads which called run() themselves finish their current callback
+		while (m_aRunningWorkers > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		ShutdownResult result;
+		result.m_pendingCount = getCallsCount();
+		result.m_drained = result.m_pendingCount == 0;
+		result.m_dispatchedCount = dispatchedCount() - dispatchedBefore;
+		result.m_duration = std::chrono::steady_clock::now() - shutdownStart;
+		EVENT_LOG_INFO(m_verbose, "EventBus::shutdown dispatched " << result.m_dispatchedCount
+			<< " pending " << result.m_pendingCount);
+		return result;
+	}
 
 	int EventBus::getRunState()
 	{
-		std::unique_lock<std::mutex> lk(m_runMtx);
-		return m_stopped;
+		return m_aStopped;
 	}
 
 	bool EventBus::blockEvent(std::string pFunctionName, bool val)
 	{
-		bool exists = hasCallback(pFunctionName) && m_EventHandlerMap.data[pFunctionName].get();
-		if (exists)
+		const std::shared_ptr<EventHandler> & eventHandlerPtr = m_topics.get(
+			findTopic(pFunctionName));
+		if (eventHandlerPtr)
 		{
-			m_EventHandlerMap.data[pFunctionName]->setBlockState(val);//TODO
+			eventHandlerPtr->setBlockState(val);
 			return true;
 		}
 		return false;
@@ -0,0 +1,271 @@
+/// @file eventLog.h
+/// This file contains compile time leveled, asynchronous logging for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#include "ringQueue.h"
+
+/// @brief highest level compiled in: 0 none, 1 errors, 2 info, 3 debug
+/// @details messages above it are removed by the preprocessor, including the
+///          formatting of their arguments. Default 1 with NDEBUG, else 3.
+#ifndef EVENT_LOG_LEVEL
+#ifdef NDEBUG
+#define EVENT_LOG_LEVEL 1
+#else
+#define EVENT_LOG_LEVEL 3
+#endif
+#endif
+
+/// @brief write message, a << chain, in case level is compiled in and verbose >= level - 1
+#define EVENT_LOG_WRITE(level, verbose, message) \
+	do \
+	{ \
+		if ((verbose) >= (level) - 1) \
+		{ \
+			::eventHandling::LogLine eventLogLine(level); \
+			eventLogLine.stream() << message; \
+		} \
+	} while (0)
+
+#if EVENT_LOG_LEVEL >= 1
+/// logged whatever the verbosity
+#define EVENT_LOG_ERROR(message) EVENT_LOG_WRITE(1, 0, message)
+#else
+#define EVENT_LOG_ERROR(message) ((void)0)
+#endif
+#if EVENT_LOG_LEVEL >= 2
+/// logged for m_verbose > 0
+#define EVENT_LOG_INFO(verbose, message) EVENT_LOG_WRITE(2, verbose, message)
+#else
+#define EVENT_LOG_INFO(verbose, message) ((void)0)
+#endif
+#if EVENT_LOG_LEVEL >= 3
+/// logged for m_verbose > 1
+#define EVENT_LOG_DEBUG(verbose, message) EVENT_LOG_WRITE(3, verbose, message)
+#else
+#define EVENT_LOG_DEBUG(verbose, message) ((void)0)
+#endif
+
+namespace eventHandling
+{
+	/// size of one log message including its header, longer messages are cut
+	static const size_t g_logRecordSize = 256;
+	/// messages a thread can have in flight before new ones are dropped
+	static const size_t g_logRingSize = 256;
+
+	/// @brief One message in the ring of its thread
+	struct LogRecord
+	{
+		std::chrono::system_clock::time_point m_time;
+		std::thread::id m_threadId;
+		int m_level;
+		char m_text[g_logRecordSize - sizeof(std::chrono::system_clock::time_point) -
+			sizeof(std::thread::id) - sizeof(int)];
+	};
+
+	/// @brief Asynchronous sink of the EVENT_LOG macros
+	/// @details Every logging thread writes into its own lock-free ring, a
+	///          background thread drains all rings into the output stream. A
+	///          thread whose ring is full drops the message instead of waiting,
+	///          so logging never serializes dispatching on the output stream.
+	///          The background thread starts with the first message.
+	class EventLog
+	{
+		/// ring of one thread, the log keeps it until it was drained after thread exit
+		struct ThreadRing
+		{
+			ThreadRing() : m_records(g_logRingSize), m_aClosed(false) {}
+			RingQueue<LogRecord> m_records;
+			std::atomic<bool> m_aClosed;
+		};
+		/// marks the ring of a thread closed at thread exit
+		struct ThreadHandle
+		{
+			std::shared_ptr<ThreadRing> m_ringPtr;
+			~ThreadHandle()
+			{
+				if (m_ringPtr)
+				{
+					m_ringPtr->m_aClosed = true;
+				}
+			}
+		};
+		std::mutex m_ringsMtx; // m_rings, m_outputPtr, m_drainThread
+		std::vector<std::shared_ptr<ThreadRing>> m_rings;
+		std::ostream * m_outputPtr;
+		std::thread m_drainThread;
+		std::mutex m_drainMtx; // m_drainCond
+		std::condition_variable m_drainCond;
+		std::atomic<bool> m_aStopped;
+		std::atomic<long long> m_aWrittenCount, m_aDroppedCount;
+
+		EventLog() : m_outputPtr(&std::cout), m_aStopped(false), m_aWrittenCount(0),
+			m_aDroppedCount(0) {}
+		ThreadRing & threadRing()
+		{
+			static thread_local ThreadHandle handle;
+			if (!handle.m_ringPtr)
+			{
+				handle.m_ringPtr = std::make_shared<ThreadRing>();
+				std::lock_guard<std::mutex> lk(m_ringsMtx);
+				m_rings.push_back(handle.m_ringPtr);
+				if (!m_drainThread.joinable())
+				{
+					m_drainThread = std::thread(&EventLog::runDrain, this);
+				}
+			}
+			return *handle.m_ringPtr;
+		}
+		void runDrain()
+		{
+			while (!m_aStopped.load())
+			{
+				if (flush() == 0)
+				{
+					std::unique_lock<std::mutex> lk(m_drainMtx);
+					m_drainCond.wait_for(lk, std::chrono::milliseconds(10),
+						[this] { return m_aStopped.load(); });
+				}
+			}
+			flush();
+		}
+		static const char * levelName(int level)
+		{
+			return level <= 1 ? "error" : level == 2 ? "info" : "debug";
+		}
+	public:
+		EventLog& operator = (EventLog&) = delete;
+		~EventLog()
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_drainMtx);
+				m_aStopped = true;
+			}
+			m_drainCond.notify_all();
+			if (m_drainThread.joinable())
+			{
+				m_drainThread.join();
+			}
+		}
+		static EventLog & instance()
+		{
+			static EventLog log;
+			return log;
+		}
+		/// @brief queue a message of the calling thread, dropped while its ring is full
+		void write(LogRecord && record)
+		{
+			if (threadRing().m_records.tryPush(std::move(record), false))
+			{
+				m_aWrittenCount.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				m_aDroppedCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		/// @brief write the queued messages now, also done by the background thread
+		/// @return number of written messages
+		size_t flush()
+		{
+			std::lock_guard<std::mutex> lk(m_ringsMtx);
+			size_t count = 0;
+			LogRecord record;
+			for (size_t i = 0; i < m_rings.size(); ++i)
+			{
+				ThreadRing & ring = *m_rings[i];
+				// closed before the last drain, nothing can be added any more
+				bool closed = ring.m_aClosed.load();
+				while (ring.m_records.tryPop(record))
+				{
+					*m_outputPtr << std::chrono::duration_cast<std::chrono::microseconds>(
+						record.m_time.time_since_epoch()).count() << " " << levelName(record.m_level)
+						<< " " << record.m_threadId << " " << record.m_text << "\n";
+					++count;
+				}
+				if (closed)
+				{
+					m_rings.erase(m_rings.begin() + i--);
+				}
+			}
+			if (count > 0)
+			{
+				m_outputPtr->flush();
+			}
+			return count;
+		}
+		/// @brief stream of the background thread, std::cout by default
+		/// @details outputStream has to outlive the log or the next setOutput()
+		void setOutput(std::ostream & outputStream)
+		{
+			flush();
+			std::lock_guard<std::mutex> lk(m_ringsMtx);
+			m_outputPtr = &outputStream;
+		}
+		long long getWrittenCount() const
+		{
+			return m_aWrittenCount.load();
+		}
+		/// messages lost because the ring of their thread was full
+		long long getDroppedCount() const
+		{
+			return m_aDroppedCount.load();
+		}
+	};
+
+	/// @brief Formats one message in place and hands it to the EventLog, see EVENT_LOG_WRITE
+	class LogLine
+	{
+		/// writes into the text of the record, cuts what does not fit
+		class RecordBuffer : public std::streambuf
+		{
+		public:
+			RecordBuffer(char * textPtr, size_t size)
+			{
+				setp(textPtr, textPtr + size - 1);
+			}
+			size_t size() const
+			{
+				return static_cast<size_t>(pptr() - pbase());
+			}
+		};
+		LogRecord m_record;
+		RecordBuffer m_buffer;
+		std::ostream m_stream;
+	public:
+		explicit LogLine(int level) : m_buffer(m_record.m_text, sizeof(m_record.m_text)),
+			m_stream(&m_buffer)
+		{
+			m_record.m_level = level;
+		}
+		LogLine(const LogLine&) = delete;
+		LogLine& operator = (const LogLine&) = delete;
+		~LogLine()
+		{
+			m_record.m_text[m_buffer.size()] = '\0';
+			m_record.m_time = std::chrono::system_clock::now();
+			m_record.m_threadId = std::this_thread::get_id();
+			EventLog::instance().write(std::move(m_record));
+		}
+		std::ostream & stream()
+		{
+			return m_stream;
+		}
+	};
+}//namespace
+
+#endif
@@ -0,0 +1,270 @@
+/// @file eventTrace.h
+/// This file contains event flow tracing in Chrome trace format for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eventHandling
+{
+	/// records kept per thread, older ones are overwritten
+	static const size_t g_traceBufferSize = size_t(1) << 15;
+
+	/// @brief what a TraceRecord describes
+	enum class TraceKind : uint8_t
+	{
+		enqueue = 0, // call handed to a worker, starts the flow of the call
+		dispatch = 1, // worker ran the call, ends the flow
+		callback = 2, // one subscriber ran
+		blocked = 3, // blocked id, no callback ran
+		skipped = 4 // call of an invalid or blocked id, or a blocked subscriber
+	};
+
+	/// @brief Binary trace entry, converted to JSON by EventTrace::dump()
+	struct TraceRecord
+	{
+		int64_t m_time; // nanoseconds since the trace epoch
+		int64_t m_duration; // nanoseconds, dispatch and callback only
+		uint64_t m_callId; // flow of an EventCall, 0 for none
+		uint32_t m_nameId; // callback id, see EventTrace::nameId()
+		uint32_t m_subscriber; // index in the SubscriberTable
+		TraceKind m_kind;
+	};
+
+	/// @brief Event flow tracing of all EventBus objects of the process
+	/// @details While enabled every thread writes binary TraceRecords into its
+	///          own buffer, no locks or shared atomics on the dispatch path; the
+	///          time stamps are the clock reads dispatching makes anyway plus one
+	///          per callback. dump() writes the buffers as Chrome trace JSON,
+	///          which chrome://tracing and ui.perfetto.dev open. Enqueue and
+	///          dispatch of a call are connected by a flow arrow.
+	class EventTrace
+	{
+		struct ThreadBuffer
+		{
+			ThreadBuffer(uint32_t threadIndex) : m_records(g_traceBufferSize), m_aWritten(0),
+				m_threadIndex(threadIndex), m_nextCallId(0) {}
+			std::vector<TraceRecord> m_records; // ring, written by the owning thread only
+			std::atomic<size_t> m_aWritten;
+			uint32_t m_threadIndex;
+			uint64_t m_nextCallId;
+		};
+		std::atomic<bool> m_aEnabled;
+		const std::chrono::steady_clock::time_point m_epoch;
+		mutable std::mutex m_dataMtx; // m_buffers, m_names, m_nameIds
+		std::vector<std::shared_ptr<ThreadBuffer>> m_buffers; // kept after thread exit
+		uint32_t m_nextThreadIndex;
+		std::vector<std::string> m_names;
+		std::unordered_map<std::string, uint32_t> m_nameIds;
+
+		EventTrace() : m_aEnabled(false), m_epoch(std::chrono::steady_clock::now()),
+			m_nextThreadIndex(1) {}
+		ThreadBuffer & threadBuffer()
+		{
+			static thread_local std::shared_ptr<ThreadBuffer> bufferPtr;
+			if (!bufferPtr)
+			{
+				std::lock_guard<std::mutex> lk(m_dataMtx);
+				bufferPtr = std::make_shared<ThreadBuffer>(m_nextThreadIndex++);
+				m_buffers.push_back(bufferPtr);
+			}
+			return *bufferPtr;
+		}
+		static void writeString(std::ostream & output, const std::string & text)
+		{
+			output << '"';
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\')
+				{
+					output << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					output << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+						<< static_cast<int>(c) << std::dec << std::setfill(' ');
+				}
+				else
+				{
+					output << c;
+				}
+			}
+			output << '"';
+		}
+		/// nanoseconds as the microseconds of the trace format
+		static void writeMicroseconds(std::ostream & output, int64_t nanoseconds)
+		{
+			if (nanoseconds < 0)
+			{
+				nanoseconds = 0;
+			}
+			output << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0')
+				<< nanoseconds % 1000 << std::setfill(' ');
+		}
+		void writeRecord(std::ostream & output, const TraceRecord & record, uint32_t threadIndex) const;
+	public:
+		EventTrace& operator = (EventTrace&) = delete;
+		static EventTrace & instance()
+		{
+			static EventTrace trace;
+			return trace;
+		}
+		/// one relaxed load, the only cost of tracing while it is off
+		static bool isEnabled()
+		{
+			return instance().m_aEnabled.load(std::memory_order_relaxed);
+		}
+		void setEnabled(bool enabled)
+		{
+			m_aEnabled = enabled;
+		}
+		/// @brief small id of a callback id for TraceRecord::m_nameId, takes a lock
+		uint32_t nameId(const std::string & name)
+		{
+			std::lock_guard<std::mutex> lk(m_dataMtx);
+			auto it = m_nameIds.find(name);
+			if (it != m_nameIds.end())
+			{
+				return it->second;
+			}
+			uint32_t id = static_cast<uint32_t>(m_names.size());
+			m_names.push_back(name);
+			m_nameIds.emplace(name, id);
+			return id;
+		}
+		int64_t traceTime(std::chrono::steady_clock::time_point time) const
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_epoch).count();
+		}
+		/// @brief id for the flow of a call, unique per process without atomics
+		uint64_t newCallId()
+		{
+			ThreadBuffer & buffer = threadBuffer();
+			return (static_cast<uint64_t>(buffer.m_threadIndex) << 40) | ++buffer.m_nextCallId;
+		}
+		void record(TraceKind kind, uint32_t nameId, std::chrono::steady_clock::time_point start,
+			std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration(0),
+			uint64_t callId = 0, uint32_t subscriber = 0)
+		{
+			ThreadBuffer & buffer = threadBuffer();
+			size_t written = buffer.m_aWritten.load(std::memory_order_relaxed);
+			TraceRecord & record = buffer.m_records[written % g_traceBufferSize];
+			record.m_time = traceTime(start);
+			record.m_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+			record.m_callId = callId;
+			record.m_nameId = nameId;
+			record.m_subscriber = subscriber;
+			record.m_kind = kind;
+			buffer.m_aWritten.store(written + 1, std::memory_order_release);
+		}
+		/// @brief drop all records, buffers of finished threads are freed
+		void clear()
+		{
+			std::lock_guard<std::mutex> lk(m_dataMtx);
+			for (size_t i = 0; i < m_buffers.size(); ++i)
+			{
+				if (m_buffers[i].use_count() == 1)
+				{
+					// the thread_local pointer of its thread is gone
+					m_buffers.erase(m_buffers.begin() + i--);
+				}
+				else
+				{
+					m_buffers[i]->m_aWritten = 0;
+				}
+			}
+		}
+		/// @brief write the records of all threads as Chrome trace JSON
+		/// @details records written during the dump may be torn, stop tracing
+		///          first for an exact trace
+		void dump(std::ostream & output) const;
+		/// @return false in case path can not be written
+		bool dump(const std::string & path) const
+		{
+			std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+			dump(file);
+			return static_cast<bool>(file);
+		}
+	};
+
+	inline void EventTrace::writeRecord(std::ostream & output, const TraceRecord & record,
+		uint32_t threadIndex) const
+	{
+		static const char * const s_categories[] = { "enqueue", "dispatch", "callback",
+			"blocked", "skipped" };
+		const std::string & name = record.m_nameId < m_names.size() ?
+			m_names[record.m_nameId] : std::string();
+		output << "{\"name\":";
+		writeString(output, name);
+		output << ",\"cat\":\"" << s_categories[static_cast<int>(record.m_kind)] << "\",\"ph\":";
+		switch (record.m_kind)
+		{
+		case TraceKind::enqueue:
+		case TraceKind::dispatch:
+		case TraceKind::callback:
+			// slices, a flow arrow binds to the slice around its time stamp
+			output << "\"X\",\"dur\":";
+			writeMicroseconds(output, record.m_duration);
+			break;
+		default:
+			output << "\"i\",\"s\":\"t\"";
+			break;
+		}
+		output << ",\"ts\":";
+		writeMicroseconds(output, record.m_time);
+		output << ",\"pid\":1,\"tid\":" << threadIndex << ",\"args\":{\"call\":" << record.m_callId
+			<< ",\"subscriber\":" << record.m_subscriber << "}}";
+		if (record.m_callId != 0 && (record.m_kind == TraceKind::enqueue ||
+			record.m_kind == TraceKind::dispatch))
+		{
+			output << ",\n{\"name\":\"call\",\"cat\":\"flow\",\"ph\":\"" <<
+				(record.m_kind == TraceKind::enqueue ? "s\"" : "f\",\"bp\":\"e\"") <<
+				",\"id\":" << record.m_callId << ",\"ts\":";
+			writeMicroseconds(output, record.m_time);
+			output << ",\"pid\":1,\"tid\":" << threadIndex << "}";
+		}
+	}
+
+	inline void EventTrace::dump(std::ostream & output) const
+	{
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		bool first = true;
+		for (const std::shared_ptr<ThreadBuffer> & bufferPtr : m_buffers)
+		{
+			const ThreadBuffer & buffer = *bufferPtr;
+			size_t written = buffer.m_aWritten.load(std::memory_order_acquire);
+			if (written == 0)
+			{
+				continue;
+			}
+			output << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+				<< buffer.m_threadIndex << ",\"args\":{\"name\":\"thread " << buffer.m_threadIndex << "\"}}";
+			first = false;
+			for (size_t i = written > g_traceBufferSize ? written - g_traceBufferSize : 0; i < written; ++i)
+			{
+				output << ",\n";
+				writeRecord(output, buffer.m_records[i % g_traceBufferSize], buffer.m_threadIndex);
+			}
+		}
+		output << "\n]}\n";
+	}
+}//namespace
+
+#endif
@@ -0,0 +1,151 @@
+/// @file histogram.h
+/// This file contains lock free latency histograms for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eventHandling
+{
+	/// sub buckets per power of two are 2^g_histogramSubBits, about 3% precision
+	static const int g_histogramSubBits = 5;
+	/// values from 2^g_histogramMaxBits ns, about 18 minutes, share the top bucket
+	static const int g_histogramMaxBits = 40;
+	/// one linear range below 2^g_histogramSubBits, then one per power of two
+	static const size_t g_histogramBuckets =
+		size_t(g_histogramMaxBits - g_histogramSubBits + 2) << g_histogramSubBits;
+
+	/// @brief Summary of a LatencyHistogram, all values in nanoseconds
+	struct LatencyStats
+	{
+		long long m_count;
+		long long m_p50, m_p99, m_p999; // upper bound of the bucket of the percentile
+		long long m_max; // exact
+		long long m_meanNanoseconds;
+	};
+
+	/// @brief Lock free log linear histogram of durations in nanoseconds
+	/// @details Like HdrHistogram every power of two is split into
+	///          2^g_histogramSubBits linear buckets, so a percentile is off by
+	///          at most 1/2^g_histogramSubBits of the value. record() is a few
+	///          shifts and relaxed atomic adds, readers copy the counters without
+	///          stopping the writers, a snapshot may miss concurrent records.
+	class LatencyHistogram
+	{
+		std::atomic<uint64_t> m_aBuckets[g_histogramBuckets];
+		std::atomic<uint64_t> m_aCount, m_aSum, m_aMax;
+
+		static int highestBit(uint64_t value)
+		{
+			int bit = 0;
+			for (int shift = 32; shift > 0; shift >>= 1)
+			{
+				if (value >> shift)
+				{
+					value >>= shift;
+					bit += shift;
+				}
+			}
+			return bit;
+		}
+		static size_t bucketOf(uint64_t value)
+		{
+			if (value < (uint64_t(1) << g_histogramSubBits))
+			{
+				return static_cast<size_t>(value);
+			}
+			int bit = std::min(highestBit(value), g_histogramMaxBits);
+			int shift = bit - g_histogramSubBits;
+			uint64_t subBucket = std::min<uint64_t>(value >> shift,
+				(uint64_t(2) << g_histogramSubBits) - 1) - (uint64_t(1) << g_histogramSubBits);
+			return (static_cast<size_t>(shift + 1) << g_histogramSubBits) +
+				static_cast<size_t>(subBucket);
+		}
+		/// largest value counted in bucket
+		static uint64_t upperBound(size_t bucket)
+		{
+			size_t range = bucket >> g_histogramSubBits;
+			uint64_t subBucket = bucket & ((size_t(1) << g_histogramSubBits) - 1);
+			if (range == 0)
+			{
+				return subBucket;
+			}
+			int shift = static_cast<int>(range) - 1;
+			return (((uint64_t(1) << g_histogramSubBits) + subBucket + 1) << shift) - 1;
+		}
+	public:
+		LatencyHistogram()
+		{
+			reset();
+		}
+		LatencyHistogram& operator = (LatencyHistogram&) = delete;
+		void record(long long nanoseconds)
+		{
+			uint64_t value = nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0;
+			m_aBuckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+			m_aCount.fetch_add(1, std::memory_order_relaxed);
+			m_aSum.fetch_add(value, std::memory_order_relaxed);
+			uint64_t max = m_aMax.load(std::memory_order_relaxed);
+			while (value > max &&
+				!m_aMax.compare_exchange_weak(max, value, std::memory_order_relaxed))
+			{
+			}
+		}
+		/// @brief not atomic with concurrent records, they may survive partly
+		void reset()
+		{
+			for (auto & bucket : m_aBuckets)
+			{
+				bucket.store(0, std::memory_order_relaxed);
+			}
+			m_aCount.store(0, std::memory_order_relaxed);
+			m_aSum.store(0, std::memory_order_relaxed);
+			m_aMax.store(0, std::memory_order_relaxed);
+		}
+		long long getCount() const
+		{
+			return static_cast<long long>(m_aCount.load(std::memory_order_relaxed));
+		}
+		LatencyStats getStats() const
+		{
+			std::vector<uint64_t> buckets(g_histogramBuckets);
+			uint64_t count = 0;
+			for (size_t i = 0; i < g_histogramBuckets; ++i)
+			{
+				buckets[i] = m_aBuckets[i].load(std::memory_order_relaxed);
+				count += buckets[i];
+			}
+			LatencyStats stats;
+			stats.m_count = static_cast<long long>(count);
+			stats.m_max = static_cast<long long>(m_aMax.load(std::memory_order_relaxed));
+			stats.m_meanNanoseconds = count == 0 ? 0 :
+				static_cast<long long>(m_aSum.load(std::memory_order_relaxed) / count);
+			// ranks of the percentiles, rounded up so p999 of 10 values is the max
+			const uint64_t ranks[3] = { (count * 500 + 999) / 1000,
+				(count * 990 + 999) / 1000, (count * 999 + 999) / 1000 };
+			long long * valuesPtrs[3] = { &stats.m_p50, &stats.m_p99, &stats.m_p999 };
+			uint64_t seen = 0;
+			size_t rank = 0;
+			for (size_t i = 0; i < g_histogramBuckets && rank < 3; ++i)
+			{
+				seen += buckets[i];
+				while (rank < 3 && seen >= ranks[rank] && seen > 0)
+				{
+					*valuesPtrs[rank++] = std::min(static_cast<long long>(upperBound(i)), stats.m_max);
+				}
+			}
+			for (; rank < 3; ++rank)
+			{
+				*valuesPtrs[rank] = 0;
+			}
+			return stats;
+		}
+	};
+}//namespace
+
+#endif
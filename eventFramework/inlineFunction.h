@@ -0,0 +1,168 @@
+/// @file inlineFunction.h
+/// This file contains a fixed capacity callable for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef INLINE_FUNCTION_H
+#define INLINE_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace eventHandling
+{
+	/// default inline capacity of an InlineFunction, fits a captured std::function
+	static const size_t g_inlineCallbackSize = 64;
+
+	template<class Signature, size_t Size = g_inlineCallbackSize>
+	class InlineFunction;
+
+	/// @brief Move-only callable stored in place, never allocates
+	/// @details The target lives in Size bytes inside the object, a larger target
+	///          is a compile error. Calling is one indirect call straight into the
+	///          target, moving and destroying go through a per type table.
+	///          clone() copies copyable targets, e.g. for copy on write snapshots.
+	template<class R, class... A, size_t Size>
+	class InlineFunction<R(A...), Size>
+	{
+		typedef R(*Invoker)(void * targetPtr, A... args);
+		struct Operations
+		{
+			void(*m_move)(void * toPtr, void * fromPtr);
+			void(*m_copy)(void * toPtr, const void * fromPtr); // nullptr for move-only targets
+			void(*m_destroy)(void * targetPtr);
+		};
+
+		template<class T>
+		struct Manager
+		{
+			static R invoke(void * targetPtr, A... args)
+			{
+				return (*static_cast<T *>(targetPtr))(std::forward<A>(args)...);
+			}
+			static void move(void * toPtr, void * fromPtr)
+			{
+				new (toPtr) T(std::move(*static_cast<T *>(fromPtr)));
+				static_cast<T *>(fromPtr)->~T();
+			}
+			static void copy(void * toPtr, const void * fromPtr)
+			{
+				new (toPtr) T(*static_cast<const T *>(fromPtr));
+			}
+			static void destroy(void * targetPtr)
+			{
+				static_cast<T *>(targetPtr)->~T();
+			}
+			static void(*copyFunction(std::true_type))(void *, const void *)
+			{
+				return &copy;
+			}
+			static void(*copyFunction(std::false_type))(void *, const void *)
+			{
+				return nullptr;
+			}
+			static const Operations * operations()
+			{
+				static const Operations s_operations = { &move,
+					copyFunction(std::is_copy_constructible<T>()), &destroy };
+				return &s_operations;
+			}
+		};
+
+		typename std::aligned_storage<Size, alignof(std::max_align_t)>::type m_storage;
+		Invoker m_invoker; // nullptr while empty
+		const Operations * m_operationsPtr;
+
+		void moveFrom(InlineFunction & other) noexcept
+		{
+			if (other.m_invoker)
+			{
+				other.m_operationsPtr->m_move(&m_storage, &other.m_storage);
+				m_invoker = other.m_invoker;
+				m_operationsPtr = other.m_operationsPtr;
+				other.m_invoker = nullptr;
+				other.m_operationsPtr = nullptr;
+			}
+		}
+	public:
+		InlineFunction() noexcept : m_invoker(nullptr), m_operationsPtr(nullptr) {}
+		InlineFunction(std::nullptr_t) noexcept : m_invoker(nullptr), m_operationsPtr(nullptr) {}
+		template<class F, class = typename std::enable_if<
+			!std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+		InlineFunction(F && callable) : m_invoker(nullptr), m_operationsPtr(nullptr)
+		{
+			typedef typename std::decay<F>::type Target;
+			static_assert(sizeof(Target) <= Size,
+				"InlineFunction: callable is larger than the inline size, raise Size");
+			static_assert(alignof(Target) <= alignof(std::max_align_t),
+				"InlineFunction: callable is over aligned");
+			new (&m_storage) Target(std::forward<F>(callable));
+			m_invoker = &Manager<Target>::invoke;
+			m_operationsPtr = Manager<Target>::operations();
+		}
+		InlineFunction(InlineFunction && other) noexcept : m_invoker(nullptr), m_operationsPtr(nullptr)
+		{
+			moveFrom(other);
+		}
+		InlineFunction& operator = (InlineFunction && other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				moveFrom(other);
+			}
+			return *this;
+		}
+		InlineFunction& operator = (std::nullptr_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+		InlineFunction(const InlineFunction&) = delete;
+		InlineFunction& operator = (const InlineFunction&) = delete;
+		~InlineFunction()
+		{
+			reset();
+		}
+
+		/// @brief copy of a copyable target
+		/// @throws std::logic_error in case the target is move-only
+		InlineFunction clone() const
+		{
+			InlineFunction res;
+			if (m_invoker)
+			{
+				if (!m_operationsPtr->m_copy)
+				{
+					throw std::logic_error("InlineFunction: can not clone a move-only target");
+				}
+				m_operationsPtr->m_copy(&res.m_storage, &m_storage);
+				res.m_invoker = m_invoker;
+				res.m_operationsPtr = m_operationsPtr;
+			}
+			return res;
+		}
+		void reset() noexcept
+		{
+			if (m_invoker)
+			{
+				m_operationsPtr->m_destroy(&m_storage);
+				m_invoker = nullptr;
+				m_operationsPtr = nullptr;
+			}
+		}
+		explicit operator bool() const noexcept
+		{
+			return m_invoker != nullptr;
+		}
+		/// must not be empty
+		R operator()(A... args) const
+		{
+			return m_invoker(const_cast<void *>(static_cast<const void *>(&m_storage)),
+				std::forward<A>(args)...);
+		}
+	};
+}//namespace
+
+#endif
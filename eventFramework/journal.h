@@ -0,0 +1,1009 @@
+/// @file journal.h
+/// This file contains a memory mapped write-ahead journal for durable EventCalls
+/// It is implemented using constructs from C++14 standard.
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace eventHandling
+{
+	/// first bytes of a checkpoint slot
+	static const uint32_t g_journalMagic = 0x4c4e524a;
+	/// records start at multiples of it
+	static const size_t g_journalAlignment = 8;
+	/// distance of the two slots in the checkpoint file
+	static const size_t g_journalCheckpointSlot = 64;
+	/// checkpoint period in case the journal does not sync periodically
+	static const std::chrono::milliseconds g_journalCheckpointInterval(10);
+	/// JournalRecordHeader::m_flags, the call has no argument
+	static const uint16_t g_journalFlagNoArgument = 1;
+
+	/// @brief Settings of a Journal
+	struct JournalOptions
+	{
+		JournalOptions() : m_segmentSize(size_t(64) << 20),
+			m_syncInterval(std::chrono::microseconds(1000)), m_waitForSync(false) {}
+		size_t m_segmentSize; // bytes per segment file, a record has to fit into one
+		/// group commit period, 0 syncs before every append returns,
+		/// negative never syncs and leaves the write back to the OS
+		std::chrono::microseconds m_syncInterval;
+		bool m_waitForSync; // append() returns once its record was synced
+	};
+
+	/// @brief Counters of a Journal
+	struct JournalStats
+	{
+		long long m_appendedCount;
+		long long m_completedCount;
+		long long m_syncCount; // msync calls
+		long long m_appendedBytes;
+		long long m_errorCount; // failed appends
+		uint64_t m_checkpointSequence; // every record below it is complete
+		uint64_t m_nextSequence;
+		int m_segmentCount; // segment files in use
+	};
+
+	/// @brief Counts of a Journal::replay()
+	struct JournalReplayStats
+	{
+		long long m_replayedCount; // pending records taken by the caller
+		long long m_skippedCount; // checkpointed records and records the caller did not take
+		long long m_corruptCount; // damaged records, each ends the scan of its segment
+		long long m_lostCount; // pending sequences which were not found
+		long long m_bytes; // scanned journal
+		std::chrono::nanoseconds m_duration;
+	};
+
+	/// @brief Header of a record, followed by the callback id and the argument
+	/// @details m_size 0 ends a segment, segments are zero filled files.
+	///          m_checksum is the CRC-32 of m_size and of the bytes after m_checksum.
+	struct JournalRecordHeader
+	{
+		uint32_t m_size; // including header and padding
+		uint32_t m_checksum;
+		uint64_t m_sequence;
+		uint32_t m_argumentSize;
+		uint16_t m_nameSize;
+		uint16_t m_flags;
+	};
+
+	/// @brief A record of a mapped segment, only valid while the segment is mapped
+	struct JournalRecordView
+	{
+		uint64_t m_sequence;
+		const char * m_namePtr;
+		size_t m_nameSize;
+		const char * m_argumentPtr;
+		size_t m_argumentSize;
+		uint16_t m_flags;
+	};
+
+	/// @brief CRC-32 (IEEE), start with crc 0 and chain the calls
+	/// @details slicing by 8, eight bytes per step through eight tables
+	inline uint32_t journalChecksum(const void * dataPtr, size_t size, uint32_t crc = 0)
+	{
+		struct Table
+		{
+			uint32_t m_values[8][256];
+			Table()
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					uint32_t value = i;
+					for (int bit = 0; bit < 8; ++bit)
+					{
+						value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+					}
+					m_values[0][i] = value;
+				}
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					for (int slice = 1; slice < 8; ++slice)
+					{
+						const uint32_t previous = m_values[slice - 1][i];
+						m_values[slice][i] = m_values[0][previous & 0xff] ^ (previous >> 8);
+					}
+				}
+			}
+		};
+		static const Table s_table;
+		const unsigned char * bytesPtr = static_cast<const unsigned char *>(dataPtr);
+		crc = ~crc;
+		for (; size >= 8; size -= 8, bytesPtr += 8)
+		{
+			// byte by byte, independent of the byte order
+			const uint32_t low = crc ^ (uint32_t(bytesPtr[0]) | uint32_t(bytesPtr[1]) << 8 |
+				uint32_t(bytesPtr[2]) << 16 | uint32_t(bytesPtr[3]) << 24);
+			crc = s_table.m_values[7][low & 0xff] ^ s_table.m_values[6][(low >> 8) & 0xff] ^
+				s_table.m_values[5][(low >> 16) & 0xff] ^ s_table.m_values[4][low >> 24] ^
+				s_table.m_values[3][bytesPtr[4]] ^ s_table.m_values[2][bytesPtr[5]] ^
+				s_table.m_values[1][bytesPtr[6]] ^ s_table.m_values[0][bytesPtr[7]];
+		}
+		for (; size > 0; --size, ++bytesPtr)
+		{
+			crc = s_table.m_values[0][(crc ^ *bytesPtr) & 0xff] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	/// @brief checksum of a record as stored in JournalRecordHeader::m_checksum
+	inline uint32_t journalRecordChecksum(const char * recordPtr, uint32_t size)
+	{
+		const size_t checked = offsetof(JournalRecordHeader, m_sequence);
+		return journalChecksum(recordPtr + checked, size - checked,
+			journalChecksum(&size, sizeof(size)));
+	}
+
+	/// @brief call onRecord(const JournalRecordView &) for the valid records of a segment
+	/// @param verifiedSize checksums of the records before it were checked already
+	/// @return offset after the last valid record; a record which is cut or has a
+	///         wrong checksum ends the scan, corrupt is set in that case
+	template<class F>
+	size_t scanJournalSegment(const char * dataPtr, size_t size, F onRecord, bool & corrupt,
+		size_t verifiedSize = 0)
+	{
+		corrupt = false;
+		size_t offset = 0;
+		while (offset + sizeof(JournalRecordHeader) <= size)
+		{
+			JournalRecordHeader header;
+			std::memcpy(&header, dataPtr + offset, sizeof(header));
+			if (header.m_size == 0)
+			{
+				break;// end of the written part
+			}
+			if (header.m_size % g_journalAlignment != 0 || header.m_size > size - offset ||
+				sizeof(header) + header.m_nameSize + size_t(header.m_argumentSize) > header.m_size ||
+				(offset + header.m_size > verifiedSize &&
+				journalRecordChecksum(dataPtr + offset, header.m_size) != header.m_checksum))
+			{
+				corrupt = true;
+				break;
+			}
+			JournalRecordView record;
+			record.m_sequence = header.m_sequence;
+			record.m_namePtr = dataPtr + offset + sizeof(header);
+			record.m_nameSize = header.m_nameSize;
+			record.m_argumentPtr = record.m_namePtr + header.m_nameSize;
+			record.m_argumentSize = header.m_argumentSize;
+			record.m_flags = header.m_flags;
+			onRecord(record);
+			offset += header.m_size;
+		}
+		return offset;
+	}
+
+	/// @brief sequence of the first record of a segment, 0 in case it has no valid one
+	inline uint64_t firstJournalSequence(const char * dataPtr, size_t size)
+	{
+		JournalRecordHeader header;
+		if (size < sizeof(header))
+		{
+			return 0;
+		}
+		std::memcpy(&header, dataPtr, sizeof(header));
+		uint64_t sequence = 0;
+		bool corrupt = false;
+		// only the first record is checked
+		scanJournalSegment(dataPtr, std::min(size, static_cast<size_t>(header.m_size)),
+			[&sequence](const JournalRecordView & record) { sequence = record.m_sequence; }, corrupt);
+		return sequence;
+	}
+
+	/// @brief A file mapped into memory for reading and writing
+	class MappedFile
+	{
+		char * m_dataPtr;
+		size_t m_size;
+#ifdef _WIN32
+		HANDLE m_file, m_mapping;
+#else
+		int m_fd;
+#endif
+	public:
+#ifdef _WIN32
+		MappedFile() : m_dataPtr(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE),
+			m_mapping(nullptr) {}
+#else
+		MappedFile() : m_dataPtr(nullptr), m_size(0), m_fd(-1) {}
+#endif
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator = (const MappedFile&) = delete;
+		~MappedFile()
+		{
+			close();
+		}
+		/// @brief map path, a new or shorter file is extended to size zero bytes
+		/// @param size 0 maps the file as it is
+		/// @return false in case the file can not be opened or mapped
+		bool open(const std::string & path, size_t size, bool create);
+		void close();
+		bool isOpen() const
+		{
+			return m_dataPtr != nullptr;
+		}
+		char * data() const
+		{
+			return m_dataPtr;
+		}
+		size_t size() const
+		{
+			return m_size;
+		}
+		/// @brief write the range back to disk and wait for it
+		bool sync(size_t offset, size_t size);
+		/// @brief sync size and other metadata of the file
+		bool syncFile();
+		/// @brief hint that the mapping is read once from front to back
+		void adviseSequential();
+		static bool exists(const std::string & path)
+		{
+			std::FILE * filePtr = std::fopen(path.c_str(), "rb");
+			if (filePtr)
+			{
+				std::fclose(filePtr);
+			}
+			return filePtr != nullptr;
+		}
+		static bool remove(const std::string & path)
+		{
+			return std::remove(path.c_str()) == 0;
+		}
+		/// @return false in case the directory neither exists nor can be made
+		static bool makeDirectory(const std::string & path)
+		{
+#ifdef _WIN32
+			return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+			return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+		}
+		static bool removeDirectory(const std::string & path)
+		{
+#ifdef _WIN32
+			return _rmdir(path.c_str()) == 0;
+#else
+			return ::rmdir(path.c_str()) == 0;
+#endif
+		}
+	};
+
+#ifdef _WIN32
+	inline bool MappedFile::open(const std::string & path, size_t size, bool create)
+	{
+		close();
+		m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+			create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(m_file, &fileSize))
+		{
+			close();
+			return false;
+		}
+		size_t mappedSize = std::max(size, static_cast<size_t>(fileSize.QuadPart));
+		if (mappedSize == 0)
+		{
+			close();
+			return false;
+		}
+		const unsigned long long mappingSize = mappedSize;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), nullptr);
+		if (!m_mapping)
+		{
+			close();
+			return false;
+		}
+		m_dataPtr = static_cast<char *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+			mappedSize));
+		if (!m_dataPtr)
+		{
+			close();
+			return false;
+		}
+		m_size = mappedSize;
+		return true;
+	}
+	inline void MappedFile::close()
+	{
+		if (m_dataPtr)
+		{
+			UnmapViewOfFile(m_dataPtr);
+			m_dataPtr = nullptr;
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+		if (m_file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_file);
+			m_file = INVALID_HANDLE_VALUE;
+		}
+		m_size = 0;
+	}
+	inline bool MappedFile::sync(size_t offset, size_t size)
+	{
+		return FlushViewOfFile(m_dataPtr + offset, size) && FlushFileBuffers(m_file);
+	}
+	inline bool MappedFile::syncFile()
+	{
+		return FlushFileBuffers(m_file) != 0;
+	}
+	inline void MappedFile::adviseSequential()
+	{
+	}
+#else
+	inline bool MappedFile::open(const std::string & path, size_t size, bool create)
+	{
+		close();
+		m_fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+		if (m_fd < 0)
+		{
+			return false;
+		}
+		struct stat fileStat;
+		if (fstat(m_fd, &fileStat) != 0)
+		{
+			close();
+			return false;
+		}
+		size_t mappedSize = std::max(size, static_cast<size_t>(fileStat.st_size));
+		if (mappedSize == 0 || (mappedSize > static_cast<size_t>(fileStat.st_size) &&
+			ftruncate(m_fd, static_cast<off_t>(mappedSize)) != 0))
+		{
+			close();
+			return false;
+		}
+		void * dataPtr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		if (dataPtr == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		m_dataPtr = static_cast<char *>(dataPtr);
+		m_size = mappedSize;
+		return true;
+	}
+	inline void MappedFile::close()
+	{
+		if (m_dataPtr)
+		{
+			munmap(m_dataPtr, m_size);
+			m_dataPtr = nullptr;
+		}
+		if (m_fd >= 0)
+		{
+			::close(m_fd);
+			m_fd = -1;
+		}
+		m_size = 0;
+	}
+	inline bool MappedFile::sync(size_t offset, size_t size)
+	{
+		// msync takes page aligned addresses
+		const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t start = offset / pageSize * pageSize;
+		return msync(m_dataPtr + start, offset + size - start, MS_SYNC) == 0;
+	}
+	inline bool MappedFile::syncFile()
+	{
+		return fsync(m_fd) == 0;
+	}
+	inline void MappedFile::adviseSequential()
+	{
+		madvise(m_dataPtr, m_size, MADV_SEQUENTIAL);
+	}
+#endif
+
+	/// @brief Segmented, memory mapped write-ahead journal of EventCalls
+	/// @details append() copies a record into the mapped segment under a short
+	///          lock, the segment is preallocated so appending never grows a file.
+	///          Group commit: a background thread syncs what was appended since
+	///          its last round every m_syncInterval, with one msync for all records
+	///          of the round. With m_syncInterval 0 the first waiting appender
+	///          syncs for all others which wait meanwhile. complete() marks a
+	///          record done, the checkpoint is the first sequence which is not
+	///          done and is written to two alternating slots of the checkpoint
+	///          file. Segments below the checkpoint are deleted. Records of a
+	///          previous process which were not checkpointed stay pending until
+	///          replay() handed them on and they are completed.
+	class Journal
+	{
+		/// slot of the checkpoint file
+		struct CheckpointRecord
+		{
+			uint32_t m_magic;
+			uint32_t m_checksum; // of the bytes after it
+			uint64_t m_sequence; // first record which is not complete
+			uint64_t m_firstSegment; // first segment file in use
+			uint64_t m_counter; // the valid slot with the higher counter wins
+		};
+		struct Segment
+		{
+			uint64_t m_index;
+			uint64_t m_lastSequence; // of the last record, first sequence - 1 while empty
+			size_t m_verifiedSize; // valid records open() scanned
+			std::shared_ptr<MappedFile> m_filePtr; // the written segment only
+		};
+		std::string m_directory;
+		JournalOptions m_options;
+		std::mutex m_checkpointMtx; // m_checkpointFile, m_checkpointCounter
+		mutable std::mutex m_writeMtx; // all below but the counters
+		std::condition_variable m_syncedCond; // m_syncedSequence advanced
+		std::condition_variable m_syncThreadCond; // m_stopping
+		std::deque<Segment> m_segments; // back is written
+		size_t m_writeOffset, m_syncedOffset; // in the back segment
+		uint64_t m_nextSequence, m_syncedSequence;
+		bool m_syncing; // a thread syncs outside the lock
+		uint64_t m_windowBase; // first sequence which is not complete
+		std::deque<uint8_t> m_done; // from m_windowBase
+		uint64_t m_checkpointSequence, m_checkpointCounter;
+		MappedFile m_checkpointFile;
+		bool m_open, m_stopping;
+		bool m_replayed; // replay() ran since open()
+		uint64_t m_replayEndSequence; // first sequence of this process
+		std::thread m_syncThread;
+		std::atomic<long long> m_aAppendedCount, m_aCompletedCount, m_aSyncCount,
+			m_aAppendedBytes, m_aErrorCount;
+
+		bool syncEnabled() const
+		{
+			return m_options.m_syncInterval.count() >= 0;
+		}
+		std::string segmentPath(uint64_t index) const
+		{
+			char name[40];
+			std::snprintf(name, sizeof(name), "/journal-%016llx.wal",
+				static_cast<unsigned long long>(index));
+			return m_directory + name;
+		}
+		std::string checkpointPath() const
+		{
+			return m_directory + "/checkpoint";
+		}
+		static size_t recordSize(size_t nameSize, size_t argumentSize)
+		{
+			const size_t size = sizeof(JournalRecordHeader) + nameSize + argumentSize;
+			return (size + g_journalAlignment - 1) / g_journalAlignment * g_journalAlignment;
+		}
+		bool readCheckpoint(uint64_t & sequence, uint64_t & firstSegment);
+		void writeCheckpoint(uint64_t sequence, uint64_t firstSegment);
+		/// @brief create segment file index and write to it
+		bool openSegment(uint64_t index);
+		/// @brief start the next segment, the previous one is synced first
+		bool rollSegment();
+		/// @brief sync the records appended so far, lk is released while syncing
+		void syncPending(std::unique_lock<std::mutex> & lk);
+		void checkpoint();
+		void runSync();
+	public:
+		Journal() : m_writeOffset(0), m_syncedOffset(0), m_nextSequence(1), m_syncedSequence(0),
+			m_syncing(false), m_windowBase(1), m_checkpointSequence(0), m_checkpointCounter(0),
+			m_open(false), m_stopping(false), m_replayed(false), m_replayEndSequence(1),
+			m_aAppendedCount(0), m_aCompletedCount(0),
+			m_aSyncCount(0), m_aAppendedBytes(0), m_aErrorCount(0) {}
+		Journal(const Journal&) = delete;
+		Journal& operator = (const Journal&) = delete;
+		~Journal()
+		{
+			close();
+		}
+		/// @brief open or create the journal in directory, appends go to a new segment
+		/// @return false in case the directory or its files can not be used
+		bool open(const std::string & directory, const JournalOptions & options = JournalOptions());
+		/// @brief sync, checkpoint and unmap, pending records stay in the files
+		void close();
+		bool isOpen() const
+		{
+			std::lock_guard<std::mutex> lk(m_writeMtx);
+			return m_open;
+		}
+		const std::string & getDirectory() const
+		{
+			return m_directory;
+		}
+		/// @brief append a call of callbackId with its serialized argument
+		/// @param flags JournalRecordHeader::m_flags, e.g. g_journalFlagNoArgument
+		/// @return sequence of the record, 0 in case it does not fit or the journal failed
+		uint64_t append(const std::string & callbackId, const char * argumentPtr, size_t argumentSize,
+			uint16_t flags = 0);
+		/// @brief hand the pending records of the previous process to onRecord
+		/// @details onRecord(const JournalRecordView &) returns true in case it takes
+		///          the record, which is complete()d by the taker later; records it
+		///          does not take are completed right away. One segment is mapped at
+		///          a time. Checkpointed records are skipped, pending sequences behind
+		///          a damaged record are lost and completed. Only the first call after
+		///          open() replays, records stay pending until then.
+		template<class F>
+		JournalReplayStats replay(F onRecord);
+		/// @brief mark a record done, the checkpoint moves past it once all before are done
+		void complete(uint64_t sequence);
+		/// @brief sync and checkpoint now
+		void flush();
+		JournalStats getStats() const;
+		/// @brief delete the files of a closed journal and its directory
+		static bool remove(const std::string & directory);
+	};
+
+	inline bool Journal::readCheckpoint(uint64_t & sequence, uint64_t & firstSegment)
+	{
+		bool found = false;
+		for (size_t slot = 0; slot < 2; ++slot)
+		{
+			CheckpointRecord record;
+			std::memcpy(&record, m_checkpointFile.data() + slot * g_journalCheckpointSlot, sizeof(record));
+			const size_t checked = offsetof(CheckpointRecord, m_sequence);
+			if (record.m_magic != g_journalMagic || record.m_checksum != journalChecksum(
+				reinterpret_cast<const char *>(&record) + checked, sizeof(record) - checked))
+			{
+				continue;
+			}
+			if (!found || record.m_counter > m_checkpointCounter)
+			{
+				found = true;
+				m_checkpointCounter = record.m_counter;
+				sequence = record.m_sequence;
+				firstSegment = record.m_firstSegment;
+			}
+		}
+		return found;
+	}
+
+	inline void Journal::writeCheckpoint(uint64_t sequence, uint64_t firstSegment)
+	{
+		CheckpointRecord record;
+		record.m_magic = g_journalMagic;
+		record.m_sequence = sequence;
+		record.m_firstSegment = firstSegment;
+		record.m_counter = ++m_checkpointCounter;
+		const size_t checked = offsetof(CheckpointRecord, m_sequence);
+		record.m_checksum = journalChecksum(reinterpret_cast<const char *>(&record) + checked,
+			sizeof(record) - checked);
+		// the other slot stays valid in case this write is torn
+		const size_t offset = (record.m_counter % 2) * g_journalCheckpointSlot;
+		std::memcpy(m_checkpointFile.data() + offset, &record, sizeof(record));
+		if (syncEnabled())
+		{
+			m_checkpointFile.sync(offset, sizeof(record));
+		}
+	}
+
+	inline bool Journal::open(const std::string & directory, const JournalOptions & options)
+	{
+		close();
+		std::unique_lock<std::mutex> lk(m_writeMtx);
+		m_directory = directory;
+		m_options = options;
+		if (m_options.m_segmentSize < 4096 || !MappedFile::makeDirectory(directory) ||
+			!m_checkpointFile.open(checkpointPath(), 4096, true))
+		{
+			return false;
+		}
+		uint64_t checkpointSequence = 1, firstSegment = 0;
+		readCheckpoint(checkpointSequence, firstSegment);
+		// left over in case the process ended between checkpoint and delete
+		for (uint64_t index = firstSegment; index > 0 && MappedFile::exists(segmentPath(index - 1)); --index)
+		{
+			MappedFile::remove(segmentPath(index - 1));
+		}
+		m_segments.clear();
+		uint64_t lastSequence = checkpointSequence - 1;
+		uint64_t index = firstSegment;
+		for (; MappedFile::exists(segmentPath(index)); ++index)
+		{
+			Segment segment;
+			segment.m_index = index;
+			segment.m_lastSequence = lastSequence;
+			segment.m_verifiedSize = 0;
+			m_segments.push_back(segment);
+		}
+		for (size_t i = 0; i < m_segments.size(); ++i)
+		{
+			Segment & segment = m_segments[i];
+			segment.m_lastSequence = lastSequence;
+			// a segment ends before the first record of the next one, only the
+			// last segment or one followed by a damaged record is scanned
+			MappedFile file;
+			uint64_t nextSequence = 0;
+			if (i + 1 < m_segments.size() && file.open(segmentPath(segment.m_index + 1), 0, false))
+			{
+				nextSequence = firstJournalSequence(file.data(), file.size());
+			}
+			if (nextSequence > 0)
+			{
+				segment.m_lastSequence = std::max(lastSequence, nextSequence - 1);
+			}
+			else if (file.open(segmentPath(segment.m_index), 0, false))
+			{
+				bool corrupt = false;
+				segment.m_verifiedSize = scanJournalSegment(file.data(), file.size(),
+					[&segment](const JournalRecordView & record) {
+					segment.m_lastSequence = std::max(segment.m_lastSequence, record.m_sequence); }, corrupt);
+			}
+			lastSequence = segment.m_lastSequence;
+		}
+		m_nextSequence = lastSequence + 1;
+		m_syncedSequence = lastSequence;
+		// records of the last process which were not checkpointed are pending
+		m_windowBase = checkpointSequence;
+		m_done.assign(static_cast<size_t>(m_nextSequence - m_windowBase), 0);
+		m_checkpointSequence = checkpointSequence;
+		m_replayed = false;
+		m_replayEndSequence = m_nextSequence;
+		if (!openSegment(index))
+		{
+			m_segments.clear();
+			m_checkpointFile.close();
+			return false;
+		}
+		m_open = true;
+		m_stopping = false;
+		m_syncThread = std::thread(&Journal::runSync, this);
+		return true;
+	}
+
+	inline bool Journal::rollSegment()
+	{
+		Segment & current = m_segments.back();
+		if (current.m_filePtr)
+		{
+			if (syncEnabled() && m_syncedOffset < m_writeOffset)
+			{
+				current.m_filePtr->sync(m_syncedOffset, m_writeOffset - m_syncedOffset);
+				++m_aSyncCount;
+			}
+			m_syncedSequence = m_nextSequence - 1;
+			m_syncedCond.notify_all();
+			current.m_filePtr.reset();// unmapped once a running sync is done with it
+		}
+		return openSegment(current.m_index + 1);
+	}
+
+	inline bool Journal::openSegment(uint64_t index)
+	{
+		Segment segment;
+		segment.m_index = index;
+		segment.m_lastSequence = m_nextSequence - 1;
+		segment.m_verifiedSize = 0;
+		segment.m_filePtr = std::make_shared<MappedFile>();
+		if (!segment.m_filePtr->open(segmentPath(index), m_options.m_segmentSize, true))
+		{
+			return false;
+		}
+		if (syncEnabled())
+		{
+			segment.m_filePtr->syncFile();
+		}
+		m_segments.push_back(segment);
+		m_writeOffset = 0;
+		m_syncedOffset = 0;
+		return true;
+	}
+
+	inline uint64_t Journal::append(const std::string & callbackId, const char * argumentPtr,
+		size_t argumentSize, uint16_t flags)
+	{
+		const size_t size = recordSize(callbackId.size(), argumentSize);
+		std::unique_lock<std::mutex> lk(m_writeMtx);
+		if (!m_open || callbackId.size() > 0xffff || size > m_options.m_segmentSize ||
+			(m_writeOffset + size > m_options.m_segmentSize && !rollSegment()))
+		{
+			++m_aErrorCount;
+			return 0;
+		}
+		Segment & segment = m_segments.back();
+		char * recordPtr = segment.m_filePtr->data() + m_writeOffset;
+		JournalRecordHeader header;
+		header.m_size = static_cast<uint32_t>(size);
+		header.m_sequence = m_nextSequence++;
+		header.m_argumentSize = static_cast<uint32_t>(argumentSize);
+		header.m_nameSize = static_cast<uint16_t>(callbackId.size());
+		header.m_flags = flags;
+		header.m_checksum = 0;
+		std::memcpy(recordPtr, &header, sizeof(header));
+		std::memcpy(recordPtr + sizeof(header), callbackId.data(), callbackId.size());
+		std::memcpy(recordPtr + sizeof(header) + callbackId.size(), argumentPtr, argumentSize);
+		const size_t used = sizeof(header) + callbackId.size() + argumentSize;
+		std::memset(recordPtr + used, 0, size - used);
+		header.m_checksum = journalRecordChecksum(recordPtr, header.m_size);
+		std::memcpy(recordPtr + offsetof(JournalRecordHeader, m_checksum), &header.m_checksum,
+			sizeof(header.m_checksum));
+		m_writeOffset += size;
+		segment.m_lastSequence = header.m_sequence;
+		m_done.push_back(0);
+		++m_aAppendedCount;
+		m_aAppendedBytes += static_cast<long long>(size);
+		if (syncEnabled() && (m_options.m_syncInterval.count() == 0 || m_options.m_waitForSync))
+		{
+			while (m_syncedSequence < header.m_sequence && m_open)
+			{
+				if (m_options.m_syncInterval.count() == 0 && !m_syncing)
+				{
+					// leader of this group, syncs the records of the waiting appenders too
+					syncPending(lk);
+				}
+				else
+				{
+					m_syncedCond.wait(lk);
+				}
+			}
+		}
+		return header.m_sequence;
+	}
+
+	inline void Journal::syncPending(std::unique_lock<std::mutex> & lk)
+	{
+		if (m_syncing || m_segments.empty() || !m_segments.back().m_filePtr)
+		{
+			return;
+		}
+		const uint64_t sequence = m_nextSequence - 1;
+		const size_t from = m_syncedOffset, to = m_writeOffset;
+		if (from < to)
+		{
+			std::shared_ptr<MappedFile> filePtr = m_segments.back().m_filePtr;
+			m_syncing = true;
+			lk.unlock();
+			filePtr->sync(from, to - from);
+			++m_aSyncCount;
+			lk.lock();
+			m_syncing = false;
+			if (filePtr == m_segments.back().m_filePtr)
+			{
+				m_syncedOffset = std::max(m_syncedOffset, to);
+			}
+		}
+		m_syncedSequence = std::max(m_syncedSequence, sequence);
+		m_syncedCond.notify_all();
+	}
+
+	inline void Journal::complete(uint64_t sequence)
+	{
+		std::lock_guard<std::mutex> lk(m_writeMtx);
+		if (sequence < m_windowBase || sequence - m_windowBase >= m_done.size())
+		{
+			return;
+		}
+		if (m_done[static_cast<size_t>(sequence - m_windowBase)])
+		{
+			return;
+		}
+		m_done[static_cast<size_t>(sequence - m_windowBase)] = 1;
+		while (!m_done.empty() && m_done.front())
+		{
+			m_done.pop_front();
+			++m_windowBase;
+		}
+		++m_aCompletedCount;
+	}
+
+	template<class F>
+	JournalReplayStats Journal::replay(F onRecord)
+	{
+		const auto replayStart = std::chrono::steady_clock::now();
+		JournalReplayStats stats = {};
+		std::vector<std::pair<uint64_t, size_t>> indexes; // index, verified size
+		uint64_t expected = 0, end = 0; // pending sequences which were not seen
+		{
+			std::lock_guard<std::mutex> lk(m_writeMtx);
+			if (!m_open || m_replayed)
+			{
+				return stats;
+			}
+			m_replayed = true;
+			for (const Segment & segment : m_segments)
+			{
+				if (!segment.m_filePtr)
+				{
+					indexes.push_back(std::make_pair(segment.m_index, segment.m_verifiedSize));
+				}
+			}
+			// nothing below m_windowBase completes before the replay
+			expected = m_windowBase;
+			end = m_replayEndSequence;
+		}
+		auto completeLost = [this, &stats](uint64_t from, uint64_t to) {
+			for (uint64_t sequence = from; sequence < to; ++sequence)
+			{
+				complete(sequence);
+				++stats.m_lostCount;
+			}
+		};
+		for (const std::pair<uint64_t, size_t> & index : indexes)
+		{
+			MappedFile file;
+			if (!file.open(segmentPath(index.first), 0, false))
+			{
+				continue;
+			}
+			file.adviseSequential();
+			bool corrupt = false;
+			stats.m_bytes += static_cast<long long>(scanJournalSegment(file.data(), file.size(),
+				[this, &onRecord, &stats, &expected, end, &completeLost](const JournalRecordView & record) {
+				if (record.m_sequence < expected || record.m_sequence >= end)
+				{
+					++stats.m_skippedCount;
+					return;
+				}
+				completeLost(expected, record.m_sequence);
+				expected = record.m_sequence + 1;
+				if (onRecord(record))
+				{
+					++stats.m_replayedCount;
+				}
+				else
+				{
+					++stats.m_skippedCount;
+					complete(record.m_sequence);
+				}
+			}, corrupt, index.second));
+			if (corrupt)
+			{
+				++stats.m_corruptCount;
+			}
+		}
+		completeLost(expected, end);
+		stats.m_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - replayStart);
+		return stats;
+	}
+
+	inline void Journal::checkpoint()
+	{
+		std::lock_guard<std::mutex> checkpointLk(m_checkpointMtx);
+		std::vector<std::string> removedPaths;
+		uint64_t sequence = 0, firstSegment = 0;
+		{
+			std::lock_guard<std::mutex> lk(m_writeMtx);
+			if (!m_open || m_windowBase == m_checkpointSequence)
+			{
+				return;
+			}
+			// every record of a segment before the written one is complete
+			while (m_segments.size() > 1 && m_segments.front().m_lastSequence < m_windowBase)
+			{
+				removedPaths.push_back(segmentPath(m_segments.front().m_index));
+				m_segments.pop_front();
+			}
+			m_checkpointSequence = m_windowBase;
+			sequence = m_checkpointSequence;
+			firstSegment = m_segments.front().m_index;
+		}
+		// appends go on while the checkpoint is synced
+		writeCheckpoint(sequence, firstSegment);
+		// only after the checkpoint no longer names them
+		for (const std::string & path : removedPaths)
+		{
+			MappedFile::remove(path);
+		}
+	}
+
+	inline void Journal::runSync()
+	{
+		const std::chrono::microseconds period = m_options.m_syncInterval.count() > 0 ?
+			m_options.m_syncInterval : std::chrono::microseconds(g_journalCheckpointInterval);
+		std::unique_lock<std::mutex> lk(m_writeMtx);
+		while (!m_stopping)
+		{
+			m_syncThreadCond.wait_for(lk, period);
+			if (m_options.m_syncInterval.count() > 0)
+			{
+				syncPending(lk);
+			}
+			lk.unlock();
+			checkpoint();
+			lk.lock();
+		}
+	}
+
+	inline void Journal::flush()
+	{
+		{
+			std::unique_lock<std::mutex> lk(m_writeMtx);
+			if (!m_open)
+			{
+				return;
+			}
+			while (m_syncing)
+			{
+				m_syncedCond.wait(lk);
+			}
+			if (syncEnabled())
+			{
+				syncPending(lk);
+			}
+		}
+		checkpoint();
+	}
+
+	inline void Journal::close()
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_writeMtx);
+			m_stopping = true;
+		}
+		m_syncThreadCond.notify_all();
+		if (m_syncThread.joinable())
+		{
+			m_syncThread.join();
+		}
+		flush();
+		std::lock_guard<std::mutex> lk(m_writeMtx);
+		m_open = false;
+		m_syncedCond.notify_all();
+		m_segments.clear();
+		m_done.clear();
+		m_checkpointFile.close();
+	}
+
+	inline JournalStats Journal::getStats() const
+	{
+		JournalStats stats;
+		stats.m_appendedCount = m_aAppendedCount;
+		stats.m_completedCount = m_aCompletedCount;
+		stats.m_syncCount = m_aSyncCount;
+		stats.m_appendedBytes = m_aAppendedBytes;
+		stats.m_errorCount = m_aErrorCount;
+		std::lock_guard<std::mutex> lk(m_writeMtx);
+		stats.m_checkpointSequence = m_checkpointSequence;
+		stats.m_nextSequence = m_nextSequence;
+		stats.m_segmentCount = static_cast<int>(m_segments.size());
+		return stats;
+	}
+
+	inline bool Journal::remove(const std::string & directory)
+	{
+		Journal journal;
+		journal.m_directory = directory;
+		uint64_t sequence = 0, firstSegment = 0;
+		if (journal.m_checkpointFile.open(journal.checkpointPath(), 0, false))
+		{
+			journal.readCheckpoint(sequence, firstSegment);
+			journal.m_checkpointFile.close();
+		}
+		for (uint64_t index = firstSegment; MappedFile::exists(journal.segmentPath(index)); ++index)
+		{
+			MappedFile::remove(journal.segmentPath(index));
+		}
+		MappedFile::remove(journal.checkpointPath());
+		return MappedFile::removeDirectory(directory);
+	}
+}//namespace
+
+#endif
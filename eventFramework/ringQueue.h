@@ -0,0 +1,398 @@
+/// @file ringQueue.h
+/// This file contains a bounded lock-free queue for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace eventHandling
+{
+	/// size used to keep producer and consumer indices on separate cache lines
+	static const size_t g_cacheLineSize = 64;
+	/// default number of checks before a SpinParker yields or parks
+	static const int g_defaultSpinCount = 256;
+
+	/// @brief how an idle consumer waits for work, see SpinParker
+	enum class WaitStrategy
+	{
+		busySpin = 0, // never sleeps, lowest latency, one core per waiting worker
+		spinYield = 1, // spins, then yields the core until work arrives
+		spinPark = 2, // spins, then parks on a futex (condition variable off Linux)
+		blocking = 3 // parks on a condition variable right away
+	};
+
+	/// @brief Spin then park helper for a single consumer
+	/// @details The consumer waits as its WaitStrategy says, by default it spins
+	///          for a while before it parks on a futex word. Producers only make
+	///          a syscall when the consumer is actually parked, so the common
+	///          case is syscall free. The parked flag and the checks of ready()
+	///          are ordered by seq_cst fences, either the producer sees the flag
+	///          or the consumer sees the work.
+	class SpinParker
+	{
+		std::mutex m_parkMtx;
+		std::condition_variable m_parkCond;
+		std::atomic<int> m_aParked;
+		std::atomic<uint32_t> m_aWakeCount; // futex word, changes with every wake()
+		std::atomic<int> m_aStrategy; // WaitStrategy
+		std::atomic<int> m_aSpinCount;
+
+		/// @brief sleep while m_aWakeCount is wakeCount, may return early
+		void parkFutex(uint32_t wakeCount, std::chrono::nanoseconds timeout)
+		{
+#ifdef __linux__
+			static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+				"the futex word has to be a plain 32 bit integer");
+			struct timespec relative;
+			relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+			relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+			syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_aWakeCount), FUTEX_WAIT_PRIVATE,
+				wakeCount, &relative, nullptr, 0);
+#else
+			std::unique_lock<std::mutex> lk(m_parkMtx);
+			m_parkCond.wait_for(lk, timeout, [this, wakeCount] {
+				return m_aWakeCount.load() != wakeCount; });
+#endif
+		}
+		/// @brief spinPark after the spinning, one futex wait per wake()
+		template<class Pred>
+		bool parkOnWord(Pred & ready, std::chrono::milliseconds timeout)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			for (;;)
+			{
+				const uint32_t wakeCount = m_aWakeCount.load(std::memory_order_acquire);
+				m_aParked.store(1, std::memory_order_seq_cst);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (ready())
+				{
+					m_aParked.store(0, std::memory_order_relaxed);
+					return true;
+				}
+				const auto now = std::chrono::steady_clock::now();
+				if (now >= deadline)
+				{
+					m_aParked.store(0, std::memory_order_relaxed);
+					return false;
+				}
+				// returns at once in case a wake() came after wakeCount was read
+				parkFutex(wakeCount, deadline - now);
+				m_aParked.store(0, std::memory_order_relaxed);
+				if (ready())
+				{
+					return true;
+				}
+			}
+		}
+		template<class Pred>
+		bool parkOnCondition(Pred & ready, std::chrono::milliseconds timeout)
+		{
+			std::unique_lock<std::mutex> lk(m_parkMtx);
+			m_aParked.store(1, std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			bool res = m_parkCond.wait_for(lk, timeout, ready);
+			m_aParked.store(0, std::memory_order_relaxed);
+			return res;
+		}
+		/// @brief check ready() without sleeping until timeout, yielding or not
+		template<class Pred>
+		static bool spinUntil(Pred & ready, std::chrono::milliseconds timeout, bool yield)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			for (unsigned i = 1; ; ++i)
+			{
+				if (ready())
+				{
+					return true;
+				}
+				// the clock costs more than a check, read it now and then
+				if (i % 1024 == 0 && std::chrono::steady_clock::now() >= deadline)
+				{
+					return false;
+				}
+				if (yield)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+	public:
+		SpinParker(int spinCount = g_defaultSpinCount) : m_aParked(0), m_aWakeCount(0),
+			m_aStrategy(static_cast<int>(WaitStrategy::spinPark)), m_aSpinCount(spinCount) {}
+		SpinParker& operator = (SpinParker&) = delete;
+
+		bool isParked() const
+		{
+			return m_aParked.load(std::memory_order_relaxed) != 0;
+		}
+		WaitStrategy getStrategy() const
+		{
+			return static_cast<WaitStrategy>(m_aStrategy.load(std::memory_order_relaxed));
+		}
+		int getSpinCount() const
+		{
+			return m_aSpinCount.load(std::memory_order_relaxed);
+		}
+		/// @brief change how the consumer waits, a parked consumer wakes up for it
+		/// @param spinCount checks before spinYield yields and spinPark parks
+		void setStrategy(WaitStrategy strategy, int spinCount = g_defaultSpinCount)
+		{
+			m_aSpinCount = std::max(spinCount, 0);
+			m_aStrategy = static_cast<int>(strategy);
+			wake();
+		}
+
+		/// @brief Wait until ready() returns true or timeout expires
+		/// @param ready predicate checked while spinning and while parked
+		/// @param timeout upper bound for the waiting after the spinning
+		/// @return value of ready() when the wait ended
+		template<class Pred>
+		bool wait(Pred ready, std::chrono::milliseconds timeout)
+		{
+			const WaitStrategy strategy = getStrategy();
+			if (strategy == WaitStrategy::busySpin)
+			{
+				return spinUntil(ready, timeout, false);
+			}
+			if (strategy != WaitStrategy::blocking)
+			{
+				const int spinCount = getSpinCount();
+				for (int i = 0; i < spinCount; ++i)
+				{
+					if (ready())
+					{
+						return true;
+					}
+					if (i > spinCount / 2)
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+			switch (strategy)
+			{
+			case WaitStrategy::spinYield:
+				return spinUntil(ready, timeout, true);
+			case WaitStrategy::spinPark:
+				return parkOnWord(ready, timeout);
+			default:
+				return parkOnCondition(ready, timeout);
+			}
+		}
+
+		/// @brief Wake the consumer if it is parked, cheap otherwise
+		/// @details Must be called after the state checked by ready() was published
+		void notify()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_aParked.load(std::memory_order_relaxed) != 0)
+			{
+				wake();
+			}
+		}
+
+		/// @brief Unconditionally wake the consumer, used for stop and reset
+		void wake()
+		{
+			m_aWakeCount.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+			syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_aWakeCount), FUTEX_WAKE_PRIVATE,
+				INT_MAX, nullptr, nullptr, 0);
+#endif
+			{
+				std::lock_guard<std::mutex> lk(m_parkMtx);
+			}
+			m_parkCond.notify_all();
+		}
+	};
+
+	/// @brief Bounded lock-free multi-producer single-consumer ring queue
+	/// @details Each cell carries a sequence number (Vyukov style), producers claim
+	///          a slot with one CAS on the enqueue index, the consumer never uses
+	///          atomic read-modify-write operations. Capacity is rounded up to the
+	///          next power of two. Only one thread may call tryPop()/pop().
+	template<class T>
+	class RingQueue
+	{
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> m_aSequence;
+			T m_data;
+		};
+		std::unique_ptr<Cell[]> m_cells;
+		size_t m_mask;
+		char m_pad0[g_cacheLineSize];
+		std::atomic<size_t> m_aEnqueuePos;
+		char m_pad1[g_cacheLineSize - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> m_aDequeuePos;
+		char m_pad2[g_cacheLineSize - sizeof(std::atomic<size_t>)];
+		SpinParker m_parker;
+
+		static size_t roundUpCapacity(size_t capacity)
+		{
+			size_t res = 2;
+			while (res < capacity)
+			{
+				res <<= 1;
+			}
+			return res;
+		}
+	public:
+		explicit RingQueue(size_t capacity = 128);
+		RingQueue& operator = (RingQueue&) = delete;
+
+		/// @brief Append a value, value is left untouched on failure
+		/// @param notifyConsumer false to wake the consumer later, e.g. once per batch
+		/// @return false in case the queue is full
+		bool tryPush(T&& value, bool notifyConsumer = true);
+		/// @brief Take the oldest value, consumer thread only
+		/// @return false in case the queue is empty
+		bool tryPop(T& value);
+		/// @brief Take the oldest value, spin then park while the queue is empty
+		/// @param interrupted predicate which ends the wait early, e.g. a stop flag
+		/// @return false in case nothing was taken
+		template<class Pred>
+		bool pop(T& value, Pred interrupted,
+			std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+		/// @brief Spin then park until the queue has data or interrupted() is true
+		template<class Pred>
+		bool wait(Pred interrupted,
+			std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+		/// @brief Wake a parked consumer, e.g. after changing a stop flag
+		void wake()
+		{
+			m_parker.wake();
+		}
+		SpinParker & parker()
+		{
+			return m_parker;
+		}
+		bool empty() const;
+		size_t size() const;
+		size_t capacity() const
+		{
+			return m_mask + 1;
+		}
+	};
+
+	template<class T>
+	RingQueue<T>::RingQueue(size_t capacity) : m_mask(roundUpCapacity(capacity) - 1),
+		m_aEnqueuePos(0), m_aDequeuePos(0)
+	{
+		m_cells.reset(new Cell[m_mask + 1]);
+		for (size_t i = 0; i <= m_mask; ++i)
+		{
+			m_cells[i].m_aSequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	template<class T>
+	bool RingQueue<T>::tryPush(T&& value, bool notifyConsumer)
+	{
+		Cell * cell = nullptr;
+		size_t pos = m_aEnqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t seq = cell->m_aSequence.load(std::memory_order_acquire);
+			intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (dif == 0)
+			{
+				if (m_aEnqueuePos.compare_exchange_weak(pos, pos + 1,
+					std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (dif < 0)
+			{
+				return false;//full
+			}
+			else
+			{
+				pos = m_aEnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->m_data = std::move(value);
+		cell->m_aSequence.store(pos + 1, std::memory_order_release);
+		if (notifyConsumer)
+		{
+			m_parker.notify();
+		}
+		return true;
+	}
+
+	template<class T>
+	bool RingQueue<T>::tryPop(T& value)
+	{
+		size_t pos = m_aDequeuePos.load(std::memory_order_relaxed);
+		Cell & cell = m_cells[pos & m_mask];
+		size_t seq = cell.m_aSequence.load(std::memory_order_acquire);
+		if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+		{
+			return false;//empty
+		}
+		value = std::move(cell.m_data);
+		cell.m_data = T();
+		cell.m_aSequence.store(pos + m_mask + 1, std::memory_order_release);
+		m_aDequeuePos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<class T>
+	template<class Pred>
+	bool RingQueue<T>::wait(Pred interrupted, std::chrono::milliseconds timeout)
+	{
+		m_parker.wait([&] { return !empty() || interrupted(); }, timeout);
+		return !empty();
+	}
+
+	template<class T>
+	template<class Pred>
+	bool RingQueue<T>::pop(T& value, Pred interrupted, std::chrono::milliseconds timeout)
+	{
+		if (tryPop(value))
+		{
+			return true;
+		}
+		wait(interrupted, timeout);
+		return tryPop(value);
+	}
+
+	template<class T>
+	bool RingQueue<T>::empty() const
+	{
+		size_t pos = m_aDequeuePos.load(std::memory_order_acquire);
+		const Cell & cell = m_cells[pos & m_mask];
+		return static_cast<intptr_t>(cell.m_aSequence.load(std::memory_order_acquire))
+			- static_cast<intptr_t>(pos + 1) < 0;
+	}
+
+	template<class T>
+	size_t RingQueue<T>::size() const
+	{
+		size_t tail = m_aDequeuePos.load(std::memory_order_acquire);
+		size_t head = m_aEnqueuePos.load(std::memory_order_acquire);
+		return head > tail ? head - tail : 0;
+	}
+}//namespace
+
+#endif
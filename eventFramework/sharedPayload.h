@@ -0,0 +1,57 @@
+/// @file sharedPayload.h
+/// This file contains a refcounted immutable payload for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef SHARED_PAYLOAD_H
+#define SHARED_PAYLOAD_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace eventHandling
+{
+	/// @brief Immutable value shared by all subscribers of a call
+	/// @details The value is wrapped once, copying a SharedPayload only touches the
+	///          reference count. Subscribers get a const view, so one payload can be
+	///          fanned out to many subscribers, calls or topics without copies.
+	template<class T>
+	class SharedPayload
+	{
+		std::shared_ptr<const T> m_payloadPtr;
+	public:
+		SharedPayload() = default;
+		explicit SharedPayload(T value) : m_payloadPtr(std::make_shared<const T>(std::move(value))) {}
+		explicit SharedPayload(std::shared_ptr<const T> payloadPtr) : m_payloadPtr(std::move(payloadPtr)) {}
+		const T & get() const
+		{
+			return *m_payloadPtr;
+		}
+		const T & operator * () const
+		{
+			return *m_payloadPtr;
+		}
+		const T * operator -> () const
+		{
+			return m_payloadPtr.get();
+		}
+		explicit operator bool() const
+		{
+			return static_cast<bool>(m_payloadPtr);
+		}
+		/// number of SharedPayloads holding the value, for tests and diagnostics
+		long useCount() const
+		{
+			return m_payloadPtr.use_count();
+		}
+	};
+
+	/// @brief wrap value once, moves it in when possible
+	template<class T>
+	SharedPayload<typename std::decay<T>::type> makeSharedPayload(T && value)
+	{
+		return SharedPayload<typename std::decay<T>::type>(
+			typename std::decay<T>::type(std::forward<T>(value)));
+	}
+}//namespace
+
+#endif
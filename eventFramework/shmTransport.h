@@ -0,0 +1,566 @@
+/// @file shmTransport.h
+/// This file contains a shared memory ring to publish events from other processes
+/// It is implemented using constructs from C++14 standard.
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "ringQueue.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace eventHandling
+{
+	/// ring bytes of EventBus::attachShmTransport() by default
+	static const size_t g_shmDefaultCapacity = size_t(1) << 20;
+	/// frames start at multiples of it, a padding frame always has room for a header
+	static const size_t g_shmFrameAlignment = 16;
+	/// ring data starts at this offset of the mapping, after ShmRing::Header
+	static const size_t g_shmDataOffset = 4096;
+	/// set in the header by ShmRing::create() once the ring is ready
+	static const uint32_t g_shmMagic = 0x52534d45;
+	/// ShmFrameHeader::m_flags, the call has no argument
+	static const uint16_t g_shmFlagNoArgument = 1;
+	/// ShmFrameHeader::m_flags, fills the end of the ring, no call
+	static const uint16_t g_shmFlagPadding = 2;
+
+	/// @brief Header of a frame, followed by the callback id and the argument
+	struct ShmFrameHeader
+	{
+		uint32_t m_size; // including header and padding, stored last, 0 while written
+		uint16_t m_nameSize;
+		uint16_t m_flags;
+		uint32_t m_argumentSize;
+		uint32_t m_reserved;
+	};
+
+	/// @brief A frame in the ring, only valid during ShmRing::consume()
+	struct ShmFrameView
+	{
+		const char * m_namePtr;
+		size_t m_nameSize;
+		const char * m_argumentPtr;
+		size_t m_argumentSize;
+		uint16_t m_flags;
+	};
+
+	/// @brief Multi-producer single-consumer byte ring in POSIX shared memory
+	/// @details The consumer process create()s the ring in /dev/shm, publisher
+	///          processes open() it by name. A publisher reserves its frame with
+	///          one CAS on the tail, copies it and stores the frame size last; the
+	///          consumer reads frames in order, zeroes them and moves the head.
+	///          Like SpinParker the consumer spins before it parks on a futex word
+	///          in the shared header, publishers only make a syscall when it is
+	///          parked, so the common case needs no syscall on either side. A
+	///          publisher which dies between reserve and store stalls the ring.
+	///          Off Linux the parked consumer polls every millisecond.
+	class ShmRing
+	{
+		struct Header
+		{
+			std::atomic<uint32_t> m_aMagic; // g_shmMagic once the ring is ready
+			uint32_t m_reserved;
+			uint64_t m_capacity; // power of two
+			alignas(g_cacheLineSize) std::atomic<uint64_t> m_aTail; // reserved by publishers
+			std::atomic<long long> m_aFullCount; // publishes rejected for lack of space
+			alignas(g_cacheLineSize) std::atomic<uint64_t> m_aHead; // consumed
+			std::atomic<uint32_t> m_aWakeCount; // futex word, changes with every wake()
+			std::atomic<uint32_t> m_aParked;
+		};
+		static_assert(sizeof(Header) <= g_shmDataOffset, "the header has to fit before the data");
+		static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+			"frame sizes and the futex word have to be plain 32 bit integers");
+
+		std::string m_name;
+		char * m_mappingPtr;
+		size_t m_mappingSize;
+		Header * m_headerPtr;
+		char * m_ringPtr;
+		uint64_t m_capacity;
+		bool m_owner; // created the ring, removes the name on close()
+#ifdef _WIN32
+		HANDLE m_mapping;
+#endif
+
+		static std::string systemName(const std::string & name)
+		{
+#ifdef _WIN32
+			return "Local\\" + name;
+#else
+			return name.empty() || name[0] != '/' ? "/" + name : name;
+#endif
+		}
+		static size_t frameSize(size_t nameSize, size_t argumentSize)
+		{
+			const size_t size = sizeof(ShmFrameHeader) + nameSize + argumentSize;
+			return (size + g_shmFrameAlignment - 1) / g_shmFrameAlignment * g_shmFrameAlignment;
+		}
+		static std::atomic<uint32_t> & sizeWord(char * framePtr)
+		{
+			return *reinterpret_cast<std::atomic<uint32_t> *>(framePtr);
+		}
+		bool map(const std::string & name, size_t size, bool create);
+		/// @brief sleep while the futex word is wakeCount, may return early
+		void parkFutex(uint32_t wakeCount, std::chrono::milliseconds timeout);
+	public:
+#ifdef _WIN32
+		ShmRing() : m_mappingPtr(nullptr), m_mappingSize(0), m_headerPtr(nullptr),
+			m_ringPtr(nullptr), m_capacity(0), m_owner(false), m_mapping(nullptr) {}
+#else
+		ShmRing() : m_mappingPtr(nullptr), m_mappingSize(0), m_headerPtr(nullptr),
+			m_ringPtr(nullptr), m_capacity(0), m_owner(false) {}
+#endif
+		ShmRing(const ShmRing&) = delete;
+		ShmRing& operator = (const ShmRing&) = delete;
+		~ShmRing()
+		{
+			close();
+		}
+		/// @brief create the ring name for the consumer, a stale one is replaced
+		/// @param capacity bytes, rounded up to a power of two of at least 4096
+		/// @return false in case the shared memory can not be created
+		bool create(const std::string & name, size_t capacity = g_shmDefaultCapacity);
+		/// @brief open the ring name of a consumer for publishing
+		/// @return false in case it does not exist or is not ready
+		bool open(const std::string & name);
+		/// @brief unmap, the consumer also removes the name
+		void close();
+		bool isOpen() const
+		{
+			return m_headerPtr != nullptr;
+		}
+		const std::string & getName() const
+		{
+			return m_name;
+		}
+		size_t getCapacity() const
+		{
+			return static_cast<size_t>(m_capacity);
+		}
+		/// @brief remove the name of a ring, mappings stay valid until closed
+		static bool remove(const std::string & name);
+		/// @brief copy a call of callbackId with its serialized argument into the ring
+		/// @param flags ShmFrameHeader::m_flags, e.g. g_shmFlagNoArgument
+		/// @return false in case the ring is full or the frame is larger than half of it
+		bool publish(const std::string & callbackId, const char * argumentPtr, size_t argumentSize,
+			uint16_t flags = 0);
+		/// @brief hand up to maxFrames frames to onFrame(const ShmFrameView &), consumer only
+		/// @return number of frames handed on
+		template<class F>
+		size_t consume(F onFrame, size_t maxFrames);
+		/// @brief true in case consume() would find a frame
+		bool hasFrame() const
+		{
+			if (!m_headerPtr)
+			{
+				return false;
+			}
+			char * framePtr = m_ringPtr + (m_headerPtr->m_aHead.load(std::memory_order_relaxed) &
+				(m_capacity - 1));
+			return sizeWord(framePtr).load(std::memory_order_acquire) != 0;
+		}
+		/// @brief wait for a frame, consumer only
+		/// @param spinCount checks before parking, the second half yields
+		/// @param park false to keep checking until timeout instead of parking
+		/// @return hasFrame() when the wait ended
+		bool waitForFrame(std::chrono::milliseconds timeout, int spinCount = g_defaultSpinCount,
+			bool park = true);
+		/// @brief wake the parked consumer, e.g. to let it see a stop request
+		void wake();
+		/// @brief publishes rejected because the ring was full, over all publishers
+		long long getFullCount() const
+		{
+			return m_headerPtr ? m_headerPtr->m_aFullCount.load() : 0;
+		}
+	};
+
+	/// @brief Publishing side of EventBus::attachShmTransport() for other processes
+	/// @details Only needs this header. Calls are matched to the topics of the bus by
+	///          their callback id, one std::string argument or none is supported.
+	///          publish() never blocks, it returns false while the ring is full.
+	class ShmPublisher
+	{
+		ShmRing m_ring;
+	public:
+		/// @return false in case no bus attached a transport named name
+		bool open(const std::string & name)
+		{
+			return m_ring.open(name);
+		}
+		void close()
+		{
+			m_ring.close();
+		}
+		bool isOpen() const
+		{
+			return m_ring.isOpen();
+		}
+		bool publish(const std::string & callbackId)
+		{
+			return m_ring.publish(callbackId, nullptr, 0, g_shmFlagNoArgument);
+		}
+		bool publish(const std::string & callbackId, const std::string & argument)
+		{
+			return m_ring.publish(callbackId, argument.data(), argument.size());
+		}
+		long long getFullCount() const
+		{
+			return m_ring.getFullCount();
+		}
+	};
+
+	inline bool ShmRing::create(const std::string & name, size_t capacity)
+	{
+		close();
+		size_t roundedCapacity = 4096;
+		while (roundedCapacity < capacity)
+		{
+			roundedCapacity <<= 1;
+		}
+		remove(name);
+		if (!map(name, g_shmDataOffset + roundedCapacity, true))
+		{
+			return false;
+		}
+		m_owner = true;
+		m_capacity = roundedCapacity;
+		m_headerPtr = new (m_mappingPtr) Header();
+		m_headerPtr->m_capacity = m_capacity;
+		m_headerPtr->m_aTail = 0;
+		m_headerPtr->m_aFullCount = 0;
+		m_headerPtr->m_aHead = 0;
+		m_headerPtr->m_aWakeCount = 0;
+		m_headerPtr->m_aParked = 0;
+		m_ringPtr = m_mappingPtr + g_shmDataOffset;
+		// new shared memory is zero filled, no frame is published
+		m_headerPtr->m_aMagic.store(g_shmMagic, std::memory_order_release);
+		return true;
+	}
+
+	inline bool ShmRing::open(const std::string & name)
+	{
+		close();
+		if (!map(name, 0, false))
+		{
+			return false;
+		}
+		Header * headerPtr = reinterpret_cast<Header *>(m_mappingPtr);
+		if (headerPtr->m_aMagic.load(std::memory_order_acquire) != g_shmMagic ||
+			headerPtr->m_capacity < 4096 || (headerPtr->m_capacity & (headerPtr->m_capacity - 1)) != 0 ||
+			g_shmDataOffset + headerPtr->m_capacity > m_mappingSize)
+		{
+			close();
+			return false;
+		}
+		m_headerPtr = headerPtr;
+		m_capacity = headerPtr->m_capacity;
+		m_ringPtr = m_mappingPtr + g_shmDataOffset;
+		return true;
+	}
+
+	inline bool ShmRing::publish(const std::string & callbackId, const char * argumentPtr,
+		size_t argumentSize, uint16_t flags)
+	{
+		const size_t size = frameSize(callbackId.size(), argumentSize);
+		if (!m_headerPtr || callbackId.size() > 0xffff || size > m_capacity / 2)
+		{
+			return false;
+		}
+		Header & header = *m_headerPtr;
+		uint64_t tail = header.m_aTail.load(std::memory_order_relaxed);
+		uint64_t pad = 0;
+		for (;;)
+		{
+			const uint64_t offset = tail & (m_capacity - 1);
+			// a frame never wraps, the rest of the ring becomes a padding frame
+			pad = offset + size > m_capacity ? m_capacity - offset : 0;
+			if (tail + pad + size - header.m_aHead.load(std::memory_order_acquire) > m_capacity)
+			{
+				header.m_aFullCount.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			if (header.m_aTail.compare_exchange_weak(tail, tail + pad + size,
+				std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		if (pad > 0)
+		{
+			char * paddingPtr = m_ringPtr + (tail & (m_capacity - 1));
+			ShmFrameHeader padding = {};
+			padding.m_flags = g_shmFlagPadding;
+			std::memcpy(paddingPtr, &padding, sizeof(padding));
+			sizeWord(paddingPtr).store(static_cast<uint32_t>(pad), std::memory_order_release);
+		}
+		char * framePtr = m_ringPtr + ((tail + pad) & (m_capacity - 1));
+		ShmFrameHeader frame = {};
+		frame.m_nameSize = static_cast<uint16_t>(callbackId.size());
+		frame.m_flags = flags;
+		frame.m_argumentSize = static_cast<uint32_t>(argumentSize);
+		std::memcpy(framePtr, &frame, sizeof(frame));
+		std::memcpy(framePtr + sizeof(frame), callbackId.data(), callbackId.size());
+		if (argumentSize > 0)
+		{
+			std::memcpy(framePtr + sizeof(frame) + callbackId.size(), argumentPtr, argumentSize);
+		}
+		sizeWord(framePtr).store(static_cast<uint32_t>(size), std::memory_order_release);
+		// either the consumer sees the frame or the parked flag is seen here
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (header.m_aParked.load(std::memory_order_relaxed) != 0)
+		{
+			wake();
+		}
+		return true;
+	}
+
+	template<class F>
+	size_t ShmRing::consume(F onFrame, size_t maxFrames)
+	{
+		if (!m_headerPtr)
+		{
+			return 0;
+		}
+		Header & header = *m_headerPtr;
+		uint64_t head = header.m_aHead.load(std::memory_order_relaxed);
+		size_t count = 0;
+		while (count < maxFrames)
+		{
+			const uint64_t offset = head & (m_capacity - 1);
+			char * framePtr = m_ringPtr + offset;
+			const uint32_t size = sizeWord(framePtr).load(std::memory_order_acquire);
+			if (size == 0)
+			{
+				break;
+			}
+			ShmFrameHeader frame;
+			std::memcpy(&frame, framePtr, sizeof(frame));
+			if (size % g_shmFrameAlignment != 0 || size > m_capacity - offset ||
+				sizeof(frame) + frame.m_nameSize + size_t(frame.m_argumentSize) > size)
+			{
+				break;// damaged by a publisher, the ring stalls instead of reading past it
+			}
+			if ((frame.m_flags & g_shmFlagPadding) == 0)
+			{
+				ShmFrameView view;
+				view.m_namePtr = framePtr + sizeof(frame);
+				view.m_nameSize = frame.m_nameSize;
+				view.m_argumentPtr = view.m_namePtr + frame.m_nameSize;
+				view.m_argumentSize = frame.m_argumentSize;
+				view.m_flags = frame.m_flags;
+				onFrame(view);
+				++count;
+			}
+			// any offset of the frame may start a later one
+			std::memset(framePtr, 0, size);
+			head += size;
+			header.m_aHead.store(head, std::memory_order_release);
+		}
+		return count;
+	}
+
+	inline bool ShmRing::waitForFrame(std::chrono::milliseconds timeout, int spinCount, bool park)
+	{
+		if (!m_headerPtr)
+		{
+			return false;
+		}
+		for (int i = 0; i < spinCount; ++i)
+		{
+			if (hasFrame())
+			{
+				return true;
+			}
+			if (i > spinCount / 2)
+			{
+				std::this_thread::yield();
+			}
+		}
+		if (!park)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			while (!hasFrame() && std::chrono::steady_clock::now() < deadline)
+			{
+				std::this_thread::yield();
+			}
+			return hasFrame();
+		}
+		Header & header = *m_headerPtr;
+		const uint32_t wakeCount = header.m_aWakeCount.load(std::memory_order_acquire);
+		header.m_aParked.store(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!hasFrame())
+		{
+			// returns at once in case a wake() came after wakeCount was read
+			parkFutex(wakeCount, timeout);
+		}
+		header.m_aParked.store(0, std::memory_order_relaxed);
+		return hasFrame();
+	}
+
+#ifdef _WIN32
+	inline bool ShmRing::map(const std::string & name, size_t size, bool create)
+	{
+		const std::string mappingName = systemName(name);
+		const unsigned long long mappingSize = size;
+		m_mapping = create ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), mappingName.c_str()) :
+			OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+		if (!m_mapping)
+		{
+			return false;
+		}
+		m_mappingPtr = static_cast<char *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+		MEMORY_BASIC_INFORMATION info;
+		if (!m_mappingPtr || VirtualQuery(m_mappingPtr, &info, sizeof(info)) == 0)
+		{
+			close();
+			return false;
+		}
+		m_mappingSize = info.RegionSize;
+		m_name = name;
+		return true;
+	}
+	inline void ShmRing::close()
+	{
+		if (m_mappingPtr)
+		{
+			UnmapViewOfFile(m_mappingPtr);
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+		m_mappingPtr = nullptr;
+		m_mappingSize = 0;
+		m_headerPtr = nullptr;
+		m_ringPtr = nullptr;
+		m_capacity = 0;
+		m_owner = false;
+	}
+	inline bool ShmRing::remove(const std::string & name)
+	{
+		// the mapping goes away with its last handle
+		return true;
+	}
+	inline void ShmRing::parkFutex(uint32_t wakeCount, std::chrono::milliseconds timeout)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		while (m_headerPtr->m_aWakeCount.load() == wakeCount && !hasFrame() &&
+			std::chrono::steady_clock::now() < deadline)
+		{
+			Sleep(1);
+		}
+	}
+	inline void ShmRing::wake()
+	{
+		m_headerPtr->m_aWakeCount.fetch_add(1, std::memory_order_seq_cst);
+	}
+#else
+	inline bool ShmRing::map(const std::string & name, size_t size, bool create)
+	{
+		const std::string path = systemName(name);
+		int fd = shm_open(path.c_str(), O_RDWR | (create ? O_CREAT | O_EXCL : 0), 0600);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat fileStat;
+		if ((create && ftruncate(fd, static_cast<off_t>(size)) != 0) || fstat(fd, &fileStat) != 0 ||
+			fileStat.st_size < static_cast<off_t>(g_shmDataOffset))
+		{
+			::close(fd);
+			if (create)
+			{
+				shm_unlink(path.c_str());
+			}
+			return false;
+		}
+		void * mappingPtr = mmap(nullptr, static_cast<size_t>(fileStat.st_size),
+			PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		// the mapping keeps the memory, not the descriptor
+		::close(fd);
+		if (mappingPtr == MAP_FAILED)
+		{
+			if (create)
+			{
+				shm_unlink(path.c_str());
+			}
+			return false;
+		}
+		m_mappingPtr = static_cast<char *>(mappingPtr);
+		m_mappingSize = static_cast<size_t>(fileStat.st_size);
+		m_name = name;
+		return true;
+	}
+	inline void ShmRing::close()
+	{
+		if (m_mappingPtr)
+		{
+			munmap(m_mappingPtr, m_mappingSize);
+		}
+		if (m_owner)
+		{
+			remove(m_name);
+		}
+		m_mappingPtr = nullptr;
+		m_mappingSize = 0;
+		m_headerPtr = nullptr;
+		m_ringPtr = nullptr;
+		m_capacity = 0;
+		m_owner = false;
+	}
+	inline bool ShmRing::remove(const std::string & name)
+	{
+		return shm_unlink(systemName(name).c_str()) == 0;
+	}
+	inline void ShmRing::parkFutex(uint32_t wakeCount, std::chrono::milliseconds timeout)
+	{
+#ifdef __linux__
+		// shared futex, the word lives in memory of several processes
+		struct timespec relative;
+		relative.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+		relative.tv_nsec = static_cast<long>(timeout.count() % 1000 * 1000000);
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_headerPtr->m_aWakeCount), FUTEX_WAIT,
+			wakeCount, &relative, nullptr, 0);
+#else
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		while (m_headerPtr->m_aWakeCount.load() == wakeCount && !hasFrame() &&
+			std::chrono::steady_clock::now() < deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+#endif
+	}
+	inline void ShmRing::wake()
+	{
+		m_headerPtr->m_aWakeCount.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_headerPtr->m_aWakeCount), FUTEX_WAKE,
+			INT_MAX, nullptr, nullptr, 0);
+#endif
+	}
+#endif
+}//namespace
+
+#endif
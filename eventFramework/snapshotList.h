@@ -0,0 +1,301 @@
+/// @file snapshotList.h
+/// This file contains copy on write lists with epoch based reclamation for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef SNAPSHOT_LIST_H
+#define SNAPSHOT_LIST_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace eventHandling
+{
+	/// number of reader slots of the EpochDomain, further threads share a lock
+	static const size_t g_epochSlots = 128;
+	/// epoch of a reader slot outside of a read section
+	static const uint64_t g_epochIdle = std::numeric_limits<uint64_t>::max();
+
+	/// @brief Epoch based reclamation for read mostly data
+	/// @details A reader publishes the global epoch in its own slot for the time
+	///          of a read section. A writer retires a replaced object with the
+	///          current epoch and advances it, the object is freed once every
+	///          reader slot is idle or shows a later epoch. Readers never wait,
+	///          threads beyond g_epochSlots fall back to a shared lock.
+	class EpochDomain
+	{
+		struct alignas(64) Slot
+		{
+			Slot() : m_aEpoch(g_epochIdle), m_aOwned(false) {}
+			std::atomic<uint64_t> m_aEpoch;
+			std::atomic<bool> m_aOwned;
+		};
+		struct Retired
+		{
+			uint64_t m_epoch;
+			void * m_objectPtr;
+			void(*m_deleter)(void *);
+		};
+		/// @brief slot and nesting depth of a thread, the slot is freed at thread exit
+		struct ThreadState
+		{
+			ThreadState() : m_slot(-2), m_depth(0) {}
+			~ThreadState()
+			{
+				if (m_slot >= 0)
+				{
+					EpochDomain::instance().releaseSlot(m_slot);
+				}
+			}
+			int m_slot; // -2 not claimed yet, -1 none left
+			int m_depth;
+		};
+		Slot m_slots[g_epochSlots];
+		std::atomic<uint64_t> m_aEpoch;
+		std::shared_timed_mutex m_overflowMtx; // readers without a slot
+		std::mutex m_retiredMtx; // m_retired
+		std::vector<Retired> m_retired;
+
+		EpochDomain() : m_aEpoch(0) {}
+		static ThreadState & threadState()
+		{
+			static thread_local ThreadState state;
+			return state;
+		}
+		int claimSlot()
+		{
+			for (size_t i = 0; i < g_epochSlots; ++i)
+			{
+				bool expected = false;
+				if (!m_slots[i].m_aOwned.load(std::memory_order_relaxed) &&
+					m_slots[i].m_aOwned.compare_exchange_strong(expected, true))
+				{
+					return static_cast<int>(i);
+				}
+			}
+			return -1;
+		}
+		void releaseSlot(int slot)
+		{
+			m_slots[slot].m_aEpoch.store(g_epochIdle);
+			m_slots[slot].m_aOwned.store(false);
+		}
+	public:
+		EpochDomain& operator = (EpochDomain&) = delete;
+		~EpochDomain()
+		{
+			for (Retired & retired : m_retired)
+			{
+				retired.m_deleter(retired.m_objectPtr);
+			}
+		}
+		/// the domain shared by all SnapshotLists
+		static EpochDomain & instance()
+		{
+			static EpochDomain domain;
+			return domain;
+		}
+		/// @brief start a read section, sections of one thread may nest
+		void enter()
+		{
+			ThreadState & state = threadState();
+			if (state.m_depth++ > 0)
+			{
+				return;
+			}
+			if (state.m_slot == -2)
+			{
+				state.m_slot = claimSlot();
+			}
+			if (state.m_slot >= 0)
+			{
+				// seq_cst, the store has to be visible before the reader loads a pointer
+				m_slots[state.m_slot].m_aEpoch.store(m_aEpoch.load());
+			}
+			else
+			{
+				m_overflowMtx.lock_shared();
+			}
+		}
+		void leave()
+		{
+			ThreadState & state = threadState();
+			if (--state.m_depth > 0)
+			{
+				return;
+			}
+			if (state.m_slot >= 0)
+			{
+				m_slots[state.m_slot].m_aEpoch.store(g_epochIdle, std::memory_order_release);
+			}
+			else
+			{
+				m_overflowMtx.unlock_shared();
+			}
+		}
+		/// @brief delete objectPtr once no reader can see it any more
+		/// @details objectPtr has to be unreachable for new readers already
+		template<class T>
+		void retire(const T * objectPtr)
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_retiredMtx);
+				m_retired.push_back(Retired{ m_aEpoch.fetch_add(1), const_cast<T *>(objectPtr),
+					[](void * ptr) { delete static_cast<T *>(ptr); } });
+			}
+			reclaim();
+		}
+		/// @brief free the retired objects of past read sections
+		/// @return number of objects still waiting for readers
+		size_t reclaim()
+		{
+			std::vector<Retired> freed;
+			size_t waiting = 0;
+			{
+				std::lock_guard<std::mutex> lk(m_retiredMtx);
+				uint64_t oldestReader = g_epochIdle;
+				for (const Slot & slot : m_slots)
+				{
+					oldestReader = std::min(oldestReader, slot.m_aEpoch.load());
+				}
+				// readers without a slot may hold anything retired
+				std::unique_lock<std::shared_timed_mutex> overflowLk(m_overflowMtx, std::try_to_lock);
+				if (!overflowLk.owns_lock())
+				{
+					oldestReader = 0;
+				}
+				auto kept = std::partition(m_retired.begin(), m_retired.end(),
+					[oldestReader](const Retired & retired) { return retired.m_epoch >= oldestReader; });
+				freed.assign(kept, m_retired.end());
+				m_retired.erase(kept, m_retired.end());
+				waiting = m_retired.size();
+			}
+			for (Retired & retired : freed)
+			{
+				retired.m_deleter(retired.m_objectPtr);
+			}
+			return waiting;
+		}
+	};
+
+	/// @brief read section of the calling thread, see EpochDomain
+	class EpochGuard
+	{
+	public:
+		EpochGuard()
+		{
+			EpochDomain::instance().enter();
+		}
+		~EpochGuard()
+		{
+			EpochDomain::instance().leave();
+		}
+		EpochGuard(const EpochGuard&) = delete;
+		EpochGuard& operator = (const EpochGuard&) = delete;
+	};
+
+	/// @brief Copy on write list, readers see an immutable snapshot without locks
+	/// @details Every change copies the current snapshot under a writer lock and
+	///          publishes the new one with a single atomic store, the replaced
+	///          snapshot is reclaimed through the EpochDomain. Meant for lists
+	///          which are read far more often than changed, like subscribers.
+	///          S is the snapshot, a copyable container of T with size() and
+	///          empty(), std::vector<T> by default.
+	template<class T, class S = std::vector<T>>
+	class SnapshotList
+	{
+	public:
+		typedef S Snapshot;
+
+		/// @brief snapshot of a list, valid and unchanged while the view lives
+		class ReadView
+		{
+			EpochGuard m_guard;
+			const Snapshot * m_snapshotPtr; // nullptr for an empty list
+		public:
+			explicit ReadView(const SnapshotList & list) : m_snapshotPtr(list.m_aSnapshot.load()) {}
+			ReadView(const ReadView&) = delete;
+			ReadView& operator = (const ReadView&) = delete;
+			size_t size() const
+			{
+				return m_snapshotPtr ? m_snapshotPtr->size() : 0;
+			}
+			bool empty() const
+			{
+				return size() == 0;
+			}
+			/// nullptr for an empty list
+			const Snapshot * get() const
+			{
+				return m_snapshotPtr;
+			}
+			const T & operator [] (size_t i) const
+			{
+				return (*m_snapshotPtr)[i];
+			}
+			const T * begin() const
+			{
+				return m_snapshotPtr ? m_snapshotPtr->data() : nullptr;
+			}
+			const T * end() const
+			{
+				return m_snapshotPtr ? m_snapshotPtr->data() + m_snapshotPtr->size() : nullptr;
+			}
+		};
+
+		SnapshotList() : m_aSnapshot(nullptr) {}
+		~SnapshotList()
+		{
+			// no reader is left once the owner goes away
+			delete m_aSnapshot.load();
+		}
+		SnapshotList& operator = (SnapshotList&) = delete;
+
+		/// @brief change a copy of the current snapshot and publish it
+		/// @param change bool(Snapshot &), returning false keeps the current snapshot
+		/// @return result of change
+		template<class F>
+		bool update(F change)
+		{
+			std::lock_guard<std::mutex> lk(m_writeMtx);
+			const Snapshot * currentPtr = m_aSnapshot.load(std::memory_order_relaxed);
+			Snapshot snapshot = currentPtr ? *currentPtr : Snapshot();
+			if (!change(snapshot))
+			{
+				return false;
+			}
+			const Snapshot * replacedPtr = m_aSnapshot.exchange(
+				snapshot.empty() ? nullptr : new Snapshot(std::move(snapshot)));
+			if (replacedPtr)
+			{
+				EpochDomain::instance().retire(replacedPtr);
+			}
+			return true;
+		}
+		void push_back(T value)
+		{
+			update([&value](Snapshot & snapshot) {
+				snapshot.push_back(std::move(value));
+				return true; });
+		}
+		size_t size() const
+		{
+			ReadView view(*this);
+			return view.size();
+		}
+		bool empty() const
+		{
+			return m_aSnapshot.load() == nullptr;
+		}
+	private:
+		std::atomic<const Snapshot *> m_aSnapshot; // nullptr while empty
+		std::mutex m_writeMtx; // serializes writers, readers never take it
+	};
+}//namespace
+
+#endif
@@ -11,6 +11,13 @@
 #include <stdexcept>
 #include <condition_variable>
 #include <tuple>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 
 #include <gtest/gtest.h>
 
@@ -71,6 +78,27 @@ namespace testBus
 		std::this_thread::sleep_for(std::chrono::seconds(2));
 	}
 
+	// invokeAsync of the high level api waits for the outcome of a call
+	TEST(EventBus, UseCase1HighLevelApiAsync)
+	{
+		// no bus before the first add()
+		std::shared_ptr<eventHandling::EventBus> previousBusPtr = std::move(g_eventBusPtr);
+		eventHandling::InvokeFuture future = invokeAsync(iFunctionName1, sArg);
+		ASSERT_EQ(future.ready(), true);
+		ASSERT_EQ(future.getResult(), eventHandling::InvokeResult::noSuchTopic);
+		ASSERT_EQ(future.getCount(), -1);
+		std::atomic<int> calls(0);
+		std::function<void(std::string)> count = [&calls](std::string) { ++calls; };
+		ASSERT_EQ(add("asyncApi", count), true);
+		future = invokeAsync("asyncApi", sArg);
+		ASSERT_EQ(future.getResult(), eventHandling::InvokeResult::completed);
+		ASSERT_EQ(future.getCount(), 1);
+		ASSERT_EQ(calls.load(), 1);
+		ASSERT_EQ(invokeAsync("asyncMissing").getResult(), eventHandling::InvokeResult::noSuchTopic);
+		// stops the bus of this test
+		g_eventBusPtr = std::move(previousBusPtr);
+	}
+
 	/*
 	However
 	add("email", executeMe)
@@ -140,6 +168,1112 @@ namespace testBus
 		ASSERT_EQ(invoke(iFunctionName1, sArg), true);
 		stopBus(eventBus);
 	}
+
+	// slow callback id must not stall the other ids
+	TEST(EventBus, WorkerPoolSlowTopic)
+	{
+		const int workerCount = 4, fastCalls = 10;
+		eventHandling::EventBus eventBus(100, workerCount);
+		ASSERT_EQ(eventBus.getWorkerCount(), workerCount);
+		std::hash<std::string> hasher;
+		std::string slowName("slow"), fastName("fast");
+		while (hasher(fastName) % workerCount == hasher(slowName) % workerCount)
+		{
+			fastName += "_";
+		}
+		std::atomic<int> fastCount(0);
+		std::function<void(std::string)> slow = [](std::string) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(500)); };
+		std::function<void(std::string)> fast = [&fastCount](std::string) { ++fastCount; };
+		ASSERT_EQ(eventBus.add(slowName, slow), 1);
+		ASSERT_EQ(eventBus.add(fastName, fast), 1);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invokeEvent(slowName, sArg), true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		for (int i = 0; i < fastCalls; ++i)
+		{
+			ASSERT_EQ(eventBus.invokeEvent(fastName, sArg), true);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		ASSERT_EQ(fastCount.load(), fastCalls);
+		ASSERT_EQ(eventBus.setWorkerCount(2), false);
+		eventBus.stop();
+		busThread.join();
+	}
+
+	// calls for one id keep their order with several workers
+	TEST(EventBus, WorkerPoolOrder)
+	{
+		const int calls = 50;
+		eventHandling::EventBus eventBus(100, 3);
+		std::mutex receivedMtx;
+		std::vector<std::string> received;
+		std::function<void(std::string)> record = [&](std::string s) {
+			std::lock_guard<std::mutex> lk(receivedMtx);
+			received.push_back(s); };
+		ASSERT_EQ(eventBus.add(iFunctionName1, record), 1);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (int i = 0; i < calls; ++i)
+		{
+			ASSERT_EQ(eventBus.invokeEvent(iFunctionName1, std::to_string(i)), true);
+		}
+		for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		std::lock_guard<std::mutex> lk(receivedMtx);
+		ASSERT_EQ(received.size(), static_cast<size_t>(calls));
+		for (int i = 0; i < calls; ++i)
+		{
+			ASSERT_EQ(received[i], std::to_string(i));
+		}
+	}
+	// calls of an unordered id stuck behind a slow call are stolen by the idle worker
+	TEST(EventBus, WorkStealingUnordered)
+	{
+		const int workerCount = 2, hotCalls = 10;
+		eventHandling::EventBus eventBus(100, workerCount);
+		std::hash<std::string> hasher;
+		std::string slowName("slow"), hotName("hot");
+		while (hasher(hotName) % workerCount != hasher(slowName) % workerCount)
+		{
+			hotName += "_";
+		}
+		std::atomic<int> hotCount(0);
+		std::function<void(std::string)> slow = [](std::string) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(500)); };
+		std::function<void(std::string)> hot = [&hotCount](std::string) { ++hotCount; };
+		ASSERT_EQ(eventBus.add(slowName, slow), 1);
+		ASSERT_EQ(eventBus.add(hotName, hot), 1);
+		ASSERT_EQ(eventBus.setOrdered(hotName, false), true);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invokeEvent(slowName, sArg), true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		for (int i = 0; i < hotCalls; ++i)
+		{
+			ASSERT_EQ(eventBus.invokeEvent(hotName, sArg), true);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		ASSERT_EQ(hotCount.load(), hotCalls);
+		long long steals = 0;
+		for (auto & stats : eventBus.getWorkerStats())
+		{
+			steals += stats.m_stealCount;
+		}
+		ASSERT_GT(steals, 0);
+		eventBus.stop();
+		busThread.join();
+	}
+
+	// batches of ordered ids move between workers but stay in order
+	TEST(EventBus, WorkStealingOrdered)
+	{
+		const int topicCount = 4, calls = 100;
+		eventHandling::EventBus eventBus(topicCount * calls, 3);
+		std::mutex receivedMtx;
+		std::vector<std::vector<int>> received(topicCount);
+		for (int t = 0; t < topicCount; ++t)
+		{
+			std::function<void(std::string)> record = [&, t](std::string s) {
+				std::lock_guard<std::mutex> lk(receivedMtx);
+				received[t].push_back(std::stoi(s)); };
+			ASSERT_EQ(eventBus.add("ordered" + std::to_string(t), record), 1);
+		}
+		eventBus.m_maxBatchSize = 4;
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (int i = 0; i < calls; ++i)
+		{
+			for (int t = 0; t < topicCount; ++t)
+			{
+				ASSERT_EQ(eventBus.invokeEvent("ordered" + std::to_string(t),
+					std::to_string(i)), true);
+			}
+		}
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		std::lock_guard<std::mutex> lk(receivedMtx);
+		for (int t = 0; t < topicCount; ++t)
+		{
+			ASSERT_EQ(received[t].size(), static_cast<size_t>(calls));
+			for (int i = 0; i < calls; ++i)
+			{
+				ASSERT_EQ(received[t][i], i);
+			}
+		}
+	}
+
+	struct Point
+	{
+		int m_x, m_y;
+	};
+
+	// arguments keep their type from invoke to the callback
+	TEST(EventBus, TypedInvoke)
+	{
+		eventHandling::EventBus eventBus;
+		std::atomic<int> intSum(0), voidCount(0), pointSum(0), pairSum(0);
+		std::function<void(int)> onInt = [&intSum](int i) { intSum += i; };
+		std::function<void()> onVoid = [&voidCount]() { ++voidCount; };
+		std::function<void(const Point&)> onPoint = [&pointSum](const Point & p) {
+			pointSum += p.m_x * p.m_y; };
+		std::function<void(std::string, int)> onPair = [&pairSum](std::string s, int i) {
+			pairSum += static_cast<int>(s.size()) * i; };
+		ASSERT_EQ(eventBus.add("int", onInt), 1);
+		ASSERT_EQ(eventBus.add("void", onVoid), 1);
+		ASSERT_EQ(eventBus.add("point", onPoint), 1);
+		ASSERT_EQ(eventBus.add("pair", onPair), 1);
+		// all callbacks of one id take the same arguments
+		ASSERT_EQ(eventBus.add("int", onVoid), -1);
+
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invoke("int", 2), true);
+		ASSERT_EQ(eventBus.invoke("void"), true);
+		ASSERT_EQ(eventBus.invokeEvent("void"), true);
+		ASSERT_EQ(eventBus.invoke("point", Point{ 3, 4 }), true);
+		ASSERT_EQ(eventBus.invoke<std::string>("pair", "abc", 2), true);
+		ASSERT_EQ(eventBus.invoke("int", std::string("no")), false);
+		ASSERT_EQ(eventBus.invoke("void", 1), false);
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(intSum, 2);
+		ASSERT_EQ(voidCount, 2);
+		ASSERT_EQ(pointSum, 12);
+		ASSERT_EQ(pairSum, 6);
+	}
+	// interned handles and names reach the same handler
+	TEST(EventBus, TopicInvoke)
+	{
+		eventHandling::EventBus eventBus;
+		std::atomic<int> sum(0);
+		std::function<void(int)> onInt = [&sum](int i) { sum += i; };
+		ASSERT_EQ(eventBus.findTopic("count").isValid(), false);
+		eventHandling::TopicId countTopic = eventBus.topic("count");
+		ASSERT_EQ(countTopic.isValid(), true);
+		ASSERT_EQ(eventBus.topic("count") == countTopic, true);
+		ASSERT_EQ(eventBus.add(countTopic, onInt), 1);
+		ASSERT_EQ(eventBus.add("count", onInt), 1);
+		ASSERT_EQ(eventBus.findTopic("count") == countTopic, true);
+		ASSERT_EQ(eventBus.getCallbacksCount(), 1);
+
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invoke(countTopic, 1), true);
+		ASSERT_EQ(eventBus.invoke("count", 2), true);
+		ASSERT_EQ(eventBus.invoke(eventHandling::TopicId(), 1), false);
+		ASSERT_EQ(eventBus.invoke(eventHandling::TopicId(42), 1), false);
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		// two callbacks for each of the two calls
+		ASSERT_EQ(sum, 6);
+	}
+	struct LargePayload
+	{
+		char m_data[128];
+	};
+
+	// no allocations per invoke once the call pool is warm
+	TEST(EventBus, PooledCalls)
+	{
+		const int calls = 100;
+		eventHandling::EventBus eventBus(calls, 2);
+		std::atomic<int> sum(0);
+		std::function<void(int)> onInt = [&sum](int i) { sum += i; };
+		std::function<void(const LargePayload&)> onLarge = [&sum](
+			const LargePayload & p) { sum += p.m_data[0]; };
+		eventHandling::TopicId intTopic = eventBus.topic("int");
+		ASSERT_EQ(eventBus.add(intTopic, onInt), 1);
+		ASSERT_EQ(eventBus.add("large", onLarge), 1);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		auto invokeAll = [&]() {
+			for (int i = 0; i < calls; ++i)
+			{
+				while (!eventBus.invoke(intTopic, 1))
+				{
+					std::this_thread::yield();
+				}
+			}
+			for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		};
+		invokeAll();
+		eventHandling::AllocationStats warm = eventBus.getAllocationStats();
+		invokeAll();
+		eventHandling::AllocationStats steady = eventBus.getAllocationStats();
+		ASSERT_EQ(steady.m_eventCallAllocations, warm.m_eventCallAllocations);
+		ASSERT_EQ(steady.m_eventCallReuses - warm.m_eventCallReuses, calls);
+		ASSERT_EQ(steady.m_argumentAllocations, 0);
+		ASSERT_EQ(warm.m_eventCallAllocations <= calls, true);
+		// a tuple larger than the in place storage is counted
+		LargePayload large = {};
+		ASSERT_EQ(eventBus.invoke("large", large), true);
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(eventBus.getAllocationStats().m_argumentAllocations, 1);
+		ASSERT_EQ(sum >= 2 * calls, true);
+	}
+	// one payload buffer for all subscribers and topics
+	TEST(EventBus, SharedPayload)
+	{
+		eventHandling::EventBus eventBus;
+		std::mutex seenMtx;
+		std::vector<const char *> seen;
+		std::function<void(const std::string&)> record = [&](const std::string & payload) {
+			std::lock_guard<std::mutex> lk(seenMtx);
+			seen.push_back(payload.data()); };
+		eventHandling::TopicId mailTopic = eventBus.topic("mail");
+		for (int i = 0; i < 3; ++i)
+		{
+			ASSERT_EQ(eventBus.addShared(mailTopic, record), 1);
+		}
+		ASSERT_EQ(eventBus.addShared("archive", record), 1);
+		std::atomic<int> received(0);
+		std::function<void(std::unique_ptr<int>)> take = [&received](std::unique_ptr<int> p) {
+			received = *p; };
+		ASSERT_EQ(eventBus.add("owned", take), 1);
+		ASSERT_EQ(eventBus.add("owned", take), -1);
+
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		eventHandling::SharedPayload<std::string> payload =
+			eventHandling::makeSharedPayload(std::string(4096, 'x'));
+		ASSERT_EQ(eventBus.invoke(mailTopic, payload), true);
+		ASSERT_EQ(eventBus.invoke("archive", payload), true);
+		ASSERT_EQ(eventBus.invokeShared(mailTopic, std::string(4096, 'y')), true);
+		ASSERT_EQ(eventBus.invoke("owned", std::unique_ptr<int>(new int(3))), true);
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(received, 3);
+		std::lock_guard<std::mutex> lk(seenMtx);
+		ASSERT_EQ(seen.size(), static_cast<size_t>(7));
+		// every call hands one buffer to all of its subscribers
+		ASSERT_EQ(std::count(seen.begin(), seen.end(), payload->data()), 4);
+		std::vector<const char *> others;
+		std::copy_if(seen.begin(), seen.end(), std::back_inserter(others),
+			[&payload](const char * p) { return p != payload->data(); });
+		ASSERT_EQ(std::count(others.begin(), others.end(), others.front()), 3);
+		ASSERT_EQ(payload.useCount(), 1);
+	}
+	// one push per worker for a whole range or a mixed batch
+	TEST(EventBus, InvokeBatch)
+	{
+		const int calls = 200;
+		eventHandling::EventBus eventBus(2 * calls, 2);
+		std::mutex receivedMtx;
+		std::vector<int> ordered;
+		std::atomic<int> unorderedSum(0), voidCount(0);
+		std::function<void(int)> record = [&](int i) {
+			std::lock_guard<std::mutex> lk(receivedMtx);
+			ordered.push_back(i); };
+		std::function<void(int)> sum = [&unorderedSum](int i) { unorderedSum += i; };
+		std::function<void()> count = [&voidCount]() { ++voidCount; };
+		eventHandling::TopicId orderedTopic = eventBus.topic("ordered");
+		ASSERT_EQ(eventBus.add(orderedTopic, record), 1);
+		ASSERT_EQ(eventBus.add("unordered", sum), 1);
+		ASSERT_EQ(eventBus.add("void", count), 1);
+		ASSERT_EQ(eventBus.setOrdered("unordered", false), true);
+		eventBus.m_maxBatchSize = 16;
+
+		std::vector<int> arguments(calls);
+		for (int i = 0; i < calls; ++i)
+		{
+			arguments[i] = i;
+		}
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invokeBatch(orderedTopic, arguments), calls);
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		ASSERT_EQ(eventBus.invokeBatch("unordered", std::move(arguments)), calls);
+		eventHandling::EventBatch batch(eventBus);
+		ASSERT_EQ(batch.add("void"), true);
+		ASSERT_EQ(batch.add("unordered", 1000), true);
+		ASSERT_EQ(batch.add(orderedTopic, calls), true);
+		ASSERT_EQ(batch.add("void", 1), false);
+		ASSERT_EQ(batch.size(), 3);
+		ASSERT_EQ(eventBus.invokeBatch(batch), 3);
+		ASSERT_EQ(batch.empty(), true);
+		for (int i = 0; i < 200 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(voidCount, 1);
+		ASSERT_EQ(unorderedSum, calls * (calls - 1) / 2 + 1000);
+		std::lock_guard<std::mutex> lk(receivedMtx);
+		ASSERT_EQ(ordered.size(), static_cast<size_t>(calls + 1));
+		for (int i = 0; i <= calls; ++i)
+		{
+			ASSERT_EQ(ordered[i], i);
+		}
+
+		// the batch is cut at the capacity
+		eventHandling::EventBus smallBus(10);
+		ASSERT_EQ(smallBus.add("unordered", sum), 1);
+		ASSERT_EQ(smallBus.invokeBatch("unordered", std::vector<int>(20, 1)), 10);
+		ASSERT_EQ(smallBus.getCallsCount(), 10);
+	}
+
+	// every overflow policy tells what happened to the call and counts it
+	TEST(EventBus, OverflowPolicies)
+	{
+		using eventHandling::InvokeResult;
+		using eventHandling::OverflowPolicy;
+		const int capacity = 2;
+		std::vector<int> received;
+		std::function<void(int)> record = [&received](int i) { received.push_back(i); };
+
+		eventHandling::EventBus eventBus(capacity);
+		ASSERT_EQ(eventBus.add("int", record), 1);
+		// interned, nothing added
+		eventBus.topic("none");
+		ASSERT_EQ(eventBus.invokeChecked("missing", 1), InvokeResult::noSuchTopic);
+		ASSERT_EQ(eventBus.invokeChecked("int", sArg), InvokeResult::wrongArguments);
+		ASSERT_EQ(eventBus.invokeChecked("none", 1), InvokeResult::invalid);
+		ASSERT_EQ(eventBus.invoke("none", 1), false);
+		// default drops the newest call
+		ASSERT_EQ(eventBus.getOverflowPolicy(), OverflowPolicy::dropNewest);
+		ASSERT_EQ(eventBus.invoke("int", 1), true);
+		ASSERT_EQ(eventBus.invoke("int", 2), true);
+		ASSERT_EQ(eventBus.invoke("int", 3), false);
+		ASSERT_EQ(eventBus.invokeChecked("int", 3), InvokeResult::dropped);
+		ASSERT_EQ(eventBus.getOverflowStats().m_droppedNewestCount, 2);
+
+		eventBus.setOverflowPolicy(OverflowPolicy::block, std::chrono::milliseconds(20));
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_EQ(eventBus.invokeChecked("int", 3), InvokeResult::timedOut);
+		ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+		ASSERT_EQ(eventBus.getOverflowStats().m_blockedCount, 1);
+		ASSERT_EQ(eventBus.getOverflowStats().m_blockTimeoutCount, 1);
+
+		// the oldest call of the topic makes room, ordered and unordered
+		eventBus.setOverflowPolicy(OverflowPolicy::dropOldest);
+		ASSERT_EQ(eventBus.invokeChecked("int", 3), InvokeResult::queued);
+		ASSERT_EQ(eventBus.setOrdered("int", false), true);
+		ASSERT_EQ(eventBus.invokeChecked("int", 4), InvokeResult::queued);
+		ASSERT_EQ(eventBus.getCallsCount(), capacity);
+		ASSERT_EQ(eventBus.getOverflowStats().m_droppedOldestCount, 2);
+
+		eventBus.setOverflowPolicy(OverflowPolicy::grow);
+		ASSERT_EQ(eventBus.invokeBatch("int", std::vector<int>{ 5, 6 }), 2);
+		ASSERT_EQ(eventBus.getCallsCount(), capacity + 2);
+		ASSERT_EQ(eventBus.getOverflowStats().m_grownCount, 2);
+
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(received, std::vector<int>({ 3, 4, 5, 6 }));
+	}
+
+	// blocked producers continue as soon as the workers make room
+	TEST(EventBus, OverflowBlock)
+	{
+		const int calls = 200;
+		eventHandling::EventBus eventBus(4, 2);
+		std::atomic<int> count(0);
+		std::function<void(int)> slowCount = [&count](int) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			++count; };
+		ASSERT_EQ(eventBus.add("int", slowCount), 1);
+		eventBus.setOverflowPolicy(eventHandling::OverflowPolicy::block, std::chrono::seconds(5));
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		for (int i = 0; i < calls; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("int", i), true);
+			ASSERT_LE(eventBus.getCallsCount(), 4);
+		}
+		for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(count.load(), calls);
+		ASSERT_GT(eventBus.getOverflowStats().m_blockedCount, 0);
+		ASSERT_EQ(eventBus.getOverflowStats().m_blockTimeoutCount, 0);
+	}
+
+	// high lane first, weighted lanes take turns, aged tasks are served in FIFO order
+	TEST(EventBus, PriorityLanes)
+	{
+		using eventHandling::Priority;
+		using eventHandling::LaneScheduling;
+		auto runAll = [](LaneScheduling scheduling, std::chrono::milliseconds aging) {
+			eventHandling::EventBus eventBus(100);
+			std::string order;
+			std::function<void(char)> record = [&order](char c) { order += c; };
+			EXPECT_EQ(eventBus.add("telemetry", record), 1);
+			EXPECT_EQ(eventBus.add("alarm", record), 1);
+			EXPECT_EQ(eventBus.setOrdered("telemetry", false), true);
+			EXPECT_EQ(eventBus.setOrdered("alarm", false), true);
+			EXPECT_EQ(eventBus.setPriority("telemetry", Priority::low), true);
+			EXPECT_EQ(eventBus.setPriority("alarm", Priority::high), true);
+			eventBus.setLaneScheduling(scheduling, aging);
+			EXPECT_EQ(eventBus.setLaneWeight(Priority::high, 2), true);
+			for (int i = 0; i < 4; ++i)
+			{
+				EXPECT_EQ(eventBus.invoke("telemetry", 'l'), true);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			for (int i = 0; i < 4; ++i)
+			{
+				EXPECT_EQ(eventBus.invoke("alarm", 'h'), true);
+			}
+			// single call of the low topic in the normal lane
+			EXPECT_EQ(eventBus.invokeWithPriority("telemetry", Priority::normal, 'n'),
+				eventHandling::InvokeResult::queued);
+			std::vector<eventHandling::LaneStats> lanes = eventBus.getLaneStats();
+			EXPECT_EQ(lanes[0].m_queuedCalls, 4);
+			EXPECT_EQ(lanes[1].m_queuedCalls, 1);
+			EXPECT_EQ(lanes[2].m_queuedCalls, 4);
+			std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+			for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			eventBus.stop();
+			busThread.join();
+			lanes = eventBus.getLaneStats();
+			EXPECT_EQ(lanes[2].m_queuedCalls, 0);
+			EXPECT_EQ(lanes[2].m_dispatchedCount, 4);
+			EXPECT_GE(lanes[2].m_maxWaitNanoseconds, lanes[0].m_maxWaitNanoseconds);
+			return order;
+		};
+		ASSERT_EQ(runAll(LaneScheduling::strict, std::chrono::seconds(10)), "hhhhnllll");
+		// credits 2:4:1, the normal lane is served once before the first refill
+		ASSERT_EQ(runAll(LaneScheduling::weighted, std::chrono::seconds(10)), "hhnlhhlll");
+		ASSERT_EQ(runAll(LaneScheduling::strict, std::chrono::milliseconds(0)), "llllhhhhn");
+	}
+
+	TEST(EventBus, Timers)
+	{
+		eventHandling::EventBus eventBus(100);
+		std::atomic<int> onceCount(0), everyCount(0), cancelledCount(0);
+		std::function<void(int)> once = [&onceCount](int i) { onceCount += i; };
+		std::function<void(int)> every = [&everyCount](int i) { everyCount += i; };
+		std::function<void(int)> cancelled = [&cancelledCount](int i) { cancelledCount += i; };
+		ASSERT_EQ(eventBus.add("once", once), 1);
+		ASSERT_EQ(eventBus.add("every", every), 1);
+		ASSERT_EQ(eventBus.add("cancelled", cancelled), 1);
+		ASSERT_EQ(eventBus.invokeAfter("missing", std::chrono::milliseconds(1), 1).isValid(), false);
+		ASSERT_EQ(eventBus.invokeAfter("once", std::chrono::milliseconds(1),
+			std::string("wrong")).isValid(), false);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		auto start = std::chrono::steady_clock::now();
+		eventHandling::TimerId onceId = eventBus.invokeAfter("once", std::chrono::milliseconds(30), 1);
+		eventHandling::TimerId everyId = eventBus.invokeEvery("every", std::chrono::milliseconds(10), 1);
+		eventHandling::TimerId cancelledId = eventBus.invokeAt("cancelled",
+			start + std::chrono::milliseconds(20), 1);
+		ASSERT_EQ(onceId.isValid() && everyId.isValid() && cancelledId.isValid(), true);
+		ASSERT_EQ(eventBus.getTimerCount(), 3);
+		ASSERT_EQ(eventBus.cancelTimer(cancelledId), true);
+		ASSERT_EQ(eventBus.cancelTimer(cancelledId), false);
+		while (onceCount == 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		// never early
+		ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+		ASSERT_EQ(onceCount.load(), 1);
+		ASSERT_EQ(eventBus.cancelTimer(onceId), false);
+		while (everyCount < 3 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		ASSERT_GE(everyCount.load(), 3);
+		ASSERT_EQ(eventBus.getTimerCount(), 1);
+		ASSERT_EQ(eventBus.cancelTimer(everyId), true);
+		ASSERT_EQ(eventBus.getTimerCount(), 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		int stoppedCount = everyCount;
+		std::this_thread::sleep_for(std::chrono::milliseconds(40));
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(everyCount.load(), stoppedCount);
+		ASSERT_EQ(cancelledCount.load(), 0);
+	}
+
+	// lambdas and function pointers are added without a std::function
+	TEST(EventBus, AddCallable)
+	{
+		eventHandling::EventBus eventBus(100);
+		std::atomic<int> sum(0);
+		ASSERT_EQ(eventBus.add("sum", [&sum](int i) { sum += i; }), 1);
+		ASSERT_EQ(eventBus.add("sum", [&sum](const int & i) mutable { sum += 10 * i; }), 1);
+		ASSERT_EQ(eventBus.add("sum", static_cast<void(*)(int)>(nullptr)), 1);
+		ASSERT_EQ(eventBus.add("sum", [](std::string) {}), -1);
+		ASSERT_EQ(eventBus.add("void", static_cast<void(*)()>([]() {})), 1);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		ASSERT_EQ(eventBus.invoke("sum", 2), true);
+		ASSERT_EQ(eventBus.invoke("void"), true);
+		for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(sum.load(), 22);
+	}
+
+	// synchronous ids and invokeSync run the callbacks on the calling thread
+	TEST(EventBus, Synchronous)
+	{
+		eventHandling::EventBus eventBus(100);
+		std::thread::id caller = std::this_thread::get_id(), ranOn;
+		int sum = 0;
+		ASSERT_EQ(eventBus.add("sync", [&sum, &ranOn](int i) {
+			ranOn = std::this_thread::get_id();
+			sum += i; }), 1);
+		ASSERT_EQ(eventBus.add("sync", [](int) { throw std::runtime_error("sync"); }), 1);
+		ASSERT_EQ(eventBus.setSynchronous("sync"), true);
+		ASSERT_EQ(eventBus.setSynchronous("missing"), false);
+		// no running bus needed
+		ASSERT_EQ(eventBus.invoke("sync", 2), true);
+		ASSERT_EQ(sum, 2);
+		ASSERT_EQ(ranOn == caller, true);
+		// the exception goes to the caller's future, not to the process wide g_excPtr
+		ASSERT_EQ(eventBus.invokeAsync("sync", 0).getException() != nullptr, true);
+		ASSERT_EQ(eventBus.invokeChecked("sync", 3), eventHandling::InvokeResult::dispatched);
+		ASSERT_EQ(eventBus.getCallsCount(), 0);
+		// per call on a queued id, the exception only fails its own callback
+		ASSERT_EQ(eventBus.setSynchronous("sync", false), true);
+		ASSERT_EQ(eventBus.invokeSync("sync", 4), 1);
+		ASSERT_EQ(sum, 9);
+		ASSERT_EQ(eventBus.invokeSync("sync", std::string("wrong")), -1);
+		ASSERT_EQ(eventBus.invokeSync("missing", 1), -1);
+		ASSERT_EQ(eventBus.blockEvent("sync"), true);
+		ASSERT_EQ(eventBus.invokeSync("sync", 5), 0);
+		ASSERT_EQ(sum, 9);
+		ASSERT_EQ(eventBus.blockEvent("sync", false), true);
+		ASSERT_EQ(eventBus.invoke("sync", 1), true);
+		ASSERT_EQ(eventBus.getCallsCount(), 1);
+		ASSERT_EQ(sum, 9);
+	}
+
+	TEST(EventBus, InvokeAsync)
+	{
+		eventHandling::InvokeFuture dropped;
+		{
+			eventHandling::EventBus eventBus(100);
+			std::atomic<int> sum(0);
+			ASSERT_EQ(eventBus.add("async", [&sum](int i) { sum += i; }), 1);
+			ASSERT_EQ(eventBus.add("async", [](int i) {
+				if (i < 0) throw std::runtime_error("async"); }), 1);
+			eventHandling::InvokeFuture future = eventBus.invokeAsync("async", 2);
+			ASSERT_EQ(future.ready(), false);
+			ASSERT_EQ(future.waitFor(std::chrono::milliseconds(1)), false);
+			eventHandling::InvokeFuture failing = eventBus.invokeAsync("async", -1);
+			std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+			ASSERT_EQ(future.getCount(), 2);
+			ASSERT_EQ(future.getResult(), eventHandling::InvokeResult::completed);
+			ASSERT_EQ(eventHandling::isAccepted(future.getResult()), true);
+			ASSERT_EQ(future.getException() == nullptr, true);
+			ASSERT_EQ(failing.getCount(), 1);
+			ASSERT_EQ(failing.getException() != nullptr, true);
+			ASSERT_EQ(sum.load(), 1);
+			// the shared states are reused, the worker may still hold the previous one
+			long long allocations = eventHandling::CompletionPool::instance().getAllocationCount();
+			for (int i = 0; i < 100; ++i)
+			{
+				ASSERT_EQ(eventBus.invokeAsync("async", 1).getCount(), 2);
+			}
+			ASSERT_LE(eventHandling::CompletionPool::instance().getAllocationCount(), allocations + 2);
+			// rejected and synchronous calls are ready at once
+			eventHandling::InvokeFuture wrong = eventBus.invokeAsync("async", std::string("wrong"));
+			ASSERT_EQ(wrong.ready(), true);
+			ASSERT_EQ(wrong.getResult(), eventHandling::InvokeResult::wrongArguments);
+			ASSERT_EQ(wrong.getCount(), -1);
+			ASSERT_EQ(eventBus.setSynchronous("async"), true);
+			eventHandling::InvokeFuture sync = eventBus.invokeAsync("async", -3);
+			ASSERT_EQ(sync.ready(), true);
+			ASSERT_EQ(sync.getResult(), eventHandling::InvokeResult::dispatched);
+			ASSERT_EQ(sync.getCount(), 1);
+			ASSERT_EQ(sync.getException() != nullptr, true);
+			ASSERT_EQ(eventBus.setSynchronous("async", false), true);
+			eventBus.stop();
+			busThread.join();
+			// never dispatched, completes when the bus drops it
+			dropped = eventBus.invokeAsync("async", 1);
+			ASSERT_EQ(dropped.ready(), false);
+		}
+		ASSERT_EQ(dropped.ready(), true);
+		ASSERT_EQ(dropped.getResult(), eventHandling::InvokeResult::dropped);
+		ASSERT_EQ(dropped.getCount(), -1);
+	}
+
+	TEST(EventBus, LatencyStats)
+	{
+		eventHandling::EventBus eventBus(100);
+		std::atomic<int> calls(0);
+		ASSERT_EQ(eventBus.add("slow", [&calls](int i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(i));
+			++calls; }), 1);
+		ASSERT_EQ(eventBus.add("slow", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.add("untimed", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.setLatencySampling("slow", 1), true);
+		ASSERT_EQ(eventBus.setLatencySampling("untimed", 0), true);
+		ASSERT_EQ(eventBus.setLatencySampling("missing", 1), false);
+		ASSERT_EQ(eventBus.getLatencyStats().size(), 0u);
+		for (int i = 0; i < 4; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("slow", 2), true);
+		}
+		ASSERT_EQ(eventBus.invoke("untimed", 0), true);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		eventBus.invokeAsync("untimed", 0).wait();
+		eventBus.stop();
+		busThread.join();
+		ASSERT_EQ(calls.load(), 10);
+		eventHandling::TopicLatencyStats stats = eventBus.getLatencyStats("slow");
+		ASSERT_EQ(stats.m_callbackId, std::string("slow"));
+		ASSERT_EQ(stats.m_wait.m_count, 4);
+		ASSERT_EQ(stats.m_callback.m_count, 8);
+		// half of the callbacks sleep
+		ASSERT_GE(stats.m_callback.m_max, 2000000);
+		ASSERT_GE(stats.m_callback.m_p99, 2000000);
+		ASSERT_LE(stats.m_callback.m_p99, stats.m_callback.m_max);
+		// the last call waited for the sleeping callbacks of the others
+		ASSERT_GE(stats.m_wait.m_max, 6000000);
+		stats = eventBus.getLatencyStats("untimed");
+		ASSERT_EQ(stats.m_wait.m_count, 2);
+		ASSERT_EQ(stats.m_callback.m_count, 0);
+		ASSERT_EQ(eventBus.getLatencyStats("missing").m_wait.m_count, 0);
+		ASSERT_EQ(eventBus.getLatencyStats().size(), 2u);
+		eventBus.resetLatencyStats();
+		ASSERT_EQ(eventBus.getLatencyStats().size(), 0u);
+	}
+
+	TEST(EventBus, Trace)
+	{
+		const std::string path("eventBusTrace.json");
+		eventHandling::EventBus eventBus(100);
+		std::atomic<int> calls(0);
+		ASSERT_EQ(eventBus.add("traced \"id\"", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.add("traced \"id\"", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.add("blockedTrace", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.invoke("traced \"id\"", 0), true);// not traced
+		eventBus.clearTrace();
+		eventBus.setTracing(true);
+		ASSERT_EQ(eventBus.isTracing(), true);
+		for (int i = 0; i < 3; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("traced \"id\"", i), true);
+		}
+		ASSERT_EQ(eventBus.blockEvent("blockedTrace"), true);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		eventBus.invokeAsync("traced \"id\"", 3).wait();
+		eventBus.invokeAsync("blockedTrace", 0).wait();
+		eventBus.stop();
+		busThread.join();
+		eventBus.setTracing(false);
+		ASSERT_EQ(calls.load(), 10);
+		ASSERT_EQ(eventBus.dumpTrace(path), true);
+		std::ifstream file(path.c_str());
+		std::stringstream text;
+		text << file.rdbuf();
+		file.close();
+		std::remove(path.c_str());
+		const std::string trace = text.str();
+		auto count = [&trace](const std::string & pattern) {
+			size_t n = 0;
+			for (size_t pos = trace.find(pattern); pos != std::string::npos;
+				pos = trace.find(pattern, pos + 1))
+			{
+				++n;
+			}
+			return n;
+		};
+		ASSERT_EQ(trace.compare(0, 30, "{\"displayTimeUnit\":\"ns\",\"trace"), 0);
+		ASSERT_EQ(count("\"name\":\"traced \\\"id\\\"\",\"cat\":\"enqueue\""), 4u);
+		// the call from before setTracing() is dispatched traced, without an arrow
+		ASSERT_EQ(count("\"name\":\"traced \\\"id\\\"\",\"cat\":\"dispatch\""), 5u);
+		ASSERT_EQ(count("\"name\":\"traced \\\"id\\\"\",\"cat\":\"callback\""), 10u);
+		ASSERT_EQ(count("\"name\":\"blockedTrace\",\"cat\":\"blocked\""), 1u);
+		// every call traced at enqueue has one arrow to its dispatch
+		ASSERT_EQ(count("\"ph\":\"s\""), 5u);
+		ASSERT_EQ(count("\"ph\":\"f\""), 5u);
+		ASSERT_EQ(eventBus.dumpTrace("missingDirectory/trace.json"), false);
+		eventBus.clearTrace();
+	}
+
+	TEST(EventBus, WaitStrategy)
+	{
+		eventHandling::EventBus eventBus(100, 2);
+		std::atomic<int> calls(0);
+		ASSERT_EQ(eventBus.add("wait", [&calls](int i) { calls += i; }), 1);
+		ASSERT_EQ(eventBus.getWaitStrategy(), eventHandling::WaitStrategy::spinPark);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		const eventHandling::WaitStrategy strategies[] = { eventHandling::WaitStrategy::busySpin,
+			eventHandling::WaitStrategy::spinYield, eventHandling::WaitStrategy::blocking,
+			eventHandling::WaitStrategy::spinPark };
+		int expected = 0;
+		for (eventHandling::WaitStrategy strategy : strategies)
+		{
+			// changed while the workers wait
+			eventBus.setWaitStrategy(strategy, 32);
+			ASSERT_EQ(eventBus.getWaitStrategy(), strategy);
+			for (int i = 0; i < 20; ++i)
+			{
+				ASSERT_EQ(eventBus.invoke("wait", 1), true);
+				++expected;
+				if (i % 5 == 0)
+				{
+					// idle long enough to park
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				}
+			}
+			// ordered, the calls before have run when this one completes
+			ASSERT_EQ(eventBus.invokeAsync("wait", 1).getResult(), eventHandling::InvokeResult::completed);
+			++expected;
+			ASSERT_EQ(calls.load(), expected);
+		}
+		eventBus.stop();
+		busThread.join();
+	}
+
+	TEST(EventBus, Shutdown)
+	{
+		eventHandling::EventBus eventBus(100, 2);
+		std::atomic<int> calls(0);
+		ASSERT_EQ(eventBus.add("shutdown", [&calls](int i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(i));
+			++calls; }), 1);
+		for (int i = 0; i < 20; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("shutdown", 1), true);
+		}
+		// not running, started for the drain
+		eventHandling::ShutdownResult result = eventBus.shutdown(std::chrono::milliseconds(0),
+			eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(result.m_dispatchedCount, 20);
+		ASSERT_EQ(result.m_pendingCount, 0);
+		ASSERT_EQ(calls.load(), 20);
+		ASSERT_EQ(eventBus.getRunState(), 2);
+
+		eventBus.reset();
+		calls = 0;
+		for (int i = 0; i < 50; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("shutdown", 5), true);
+		}
+		ASSERT_EQ(eventBus.start(), true);
+		ASSERT_EQ(eventBus.start(), false);
+		result = eventBus.shutdown(std::chrono::milliseconds(30));
+		ASSERT_EQ(result.m_drained, false);
+		ASSERT_GT(result.m_pendingCount, 0);
+		ASSERT_EQ(result.m_dispatchedCount + result.m_pendingCount, 50);
+		ASSERT_EQ(calls.load(), result.m_dispatchedCount);
+		ASSERT_LT(result.m_duration, std::chrono::milliseconds(1000));
+		// the leftovers stay queued
+		ASSERT_EQ(eventBus.getCallsCount(), result.m_pendingCount);
+		eventBus.reset();
+		ASSERT_EQ(eventBus.start(), true);
+		result = eventBus.shutdown(std::chrono::milliseconds(0), eventHandling::ShutdownMode::abort);
+		ASSERT_EQ(calls.load() + result.m_pendingCount, 50);
+		ASSERT_EQ(eventBus.getCallsCount(), result.m_pendingCount);
+		eventBus.reset();
+		result = eventBus.shutdown(std::chrono::milliseconds(0), eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(calls.load(), 50);
+
+		// a running bus is stopped by its destructor, the started thread is joined
+		eventHandling::EventBus runningBus;
+		ASSERT_EQ(runningBus.add("shutdown", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(startBus(runningBus), true);
+		ASSERT_EQ(runningBus.invoke("shutdown", 0), true);
+		ASSERT_EQ(drainBus(runningBus), 0);
+		ASSERT_EQ(calls.load(), 51);
+
+		// after stop() the finished run thread is joined by start() and shutdown()
+		eventBus.reset();
+		ASSERT_EQ(eventBus.start(), true);
+		eventBus.stop();
+		// run() returns, its thread stays joinable
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		calls = 0;
+		for (int i = 0; i < 10; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("shutdown", 0), true);
+		}
+		result = eventBus.shutdown(std::chrono::milliseconds(0), eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(calls.load(), 10);
+		eventBus.reset();
+		ASSERT_EQ(eventBus.start(), true);
+		eventBus.stop();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		ASSERT_EQ(reStartBus(eventBus), true);
+		ASSERT_EQ(eventBus.invoke("shutdown", 0), true);
+		result = eventBus.shutdown(std::chrono::milliseconds(1000), eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(calls.load(), 11);
+	}
+
+	TEST(EventBus, Durable)
+	{
+		const std::string directory("testBusJournal");
+		eventHandling::Journal::remove(directory);
+		eventHandling::EventBus eventBus(100, 1);
+		std::atomic<int> calls(0);
+		ASSERT_EQ(eventBus.add("durable", [&calls](std::string) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.add("durableNoArgs", [&calls]() { ++calls; }), 1);
+		ASSERT_EQ(eventBus.add("durableInt", [&calls](int) { ++calls; }), 1);
+		ASSERT_EQ(eventBus.setDurable("durable"), true);
+		ASSERT_EQ(eventBus.setDurable("durableNoArgs"), true);
+		// int arguments can not be journaled
+		ASSERT_EQ(eventBus.setDurable("durableInt"), false);
+		ASSERT_EQ(eventBus.setDurable("unknown"), false);
+		ASSERT_EQ(eventBus.getJournalStats().m_appendedCount, 0);
+		ASSERT_EQ(eventBus.openJournal(directory), true);
+		for (int i = 0; i < 10; ++i)
+		{
+			ASSERT_EQ(eventBus.invoke("durable", std::string("text")), true);
+			ASSERT_EQ(eventBus.invoke("durableNoArgs"), true);
+			ASSERT_EQ(eventBus.invoke("durableInt", i), true);
+		}
+		eventHandling::JournalStats stats = eventBus.getJournalStats();
+		ASSERT_EQ(stats.m_appendedCount, 20);
+		// batches are journaled, timers of durable ids are rejected
+		ASSERT_EQ(eventBus.invokeBatch("durable", std::vector<std::string>(5, "batch")), 5);
+		ASSERT_EQ(eventBus.invokeAfter("durable", std::chrono::milliseconds(1),
+			std::string("timer")).isValid(), false);
+		ASSERT_EQ(eventBus.invokeEvery("durableNoArgs", std::chrono::milliseconds(1)).isValid(), false);
+		stats = eventBus.getJournalStats();
+		ASSERT_EQ(stats.m_appendedCount, 25);
+		ASSERT_EQ(stats.m_completedCount, 0);
+		ASSERT_EQ(stats.m_checkpointSequence, 1u);
+		eventHandling::ShutdownResult result = eventBus.shutdown(std::chrono::milliseconds(1000),
+			eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(calls.load(), 35);
+		stats = eventBus.getJournalStats();
+		ASSERT_EQ(stats.m_completedCount, 25);
+		eventBus.closeJournal();
+		ASSERT_EQ(eventBus.getJournalStats().m_appendedCount, 0);
+
+		// calls still queued stay pending in the journal
+		eventBus.reset();
+		ASSERT_EQ(eventBus.openJournal(directory), true);
+		ASSERT_EQ(eventBus.getJournalStats().m_checkpointSequence, 26u);
+		ASSERT_EQ(eventBus.invoke("durable", std::string("pending")), true);
+		eventBus.closeJournal();
+		ASSERT_EQ(eventBus.openJournal(directory), true);
+		stats = eventBus.getJournalStats();
+		ASSERT_EQ(stats.m_checkpointSequence, 26u);
+		ASSERT_EQ(stats.m_nextSequence, 27u);
+		eventBus.closeJournal();
+		ASSERT_EQ(eventHandling::Journal::remove(directory), true);
+	}
+
+	TEST(EventBus, JournalReplay)
+	{
+		const std::string directory("testReplayJournal");
+		eventHandling::Journal::remove(directory);
+		eventHandling::JournalOptions options;
+		options.m_segmentSize = 4096;
+		{
+			// the calls of a bus which never ran stay pending
+			eventHandling::EventBus eventBus(100, 1);
+			ASSERT_EQ(eventBus.add("replayText", [](std::string) {}), 1);
+			ASSERT_EQ(eventBus.add("replayNoArgs", []() {}), 1);
+			ASSERT_EQ(eventBus.add("replayGone", [](std::string) {}), 1);
+			eventBus.setDurable("replayText");
+			eventBus.setDurable("replayNoArgs");
+			eventBus.setDurable("replayGone");
+			eventBus.setOverflowPolicy(eventHandling::OverflowPolicy::grow);
+			ASSERT_EQ(eventBus.openJournal(directory, options), true);
+			for (int i = 0; i < 100; ++i)
+			{
+				ASSERT_EQ(eventBus.invoke("replayText", "text" + std::to_string(i)), true);
+				if (i % 2 == 0)
+				{
+					ASSERT_EQ(eventBus.invoke("replayNoArgs"), true);
+				}
+			}
+			for (int i = 0; i < 10; ++i)
+			{
+				ASSERT_EQ(eventBus.invoke("replayGone", std::string("gone")), true);
+			}
+			ASSERT_GT(eventBus.getJournalStats().m_segmentCount, 1);
+			eventBus.closeJournal();
+		}
+		{
+			// damage record 4, the rest of the first segment is lost
+			eventHandling::MappedFile file;
+			ASSERT_EQ(file.open(directory + "/journal-0000000000000000.wal", 0, false), true);
+			bool corrupt = false;
+			eventHandling::scanJournalSegment(file.data(), file.size(),
+				[](const eventHandling::JournalRecordView & record) {
+				if (record.m_sequence == 4)
+				{
+					++*const_cast<char *>(record.m_argumentPtr);
+				}}, corrupt);
+			ASSERT_EQ(corrupt, false);
+		}
+		eventHandling::EventBus eventBus(100, 1);
+		std::mutex textsMtx;
+		std::vector<std::string> texts;
+		std::atomic<int> noArgsCalls(0);
+		ASSERT_EQ(eventBus.add("replayText", [&textsMtx, &texts](std::string text) {
+			std::lock_guard<std::mutex> lk(textsMtx);
+			texts.push_back(text); }), 1);
+		ASSERT_EQ(eventBus.add("replayNoArgs", [&noArgsCalls]() { ++noArgsCalls; }), 1);
+		ASSERT_EQ(eventBus.openJournal(directory, options), true);
+		ASSERT_EQ(eventBus.getJournalStats().m_checkpointSequence, 1u);
+		eventHandling::JournalReplayStats stats = eventBus.replayJournal();
+		ASSERT_EQ(stats.m_corruptCount, 1);
+		ASSERT_GT(stats.m_lostCount, 0);
+		ASSERT_EQ(stats.m_skippedCount, 10);
+		ASSERT_EQ(stats.m_replayedCount + stats.m_lostCount, 150);
+		ASSERT_GT(stats.m_bytes, 0);
+		// nothing dispatches, the queue grew
+		ASSERT_EQ(eventBus.getCallsCount(), stats.m_replayedCount);
+		ASSERT_EQ(eventBus.replayJournal().m_replayedCount, 0);
+		eventHandling::ShutdownResult result = eventBus.shutdown(std::chrono::milliseconds(5000),
+			eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		ASSERT_EQ(static_cast<long long>(texts.size()) + noArgsCalls.load(), stats.m_replayedCount);
+		ASSERT_EQ(texts.front(), "text0");
+		ASSERT_EQ(texts.back(), "text99");
+		eventBus.closeJournal();
+
+		// replayed calls completed their records
+		ASSERT_EQ(eventBus.openJournal(directory, options), true);
+		ASSERT_EQ(eventBus.getJournalStats().m_checkpointSequence, 161u);
+		ASSERT_EQ(eventBus.replayJournal().m_replayedCount, 0);
+		eventBus.closeJournal();
+		ASSERT_EQ(eventHandling::Journal::remove(directory), true);
+	}
+
+	TEST(EventBus, ShmTransport)
+	{
+		const std::string name("eventBusTestTransport");
+		eventHandling::EventBus eventBus(100, 1);
+		std::mutex textsMtx;
+		std::vector<std::string> texts;
+		std::atomic<int> noArgsCalls(0);
+		ASSERT_EQ(eventBus.add("shmText", [&textsMtx, &texts](std::string text) {
+			std::lock_guard<std::mutex> lk(textsMtx);
+			texts.push_back(text); }), 1);
+		ASSERT_EQ(eventBus.add("shmNoArgs", [&noArgsCalls]() { ++noArgsCalls; }), 1);
+		ASSERT_EQ(eventBus.add("shmInt", [](int) {}), 1);
+		// received calls of durable ids are journaled
+		const std::string directory("testShmJournal");
+		eventHandling::Journal::remove(directory);
+		ASSERT_EQ(eventBus.setDurable("shmNoArgs"), true);
+		ASSERT_EQ(eventBus.openJournal(directory), true);
+		// the receiver waits for queue space, the ring holds the backlog
+		eventBus.setOverflowPolicy(eventHandling::OverflowPolicy::block, std::chrono::milliseconds(5000));
+		eventHandling::ShmPublisher publisher;
+		ASSERT_EQ(publisher.open(name), false);
+		ASSERT_EQ(eventBus.attachShmTransport(name, 1 << 16), true);
+		ASSERT_EQ(eventBus.start(), true);
+		ASSERT_EQ(publisher.open(name), true);
+		int published = 0;
+		for (int i = 0; i < 500; ++i)
+		{
+			while (!publisher.publish("shmText", "text" + std::to_string(i)))
+			{
+				std::this_thread::yield();
+			}
+			++published;
+			if (i % 5 == 0)
+			{
+				ASSERT_EQ(publisher.publish("shmNoArgs"), true);
+			}
+		}
+		// unknown ids and other arguments are dropped by the bus
+		ASSERT_EQ(publisher.publish("shmUnknown", "text"), true);
+		ASSERT_EQ(publisher.publish("shmInt", "text"), true);
+		for (int i = 0; i < 5000 && eventBus.getShmTransportStats().m_receivedCount < 602; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		// the drain includes everything received
+		eventHandling::ShutdownResult result = eventBus.shutdown(std::chrono::milliseconds(5000),
+			eventHandling::ShutdownMode::drain);
+		ASSERT_EQ(result.m_drained, true);
+		eventHandling::ShmTransportStats stats = eventBus.getShmTransportStats();
+		ASSERT_EQ(stats.m_receivedCount, 602);
+		ASSERT_EQ(stats.m_droppedCount, 2);
+		ASSERT_EQ(static_cast<int>(texts.size()), published);
+		ASSERT_EQ(texts.front(), "text0");
+		ASSERT_EQ(texts.back(), "text499");
+		ASSERT_EQ(noArgsCalls.load(), 100);
+		ASSERT_EQ(eventBus.getJournalStats().m_appendedCount, 100);
+		ASSERT_EQ(eventBus.getJournalStats().m_completedCount, 100);
+		eventBus.closeJournal();
+		ASSERT_EQ(eventHandling::Journal::remove(directory), true);
+		// detached by shutdown
+		eventHandling::ShmPublisher latePublisher;
+		ASSERT_EQ(latePublisher.open(name), false);
+	}
+
+	// subscribers change while several workers dispatch the same topic
+	TEST(EventBus, SubscribeDuringDispatch)
+	{
+		eventHandling::EventBus eventBus(1000, 4);
+		std::atomic<int> callCount(0);
+		std::function<void(int)> count = [&callCount](int i) { callCount += i; };
+		ASSERT_EQ(eventBus.add("ticks", count), 1);
+		ASSERT_EQ(eventBus.setOrdered("ticks", false), true);
+		std::thread busThread(&eventHandling::EventBus::run, &eventBus);
+		std::atomic<bool> done(false);
+		std::thread subscriber([&eventBus, &count, &done]() {
+			while (!done)
+			{
+				eventBus.add("ticks", count);
+				eventBus.add("ticks", count);
+				eventBus.remove("ticks");
+				eventBus.add("ticks", count);
+			}
+		});
+		int invoked = 0;
+		for (int i = 0; i < 20000; ++i)
+		{
+			if (eventBus.invoke("ticks", 1))
+			{
+				++invoked;
+			}
+		}
+		done = true;
+		subscriber.join();
+		for (int i = 0; i < 100 && eventBus.getCallsCount() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		eventBus.stop();
+		busThread.join();
+		ASSERT_GT(invoked, 0);
+		ASSERT_GT(callCount.load(), 0);
+		ASSERT_GE(eventBus.remove("ticks"), 1);
+		ASSERT_EQ(eventBus.invokeChecked("ticks", 1), eventHandling::InvokeResult::invalid);
+		ASSERT_EQ(eventBus.remove("missing"), -1);
+	}
 /*
 add("email", executeMe) //then
 invoke("email") I would expect executeMe to be called once.
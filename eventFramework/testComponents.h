@@ -6,10 +6,13 @@
 
 #include <iostream>
 #include <type_traits>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <stdexcept>
 #include <condition_variable>
+#include <vector>
+#include <tuple>
 
 #include <gtest/gtest.h>
 
@@ -132,6 +135,58 @@ namespace testCom
 		testCall.setBlockState();
 		ASSERT_EQ(testCall.getRunState() == eventHandling::RunState::blocked, true);
 	}
+	// typed arguments, no container and no RTTI
+	TEST(EventHandler, TypedDispatch)
+	{
+		eventHandling::EventHandler testHandler(iFunctionName1);
+		int received = 0;
+		std::shared_ptr <eventHandling::Event<int>> eventObjectPtr(
+			new eventHandling::Event<int>("typed"));
+		eventObjectPtr->setCallback([&received](int i) { received += i; });
+		ASSERT_EQ(testHandler.addEvent(eventObjectPtr), true);
+		ASSERT_EQ(testHandler.acceptsArguments<int>(), true);
+		ASSERT_EQ(testHandler.acceptsArguments<std::string>(), false);
+		std::shared_ptr <eventHandling::Event<std::string>> otherEventPtr(
+			new eventHandling::Event<std::string>("other"));
+		otherEventPtr->setCallback(executeMeEmpty);
+		ASSERT_EQ(testHandler.addEvent(otherEventPtr), false);
+		std::tuple<int> arguments(5);
+		ASSERT_EQ(testHandler.dispatchCalls(arguments), 1);
+		ASSERT_EQ(received, 5);
+		std::tuple<std::string> wrongArguments(s);
+		ASSERT_EQ(testHandler.dispatchCalls(wrongArguments), -1);
+		ASSERT_EQ(received, 5);
+	}
+
+	// packed subscribers, blocked ones are skipped without touching their event
+	TEST(EventHandler, SubscriberTable)
+	{
+		eventHandling::EventHandler testHandler(iFunctionName1);
+		std::vector<int> received;
+		std::vector<std::shared_ptr<eventHandling::Event<int>>> eventPtrs;
+		for (int i = 0; i < 3; ++i)
+		{
+			eventPtrs.emplace_back(new eventHandling::Event<int>("packed"));
+			eventPtrs.back()->setCallback([&received, i](int value) { received.push_back(i * value); });
+		}
+		eventPtrs[1]->setCallback(std::function<void(int)>());
+		for (auto & eventPtr : eventPtrs)
+		{
+			ASSERT_EQ(testHandler.addEvent(eventPtr), true);
+		}
+		std::tuple<int> arguments(10);
+		ASSERT_EQ(testHandler.dispatchCalls(arguments), 2);
+		ASSERT_EQ(received, std::vector<int>({ 0, 20 }));
+		ASSERT_EQ(testHandler.removeEvent(eventPtrs[0]), true);
+		ASSERT_EQ(testHandler.removeEvent(eventPtrs[0]), false);
+		received.clear();
+		ASSERT_EQ(testHandler.dispatchCalls(arguments), 1);
+		ASSERT_EQ(received, std::vector<int>({ 20 }));
+		ASSERT_EQ(testHandler.removeAllEvents(), 2);
+		ASSERT_EQ(testHandler.isValid(), false);
+		ASSERT_EQ(testHandler.dispatchCalls(arguments), 0);
+	}
+
 	/*
 	add("email", executeMe) //then
 	invoke("email") I would expect executeMe to be called once.
@@ -157,6 +212,520 @@ namespace testCom
 		ASSERT_EQ(q.empty(), false);
 	}
 
+	TEST(RingQueue, Basic)
+	{
+		eventHandling::RingQueue<int> q(3);
+		ASSERT_EQ(q.capacity(), 4);
+		ASSERT_EQ(q.empty(), true);
+		for (int i = 0; i < 4; ++i)
+		{
+			int value = i;
+			ASSERT_EQ(q.tryPush(std::move(value)), true);
+		}
+		int full = 4;
+		ASSERT_EQ(q.tryPush(std::move(full)), false);
+		ASSERT_EQ(q.size(), 4);
+		int value = -1;
+		ASSERT_EQ(q.tryPop(value), true);
+		ASSERT_EQ(value, 0);
+		ASSERT_EQ(q.size(), 3);
+	}
+
+	TEST(RingQueue, MultiProducer)
+	{
+		const int producerCount = 4, perProducer = 1000;
+		eventHandling::RingQueue<int> q(64);
+		std::vector<std::thread> producers;
+		for (int p = 0; p < producerCount; ++p)
+		{
+			producers.emplace_back([&q] {
+				for (int i = 1; i <= perProducer; ++i)
+				{
+					int value = i;
+					while (!q.tryPush(std::move(value)))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		long long sum = 0;
+		int received = 0, value = 0;
+		while (received < producerCount * perProducer)
+		{
+			if (q.pop(value, [] { return false; }))
+			{
+				sum += value;
+				++received;
+			}
+		}
+		for (auto & producer : producers)
+		{
+			producer.join();
+		}
+		ASSERT_EQ(sum, producerCount * (perProducer * (perProducer + 1LL) / 2));
+		ASSERT_EQ(q.empty(), true);
+	}
+
+	TEST(SpinParker, Strategies)
+	{
+		const eventHandling::WaitStrategy strategies[] = { eventHandling::WaitStrategy::busySpin,
+			eventHandling::WaitStrategy::spinYield, eventHandling::WaitStrategy::spinPark,
+			eventHandling::WaitStrategy::blocking };
+		for (eventHandling::WaitStrategy strategy : strategies)
+		{
+			eventHandling::SpinParker parker;
+			parker.setStrategy(strategy, 16);
+			ASSERT_EQ(parker.getStrategy(), strategy);
+			std::atomic<bool> ready(false);
+			ASSERT_EQ(parker.wait([&ready] { return ready.load(); }, std::chrono::milliseconds(2)), false);
+			bool res = false;
+			std::thread consumer([&parker, &ready, &res] {
+				res = parker.wait([&ready] { return ready.load(); }, std::chrono::milliseconds(5000)); });
+			const bool parks = strategy == eventHandling::WaitStrategy::spinPark ||
+				strategy == eventHandling::WaitStrategy::blocking;
+			for (int i = 0; parks && !parker.isParked() && i < 1000; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			ASSERT_EQ(parker.isParked(), parks);
+			auto start = std::chrono::steady_clock::now();
+			ready = true;
+			parker.notify();
+			consumer.join();
+			ASSERT_EQ(res, true);
+			ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+			ASSERT_EQ(parker.isParked(), false);
+		}
+	}
+
+	TEST(Journal, Basic)
+	{
+		const std::string directory("testJournal");
+		eventHandling::Journal::remove(directory);
+		eventHandling::JournalOptions options;
+		options.m_segmentSize = 4096;
+		options.m_syncInterval = std::chrono::microseconds(0);
+		{
+			eventHandling::Journal journal;
+			ASSERT_EQ(journal.open(directory, options), true);
+			const std::string argument(100, 'a');
+			for (uint64_t i = 1; i <= 100; ++i)
+			{
+				ASSERT_EQ(journal.append(iFunctionName1, argument.data(), argument.size()), i);
+			}
+			// does not fit into a segment
+			const std::string tooLarge(5000, 'b');
+			ASSERT_EQ(journal.append(iFunctionName1, tooLarge.data(), tooLarge.size()), 0u);
+			eventHandling::JournalStats stats = journal.getStats();
+			ASSERT_EQ(stats.m_appendedCount, 100);
+			ASSERT_EQ(stats.m_errorCount, 1);
+			ASSERT_EQ(stats.m_nextSequence, 101u);
+			ASSERT_GT(stats.m_segmentCount, 1);
+			ASSERT_GT(stats.m_syncCount, 0);
+			// the checkpoint stops at the first record which is not complete
+			for (uint64_t i = 1; i <= 100; ++i)
+			{
+				if (i != 60)
+				{
+					journal.complete(i);
+				}
+			}
+			journal.flush();
+			stats = journal.getStats();
+			ASSERT_EQ(stats.m_completedCount, 99);
+			ASSERT_EQ(stats.m_checkpointSequence, 60u);
+			ASSERT_LT(stats.m_segmentCount, 4);
+		}
+		{
+			// record 60 and the ones after it are pending after a restart
+			eventHandling::Journal journal;
+			ASSERT_EQ(journal.open(directory, options), true);
+			eventHandling::JournalStats stats = journal.getStats();
+			ASSERT_EQ(stats.m_checkpointSequence, 60u);
+			ASSERT_EQ(stats.m_nextSequence, 101u);
+			ASSERT_EQ(journal.append(iFunctionName2, nullptr, 0), 101u);
+			for (uint64_t i = 60; i <= 101; ++i)
+			{
+				journal.complete(i);
+			}
+			journal.flush();
+			stats = journal.getStats();
+			ASSERT_EQ(stats.m_checkpointSequence, 102u);
+			ASSERT_EQ(stats.m_segmentCount, 1);
+		}
+		ASSERT_EQ(eventHandling::Journal::remove(directory), true);
+		ASSERT_EQ(eventHandling::MappedFile::exists(directory + "/checkpoint"), false);
+
+		// a torn record ends the scan
+		char segment[256] = {};
+		std::vector<std::string> names;
+		bool corrupt = false;
+		ASSERT_EQ(eventHandling::scanJournalSegment(segment, sizeof(segment),
+			[&names](const eventHandling::JournalRecordView & record) {
+			names.emplace_back(record.m_namePtr, record.m_nameSize); }, corrupt), 0u);
+		ASSERT_EQ(corrupt, false);
+		segment[0] = 40;
+		eventHandling::scanJournalSegment(segment, sizeof(segment),
+			[&names](const eventHandling::JournalRecordView & record) {
+			names.emplace_back(record.m_namePtr, record.m_nameSize); }, corrupt);
+		ASSERT_EQ(corrupt, true);
+		ASSERT_EQ(names.empty(), true);
+	}
+
+	TEST(ShmRing, PublishConsume)
+	{
+		const std::string name("eventBusTestRing");
+		eventHandling::ShmRing consumer;
+		ASSERT_EQ(consumer.create(name, 1000), true);
+		ASSERT_EQ(consumer.getCapacity(), 4096u);
+		eventHandling::ShmRing publisher;
+		ASSERT_EQ(publisher.open("eventBusMissingRing"), false);
+		ASSERT_EQ(publisher.open(name), true);
+		ASSERT_EQ(consumer.hasFrame(), false);
+		ASSERT_EQ(consumer.waitForFrame(std::chrono::milliseconds(2), 16), false);
+		// larger than half of the ring
+		const std::string tooLarge(3000, 'x');
+		ASSERT_EQ(publisher.publish(iFunctionName1, tooLarge.data(), tooLarge.size()), false);
+
+		// frames of several sizes wrap around the ring many times
+		std::vector<std::string> received;
+		auto onFrame = [&received](const eventHandling::ShmFrameView & frame) {
+			received.emplace_back(frame.m_argumentPtr, frame.m_argumentSize); };
+		int published = 0;
+		for (int round = 0; round < 200; ++round)
+		{
+			const std::string argument(static_cast<size_t>(round * 7 % 300), char('a' + round % 26));
+			ASSERT_EQ(publisher.publish(iFunctionName1, argument.data(), argument.size()), true);
+			++published;
+			if (round % 3 == 0)
+			{
+				consumer.consume(onFrame, 100);
+			}
+		}
+		consumer.consume(onFrame, 1000);
+		ASSERT_EQ(static_cast<int>(received.size()), published);
+		for (int round = 0; round < 200; ++round)
+		{
+			ASSERT_EQ(received[round], std::string(static_cast<size_t>(round * 7 % 300),
+				char('a' + round % 26)));
+		}
+
+		// a full ring rejects frames until the consumer made space
+		const std::string argument(200, 'f');
+		int accepted = 0;
+		while (publisher.publish(iFunctionName2, argument.data(), argument.size()))
+		{
+			++accepted;
+		}
+		ASSERT_GT(accepted, 10);
+		ASSERT_EQ(consumer.getFullCount(), 1);
+		received.clear();
+		ASSERT_EQ(consumer.consume(onFrame, 1), 1u);
+		ASSERT_EQ(publisher.publish(iFunctionName2, argument.data(), argument.size()), true);
+		ASSERT_EQ(static_cast<int>(consumer.consume(onFrame, 1000)), accepted);
+
+		// a publisher wakes the parked consumer
+		bool woken = false;
+		std::thread waiter([&consumer, &woken] {
+			woken = consumer.waitForFrame(std::chrono::milliseconds(5000), 0); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_EQ(publisher.publish(iFunctionName1, nullptr, 0, eventHandling::g_shmFlagNoArgument), true);
+		waiter.join();
+		ASSERT_EQ(woken, true);
+		ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+		received.clear();
+		eventHandling::ShmFrameView lastFrame = {};
+		ASSERT_EQ(consumer.consume([&lastFrame](const eventHandling::ShmFrameView & frame) {
+			lastFrame = frame; }, 10), 1u);
+		ASSERT_EQ(lastFrame.m_flags, eventHandling::g_shmFlagNoArgument);
+		ASSERT_EQ(lastFrame.m_nameSize, iFunctionName1.size());
+
+		// the consumer removes the name, open mappings stay valid
+		consumer.close();
+		ASSERT_EQ(publisher.isOpen(), true);
+		eventHandling::ShmRing late;
+		ASSERT_EQ(late.open(name), false);
+	}
+
+	struct CopyCounter
+	{
+		static int s_copies;
+		CopyCounter() {}
+		CopyCounter(const CopyCounter &) { ++s_copies; }
+		CopyCounter(CopyCounter &&) {}
+		CopyCounter & operator = (const CopyCounter &) { ++s_copies; return *this; }
+		CopyCounter & operator = (CopyCounter &&) { return *this; }
+	};
+	int CopyCounter::s_copies = 0;
+
+	// reference subscribers share the stored argument, the last one may take it
+	TEST(EventHandler, FanOutCopies)
+	{
+		eventHandling::EventHandler testHandler(iFunctionName1);
+		std::function<void(const CopyCounter&)> byReference = [](const CopyCounter &) {};
+		std::function<void(CopyCounter)> byValue = [](CopyCounter) {};
+		for (int i = 0; i < 3; ++i)
+		{
+			std::shared_ptr <eventHandling::Event<CopyCounter>> eventObjectPtr(
+				new eventHandling::Event<CopyCounter>("fanOut"));
+			if (i < 2)
+			{
+				eventObjectPtr->setCallback(byReference);
+			}
+			else
+			{
+				eventObjectPtr->setCallback(byValue);
+			}
+			ASSERT_EQ(testHandler.addEvent(eventObjectPtr), true);
+		}
+		std::tuple<CopyCounter> arguments;
+		CopyCounter::s_copies = 0;
+		ASSERT_EQ(testHandler.dispatchCalls(arguments), 3);
+		ASSERT_EQ(CopyCounter::s_copies, 0);
+
+		// move-only arguments go to a single subscriber
+		eventHandling::EventHandler moveHandler(iFunctionName2);
+		int received = 0;
+		std::function<void(std::unique_ptr<int>)> take = [&received](std::unique_ptr<int> p) {
+			received = *p; };
+		std::shared_ptr <eventHandling::Event<std::unique_ptr<int>>> firstPtr(
+			new eventHandling::Event<std::unique_ptr<int>>("move"));
+		std::shared_ptr <eventHandling::Event<std::unique_ptr<int>>> secondPtr(
+			new eventHandling::Event<std::unique_ptr<int>>("move"));
+		firstPtr->setCallback(take);
+		secondPtr->setCallback(take);
+		ASSERT_EQ(moveHandler.addEvent(firstPtr), true);
+		ASSERT_EQ(moveHandler.addEvent(secondPtr), false);
+		std::tuple<std::unique_ptr<int>> moveArguments(std::unique_ptr<int>(new int(7)));
+		ASSERT_EQ(moveHandler.dispatchCalls(moveArguments), 1);
+		ASSERT_EQ(received, 7);
+		ASSERT_EQ(std::get<0>(moveArguments).get() == nullptr, true);
+	}
+
+	TEST(EventCallPool, Reuse)
+	{
+		eventHandling::EventCallPool pool;
+		eventHandling::EventCall * firstPtr = nullptr;
+		{
+			eventHandling::EventCallPtr evCallPtr = pool.acquire();
+			firstPtr = evCallPtr.get();
+			evCallPtr->emplaceArguments<std::string>(s);
+		}
+		eventHandling::EventCallPtr evCallPtr = pool.acquire();
+		ASSERT_EQ(evCallPtr.get(), firstPtr);
+		ASSERT_EQ(evCallPtr->getArgument().get() == nullptr, true);
+		ASSERT_EQ(evCallPtr->isValid(), false);
+		eventHandling::AllocationStats stats = pool.getStats();
+		ASSERT_EQ(stats.m_eventCallAllocations, 1);
+		ASSERT_EQ(stats.m_eventCallReuses, 1);
+		ASSERT_EQ(stats.m_argumentAllocations, 0);
+	}
+
+	TEST(TopicTable, Basic)
+	{
+		eventHandling::TopicTable<int> table;
+		int made = 0;
+		auto make = [&made]() { return std::make_shared<int>(++made); };
+		ASSERT_EQ(table.find("a").isValid(), false);
+		eventHandling::TopicId a = table.intern("a", make);
+		eventHandling::TopicId b = table.intern("b", make);
+		ASSERT_EQ(a.isValid() && b.isValid() && a != b, true);
+		ASSERT_EQ(table.intern("a", make) == a, true);
+		ASSERT_EQ(table.find("b") == b, true);
+		ASSERT_EQ(made, 2);
+		ASSERT_EQ(table.size(), 2);
+		ASSERT_EQ(*table.get(b), 2);
+		ASSERT_EQ(table.get(eventHandling::TopicId()).get() == nullptr, true);
+		ASSERT_EQ(table.get(eventHandling::TopicId(5)).get() == nullptr, true);
+		// more topics than one chunk
+		for (int i = 0; i < 600; ++i)
+		{
+			table.intern("t" + std::to_string(i), make);
+		}
+		ASSERT_EQ(*table.get(table.find("t599")), 602);
+	}
+
+	// timers fire in deadline order across all levels, cancel and repeat keep working
+	TEST(TimerWheel, Basic)
+	{
+		eventHandling::TimerWheel<uint64_t> wheel(10);
+		std::vector<uint64_t> fired;
+		auto record = [&fired](uint64_t & value, uint64_t &) {
+			fired.push_back(value);
+			return false; };
+		const uint64_t deadlines[] = { 5, 10, 11, 300, 70000, 20000000, uint64_t(1) << 40 };
+		std::vector<eventHandling::TimerId> ids;
+		for (uint64_t deadline : deadlines)
+		{
+			ids.push_back(wheel.schedule(deadline, deadline));
+		}
+		ASSERT_EQ(wheel.size(), 7u);
+		ASSERT_EQ(wheel.nextExpiry(), 10u);
+		wheel.advance(10, record);
+		ASSERT_EQ(fired, std::vector<uint64_t>({ 10, 5 }));
+		ASSERT_EQ(wheel.cancel(ids[0]), false);
+		ASSERT_EQ(wheel.cancel(ids[3]), true);
+		ASSERT_EQ(wheel.cancel(ids[3]), false);
+		wheel.advance(69999, record);
+		ASSERT_EQ(fired.back(), 11u);
+		wheel.advance(70000, record);
+		ASSERT_EQ(fired.back(), 70000u);
+		wheel.advance(uint64_t(1) << 41, record);
+		ASSERT_EQ(fired, std::vector<uint64_t>({ 10, 5, 11, 70000, 20000000, uint64_t(1) << 40 }));
+		ASSERT_EQ(wheel.empty(), true);
+
+		// entries are reused, stale ids do not cancel the new timer
+		eventHandling::TimerId reused = wheel.schedule(wheel.now() + 1, 1);
+		ASSERT_EQ(reused.getIndex() >= 0 && reused.getIndex() < 7, true);
+		ASSERT_EQ(wheel.cancel(ids[reused.getIndex()]), false);
+		ASSERT_EQ(wheel.cancel(reused), true);
+
+		// a periodic timer keeps its id
+		int repeats = 0;
+		eventHandling::TimerId periodic = wheel.schedule(wheel.now() + 100, 0);
+		const uint64_t start = wheel.now();
+		for (uint64_t now = start; now < start + 1000; now += 7)
+		{
+			wheel.advance(now, [&repeats](uint64_t &, uint64_t & deadline) {
+				++repeats;
+				deadline += 100;
+				return true; });
+		}
+		ASSERT_GE(repeats, 9);
+		ASSERT_EQ(wheel.cancel(periodic), true);
+		ASSERT_EQ(wheel.empty(), true);
+
+		// many timers without a thread per timer
+		const int timerCount = 200000;
+		for (int i = 0; i < timerCount; ++i)
+		{
+			wheel.schedule(wheel.now() + static_cast<uint64_t>(i % 5000), i);
+		}
+		size_t expired = 0;
+		wheel.advance(wheel.now() + 5000, [&expired](uint64_t &, uint64_t &) {
+			++expired;
+			return false; });
+		ASSERT_EQ(expired, static_cast<size_t>(timerCount));
+	}
+
+	TEST(InlineFunction, Basic)
+	{
+		typedef eventHandling::InlineFunction<int(int)> Function;
+		// the target is stored in place
+		ASSERT_LE(sizeof(Function), eventHandling::g_inlineCallbackSize + 2 * sizeof(void*));
+		Function empty;
+		ASSERT_EQ(static_cast<bool>(empty), false);
+		int offsets[4] = { 1, 2, 3, 4 };
+		Function add([offsets](int i) { return i + offsets[3]; });
+		ASSERT_EQ(static_cast<bool>(add), true);
+		ASSERT_EQ(add(1), 5);
+		Function copy = add.clone();
+		Function moved(std::move(add));
+		ASSERT_EQ(static_cast<bool>(add), false);
+		ASSERT_EQ(moved(2), 6);
+		ASSERT_EQ(copy(3), 7);
+		// move-only targets can be moved but not cloned
+		std::unique_ptr<int> factorPtr(new int(3));
+		Function multiply([factorPtr = std::move(factorPtr)](int i) { return i * *factorPtr; });
+		moved = std::move(multiply);
+		ASSERT_EQ(moved(2), 6);
+		ASSERT_THROW(moved.clone(), std::logic_error);
+		moved = nullptr;
+		ASSERT_EQ(static_cast<bool>(moved), false);
+		Function pointer(static_cast<int(*)(int)>([](int i) { return -i; }));
+		ASSERT_EQ(pointer(4), -4);
+	}
+
+	TEST(SnapshotList, Basic)
+	{
+		eventHandling::SnapshotList<int> list;
+		ASSERT_EQ(list.empty(), true);
+		list.push_back(1);
+		list.push_back(2);
+		{
+			eventHandling::SnapshotList<int>::ReadView view(list);
+			ASSERT_EQ(view.size(), 2);
+			ASSERT_EQ(list.update([](std::vector<int> & values) {
+				values.push_back(3);
+				return true; }), true);
+			// the view keeps its snapshot, the replaced one waits for it
+			ASSERT_EQ(view.size(), 2);
+			ASSERT_EQ(view[1], 2);
+			ASSERT_GE(eventHandling::EpochDomain::instance().reclaim(), 1);
+			// nested read section of the same thread
+			ASSERT_EQ(list.size(), 3);
+		}
+		for (int i = 0; i < 100 && eventHandling::EpochDomain::instance().reclaim() > 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		ASSERT_EQ(eventHandling::EpochDomain::instance().reclaim(), 0);
+		ASSERT_EQ(list.update([](std::vector<int> &) { return false; }), false);
+		ASSERT_EQ(list.update([](std::vector<int> & values) {
+			values.clear();
+			return true; }), true);
+		ASSERT_EQ(list.empty(), true);
+	}
+
+	TEST(LatencyHistogram, Basic)
+	{
+		eventHandling::LatencyHistogram histogram;
+		eventHandling::LatencyStats stats = histogram.getStats();
+		ASSERT_EQ(stats.m_count, 0);
+		ASSERT_EQ(stats.m_p50, 0);
+		for (long long i = 1; i <= 1000; ++i)
+		{
+			histogram.record(i * 1000);
+		}
+		histogram.record(-5); // counted as 0
+		stats = histogram.getStats();
+		ASSERT_EQ(stats.m_count, 1001);
+		ASSERT_EQ(stats.m_max, 1000000);
+		// within the bucket precision of 1/32
+		ASSERT_GE(stats.m_p50, 500000);
+		ASSERT_LE(stats.m_p50, 500000 + 500000 / 32);
+		ASSERT_GE(stats.m_p99, 990000);
+		ASSERT_LE(stats.m_p99, 990000 + 990000 / 32);
+		ASSERT_GE(stats.m_p999, 999000);
+		ASSERT_LE(stats.m_p999, 1000000);
+		ASSERT_EQ(stats.m_meanNanoseconds, 500500000 / 1001);
+		// small values are exact, huge ones share the top bucket
+		histogram.reset();
+		histogram.record(7);
+		ASSERT_EQ(histogram.getStats().m_p50, 7);
+		histogram.record(1LL << 50);
+		ASSERT_EQ(histogram.getStats().m_max, 1LL << 50);
+		ASSERT_EQ(histogram.getCount(), 2);
+	}
+
+	TEST(EventLog, Basic)
+	{
+		eventHandling::EventLog & log = eventHandling::EventLog::instance();
+		std::ostringstream output;
+		log.setOutput(output);
+		long long written = log.getWrittenCount();
+		int verbose = 1;
+		EVENT_LOG_INFO(verbose, "info " << 1);
+		EVENT_LOG_DEBUG(verbose, "debug " << 2);
+		EVENT_LOG_INFO(0, "quiet");
+		EVENT_LOG_ERROR("error " << std::string(1000, 'x'));
+		log.flush();
+		log.setOutput(std::cout);
+		const std::string text = output.str();
+#if EVENT_LOG_LEVEL >= 3
+		ASSERT_EQ(log.getWrittenCount() - written, 2);
+		ASSERT_NE(text.find(" info "), std::string::npos);
+		ASSERT_NE(text.find("info 1\n"), std::string::npos);
+		ASSERT_EQ(text.find("debug 2"), std::string::npos);
+		ASSERT_EQ(text.find("quiet"), std::string::npos);
+		// cut to the record size
+		ASSERT_NE(text.find(" error "), std::string::npos);
+		ASSERT_LT(text.size(), 2 * eventHandling::g_logRecordSize);
+#endif
+	}
+
 	TEST(MapWrapper, Basic)
 	{
 		UnordMapWrapper <std::string, int> map;
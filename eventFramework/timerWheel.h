@@ -0,0 +1,384 @@
+/// @file timerWheel.h
+/// This file contains a hierarchical timer wheel for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace eventHandling
+{
+	/// slots per level are 2^g_wheelBits, g_wheelLevels levels cover 2^32 ticks
+	static const int g_wheelBits = 8;
+	static const int g_wheelLevels = 4;
+	static const size_t g_wheelSlots = size_t(1) << g_wheelBits;
+	static const uint64_t g_wheelMask = g_wheelSlots - 1;
+
+	/// @brief Handle of a scheduled timer, stays valid while the timer repeats
+	/// @details the generation tells a cancelled or fired timer from a new timer
+	///          reusing its entry, so stale handles are safe to cancel
+	class TimerId
+	{
+		int m_index;
+		unsigned m_generation;
+	public:
+		explicit TimerId(int index = -1, unsigned generation = 0) : m_index(index),
+			m_generation(generation) {}
+		int getIndex() const
+		{
+			return m_index;
+		}
+		unsigned getGeneration() const
+		{
+			return m_generation;
+		}
+		bool isValid() const
+		{
+			return m_index >= 0;
+		}
+		bool operator == (const TimerId & other) const
+		{
+			return m_index == other.m_index && m_generation == other.m_generation;
+		}
+		bool operator != (const TimerId & other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/// @brief Hierarchical hashed timer wheel
+	/// @details Timers live in a slab of entries linked into the slots of
+	///          g_wheelLevels wheels of g_wheelSlots slots each, level n counts
+	///          2^(n*g_wheelBits) ticks per slot. schedule() and cancel() are O(1),
+	///          advance() touches every level 0 slot with timers once and moves the
+	///          timers of a higher level slot down when the lower wheel wraps.
+	///          Time is counted in ticks chosen by the owner. Not thread safe.
+	template<class T>
+	class TimerWheel
+	{
+	private:
+		struct Entry
+		{
+			T m_value;
+			uint64_t m_deadline;
+			int m_prev, m_next;
+			int m_slot; // index into m_heads, -1 while free
+			unsigned m_generation;
+		};
+		std::vector<Entry> m_entries;
+		int m_freeHead;
+		int m_heads[g_wheelLevels * g_wheelSlots]; // -1 for empty slots
+		uint64_t m_occupied[g_wheelLevels][g_wheelSlots / 64]; // slots with timers
+		uint64_t m_now; // next tick to expire
+		size_t m_size;
+
+		static int lowestBit(uint64_t value);
+		void link(int index);
+		void unlink(int index);
+		void release(int index);
+		void setOccupied(int slot, bool occupied);
+		/// distance of the next slot with timers from position, -1 if there is none
+		int nextOccupied(int level, uint64_t position) const;
+		void cascade();
+		/// @brief next tick where a slot fires or moves down, empty ticks are skipped
+		uint64_t nextEventTick() const;
+	public:
+		explicit TimerWheel(uint64_t now = 0);
+		TimerWheel& operator = (TimerWheel&) = delete;
+
+		/// @brief add a timer, deadlines in the past expire on the next advance()
+		TimerId schedule(uint64_t deadline, T value);
+		/// @return false in case the timer already fired or was cancelled
+		bool cancel(TimerId timerId);
+		/// @brief expire all timers with a deadline up to now
+		/// @param expired bool(T & value, uint64_t & deadline), returning true
+		///        keeps the timer with the updated deadline, e.g. periodic timers.
+		///        It must not call schedule() or cancel().
+		template<class F>
+		void advance(uint64_t now, F expired);
+		/// @brief lower bound of the next deadline, max() if there are no timers
+		/// @details exact for timers in level 0, otherwise the tick where the next
+		///          higher level slot is moved down
+		uint64_t nextExpiry() const
+		{
+			return m_size == 0 ? std::numeric_limits<uint64_t>::max() : nextEventTick();
+		}
+		uint64_t now() const
+		{
+			return m_now;
+		}
+		size_t size() const
+		{
+			return m_size;
+		}
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+	};
+
+	template<class T>
+	TimerWheel<T>::TimerWheel(uint64_t now) : m_freeHead(-1), m_now(now), m_size(0)
+	{
+		std::fill(std::begin(m_heads), std::end(m_heads), -1);
+		for (auto & level : m_occupied)
+		{
+			std::fill(std::begin(level), std::end(level), 0);
+		}
+	}
+
+	template<class T>
+	int TimerWheel<T>::lowestBit(uint64_t value)
+	{
+		// de Bruijn sequence, value must not be 0
+		static const int table[64] = {
+			0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+			62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+			63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+			46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6 };
+		return table[((value & (~value + 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+	}
+
+	template<class T>
+	void TimerWheel<T>::link(int index)
+	{
+		Entry & entry = m_entries[index];
+		int level = 0;
+		uint64_t deadline = std::max(entry.m_deadline, m_now);
+		// lowest level whose rotation still reaches the deadline
+		while (level < g_wheelLevels - 1 &&
+			(deadline >> (g_wheelBits * level)) - (m_now >> (g_wheelBits * level)) >= g_wheelSlots)
+		{
+			++level;
+		}
+		uint64_t position = deadline >> (g_wheelBits * level);
+		uint64_t current = m_now >> (g_wheelBits * level);
+		if (position - current >= g_wheelSlots)
+		{
+			// beyond the top level, parked in its last slot and placed again later
+			position = current + g_wheelSlots - 1;
+		}
+		int slot = level * static_cast<int>(g_wheelSlots) + static_cast<int>(position & g_wheelMask);
+		entry.m_slot = slot;
+		entry.m_prev = -1;
+		entry.m_next = m_heads[slot];
+		if (entry.m_next >= 0)
+		{
+			m_entries[entry.m_next].m_prev = index;
+		}
+		m_heads[slot] = index;
+		setOccupied(slot, true);
+	}
+
+	template<class T>
+	void TimerWheel<T>::setOccupied(int slot, bool occupied)
+	{
+		size_t position = static_cast<size_t>(slot) % g_wheelSlots;
+		uint64_t & word = m_occupied[static_cast<size_t>(slot) / g_wheelSlots][position / 64];
+		if (occupied)
+		{
+			word |= uint64_t(1) << (position % 64);
+		}
+		else
+		{
+			word &= ~(uint64_t(1) << (position % 64));
+		}
+	}
+
+	template<class T>
+	int TimerWheel<T>::nextOccupied(int level, uint64_t position) const
+	{
+		size_t first = static_cast<size_t>(position & g_wheelMask);
+		// the words from first to the end, then the wrapped ones up to first
+		for (size_t i = 0; i <= g_wheelSlots / 64; ++i)
+		{
+			size_t word = (first / 64 + i) % (g_wheelSlots / 64);
+			uint64_t bits = m_occupied[level][word];
+			if (i == 0)
+			{
+				bits &= ~uint64_t(0) << (first % 64);
+			}
+			else if (i == g_wheelSlots / 64)
+			{
+				bits &= ~(~uint64_t(0) << (first % 64));
+			}
+			if (bits)
+			{
+				size_t slot = word * 64 + static_cast<size_t>(lowestBit(bits));
+				return static_cast<int>((slot + g_wheelSlots - first) % g_wheelSlots);
+			}
+		}
+		return -1;
+	}
+
+	template<class T>
+	void TimerWheel<T>::unlink(int index)
+	{
+		Entry & entry = m_entries[index];
+		if (entry.m_prev >= 0)
+		{
+			m_entries[entry.m_prev].m_next = entry.m_next;
+		}
+		else
+		{
+			m_heads[entry.m_slot] = entry.m_next;
+		}
+		if (entry.m_next >= 0)
+		{
+			m_entries[entry.m_next].m_prev = entry.m_prev;
+		}
+		if (m_heads[entry.m_slot] < 0)
+		{
+			setOccupied(entry.m_slot, false);
+		}
+	}
+
+	template<class T>
+	void TimerWheel<T>::release(int index)
+	{
+		Entry & entry = m_entries[index];
+		entry.m_value = T();
+		entry.m_slot = -1;
+		++entry.m_generation;
+		entry.m_next = m_freeHead;
+		m_freeHead = index;
+		--m_size;
+	}
+
+	template<class T>
+	void TimerWheel<T>::cascade()
+	{
+		for (int level = 1; level < g_wheelLevels; ++level)
+		{
+			uint64_t position = (m_now >> (g_wheelBits * level)) & g_wheelMask;
+			int slot = level * static_cast<int>(g_wheelSlots) + static_cast<int>(position);
+			int index = m_heads[slot];
+			m_heads[slot] = -1;
+			setOccupied(slot, false);
+			while (index >= 0)
+			{
+				int nextIndex = m_entries[index].m_next;
+				link(index);
+				index = nextIndex;
+			}
+			// the next level only wraps together with this one
+			if (position != 0)
+			{
+				break;
+			}
+		}
+	}
+
+	template<class T>
+	uint64_t TimerWheel<T>::nextEventTick() const
+	{
+		uint64_t res = std::numeric_limits<uint64_t>::max();
+		int distance = nextOccupied(0, m_now);
+		if (distance >= 0)
+		{
+			res = m_now + static_cast<uint64_t>(distance);
+		}
+		for (int level = 1; level < g_wheelLevels; ++level)
+		{
+			// the current slot of a higher level was moved down already
+			uint64_t position = m_now >> (g_wheelBits * level);
+			distance = nextOccupied(level, position + 1);
+			if (distance >= 0)
+			{
+				res = std::min(res, (position + 1 + static_cast<uint64_t>(distance)) <<
+					(g_wheelBits * level));
+			}
+		}
+		return res;
+	}
+
+	template<class T>
+	TimerId TimerWheel<T>::schedule(uint64_t deadline, T value)
+	{
+		int index = m_freeHead;
+		if (index >= 0)
+		{
+			m_freeHead = m_entries[index].m_next;
+		}
+		else
+		{
+			index = static_cast<int>(m_entries.size());
+			m_entries.push_back(Entry{ T(), 0, -1, -1, -1, 0 });
+		}
+		Entry & entry = m_entries[index];
+		entry.m_value = std::move(value);
+		entry.m_deadline = deadline;
+		link(index);
+		++m_size;
+		return TimerId(index, entry.m_generation);
+	}
+
+	template<class T>
+	bool TimerWheel<T>::cancel(TimerId timerId)
+	{
+		int index = timerId.getIndex();
+		if (index < 0 || index >= static_cast<int>(m_entries.size()) ||
+			m_entries[index].m_slot < 0 ||
+			m_entries[index].m_generation != timerId.getGeneration())
+		{
+			return false;
+		}
+		unlink(index);
+		release(index);
+		return true;
+	}
+
+	template<class T>
+	template<class F>
+	void TimerWheel<T>::advance(uint64_t now, F expired)
+	{
+		while (m_now <= now)
+		{
+			if (m_size == 0)
+			{
+				m_now = now + 1;
+				return;
+			}
+			// skip empty ticks up to the next timer or slot to move down
+			uint64_t next = std::min(nextEventTick(), now + 1);
+			if (next > m_now)
+			{
+				m_now = next;
+			}
+			else
+			{
+				size_t slot = static_cast<size_t>(m_now & g_wheelMask);
+				int index = m_heads[slot];
+				m_heads[slot] = -1;
+				setOccupied(static_cast<int>(slot), false);
+				while (index >= 0)
+				{
+					int nextIndex = m_entries[index].m_next;
+					uint64_t deadline = m_entries[index].m_deadline;
+					if (expired(m_entries[index].m_value, deadline))
+					{
+						m_entries[index].m_deadline = std::max(deadline, m_now + 1);
+						link(index);
+					}
+					else
+					{
+						release(index);
+					}
+					index = nextIndex;
+				}
+				++m_now;
+			}
+			if ((m_now & g_wheelMask) == 0)
+			{
+				cascade();
+			}
+		}
+	}
+}//namespace
+
+#endif
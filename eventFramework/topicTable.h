@@ -0,0 +1,155 @@
+/// @file topicTable.h
+/// This file contains the interned topic table for the Event system
+/// It is implemented using constructs from C++14 standard.
+#ifndef TOPIC_TABLE_H
+#define TOPIC_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace eventHandling
+{
+	/// entries per chunk and number of chunks, limits the number of topics
+	static const size_t g_topicChunkSize = 256;
+	static const size_t g_maxTopicChunks = 256;
+
+	/// @brief Handle of an interned callback id
+	/// @details Resolved once by EventBus::topic(), afterwards add() and invoke()
+	///          index the handler table directly, no hashing or string copies.
+	///          Only valid for the bus which returned it.
+	class TopicId
+	{
+		int m_index;
+	public:
+		explicit TopicId(int index = -1) : m_index(index) {}
+		int getIndex() const
+		{
+			return m_index;
+		}
+		bool isValid() const
+		{
+			return m_index >= 0;
+		}
+		bool operator == (const TopicId & other) const
+		{
+			return m_index == other.m_index;
+		}
+		bool operator != (const TopicId & other) const
+		{
+			return m_index != other.m_index;
+		}
+	};
+
+	/// @brief Dense table of values indexed by TopicId
+	/// @details Names are interned under a mutex, lookups by TopicId are lock free.
+	///          Values are stored in fixed size chunks which never move, an entry is
+	///          written once before the size is published and never removed.
+	template<class T>
+	class TopicTable
+	{
+	private:
+		struct Chunk
+		{
+			std::shared_ptr<T> m_entries[g_topicChunkSize];
+		};
+		mutable std::mutex m_dataMtx; //m_names, writers
+		std::unordered_map<std::string, int> m_names;
+		std::atomic<Chunk *> m_aChunks[g_maxTopicChunks];
+		std::atomic<int> m_aSize;
+		static const std::shared_ptr<T> & emptyEntry()
+		{
+			static const std::shared_ptr<T> empty;
+			return empty;
+		}
+	public:
+		TopicTable() : m_aSize(0)
+		{
+			for (auto & chunk : m_aChunks)
+			{
+				chunk.store(nullptr, std::memory_order_relaxed);
+			}
+		}
+		~TopicTable()
+		{
+			for (auto & chunk : m_aChunks)
+			{
+				delete chunk.load(std::memory_order_relaxed);
+			}
+		}
+		TopicTable& operator = (TopicTable&) = delete;
+
+		/// @brief TopicId of name, created with make() if it is not known yet
+		/// @return invalid TopicId in case the table is full
+		template<class Factory>
+		TopicId intern(const std::string & name, Factory make);
+		/// @return invalid TopicId in case name was never interned
+		TopicId find(const std::string & name) const;
+		/// @brief lock free lookup
+		/// @return empty pointer for invalid or unknown ids
+		const std::shared_ptr<T> & get(TopicId id) const;
+		int size() const
+		{
+			return m_aSize.load(std::memory_order_acquire);
+		}
+		bool empty() const
+		{
+			return size() == 0;
+		}
+	};
+
+	template<class T>
+	template<class Factory>
+	TopicId TopicTable<T>::intern(const std::string & name, Factory make)
+	{
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		auto it = m_names.find(name);
+		if (it != m_names.end())
+		{
+			return TopicId(it->second);
+		}
+		int index = m_aSize.load(std::memory_order_relaxed);
+		size_t chunkIndex = static_cast<size_t>(index) / g_topicChunkSize;
+		if (chunkIndex >= g_maxTopicChunks)
+		{
+			return TopicId();
+		}
+		Chunk * chunk = m_aChunks[chunkIndex].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new Chunk;
+			m_aChunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+		chunk->m_entries[static_cast<size_t>(index) % g_topicChunkSize] = make();
+		m_names.emplace(name, index);
+		// publishes the entry to lock free readers
+		m_aSize.store(index + 1, std::memory_order_release);
+		return TopicId(index);
+	}
+
+	template<class T>
+	TopicId TopicTable<T>::find(const std::string & name) const
+	{
+		std::lock_guard<std::mutex> lk(m_dataMtx);
+		auto it = m_names.find(name);
+		return it == m_names.end() ? TopicId() : TopicId(it->second);
+	}
+
+	template<class T>
+	const std::shared_ptr<T> & TopicTable<T>::get(TopicId id) const
+	{
+		int index = id.getIndex();
+		if (index < 0 || index >= m_aSize.load(std::memory_order_acquire))
+		{
+			return emptyEntry();
+		}
+		Chunk * chunk = m_aChunks[static_cast<size_t>(index) / g_topicChunkSize].load(
+			std::memory_order_acquire);
+		return chunk->m_entries[static_cast<size_t>(index) % g_topicChunkSize];
+	}
+}//namespace
+
+#endif